@@ -0,0 +1,111 @@
+#include "aleatoriedad.h"
+#include "binario.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+#include <botan/auto_rng.h>
+#include <botan/chacha_rng.h>
+#include <botan/hash.h>
+#include <botan/hmac_drbg.h>
+
+namespace pqbench {
+
+std::string nombre_fuente_rng(FuenteRNG fuente) {
+    switch(fuente) {
+        case FuenteRNG::AUTO: return "auto";
+        case FuenteRNG::CHACHA: return "chacha";
+        case FuenteRNG::HMAC_DRBG: return "hmac-drbg";
+    }
+    return "";
+}
+
+FuenteRNG leer_fuente_rng(const std::string& nombre) {
+    for(FuenteRNG fuente : {FuenteRNG::AUTO, FuenteRNG::CHACHA, FuenteRNG::HMAC_DRBG}) {
+        if(nombre == nombre_fuente_rng(fuente)) {
+            return fuente;
+        }
+    }
+    throw std::invalid_argument("Fuente de RNG desconocida: " + nombre + " (auto, chacha o hmac-drbg)");
+}
+
+// Cada hilo acumula lo suyo: las fases se miden en el hilo que las ejecuta
+static thread_local LecturaRNG acumulado;
+
+LecturaRNG lectura_rng() {
+    return acumulado;
+}
+
+LecturaRNG operator-(const LecturaRNG& a, const LecturaRNG& b) {
+    return {a.llamadas - b.llamadas, a.bytes - b.bytes, a.segundos - b.segundos};
+}
+
+void RNGMedido::fill_bytes_with_input(std::span<uint8_t> salida, std::span<const uint8_t> entrada) {
+    auto inicio = std::chrono::steady_clock::now();
+
+    // fill_bytes_with_input es protegida, así que se llega al RNG interno por su interfaz pública
+    if(!entrada.empty()) {
+        m_rng->add_entropy(entrada);
+    }
+    if(!salida.empty()) {
+        m_rng->randomize(salida);
+    }
+
+    acumulado.segundos += std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    acumulado.llamadas += 1;
+    acumulado.bytes += static_cast<double>(salida.size());
+}
+
+std::vector<uint8_t> material_semilla(const std::string& etiqueta, uint64_t semilla) {
+    std::vector<uint8_t> entrada(etiqueta.begin(), etiqueta.end());
+    poner_entero(entrada, semilla, 8);
+
+    auto sha512 = Botan::HashFunction::create_or_throw("SHA-512");
+    sha512->update(entrada);
+    auto resumen = sha512->final();
+    return std::vector<uint8_t>(resumen.begin(), resumen.end());
+}
+
+std::unique_ptr<Botan::RandomNumberGenerator> crear_rng_fuente(FuenteRNG fuente, uint64_t semilla) {
+    // Semilla distinta de la de la caché de claves para no generar las mismas claves
+    std::vector<uint8_t> material = material_semilla("pqbench-rng", semilla);
+
+    switch(fuente) {
+        case FuenteRNG::AUTO:
+            return std::make_unique<Botan::AutoSeeded_RNG>();
+        case FuenteRNG::CHACHA:
+            return std::make_unique<Botan::ChaCha_RNG>(material);
+        case FuenteRNG::HMAC_DRBG: {
+            auto rng = std::make_unique<Botan::HMAC_DRBG>("SHA-512");
+            rng->add_entropy(material);
+            return rng;
+        }
+    }
+    throw std::invalid_argument("Fuente de RNG desconocida");
+}
+
+std::unique_ptr<Botan::RandomNumberGenerator> crear_rng_medido(FuenteRNG fuente, uint64_t semilla) {
+    return std::make_unique<RNGMedido>(crear_rng_fuente(fuente, semilla));
+}
+
+void comprobar_fuente_rng(FuenteRNG fuente, uint64_t semilla) {
+    auto rng = crear_rng_fuente(fuente, semilla);
+    if(!rng->is_seeded()) {
+        throw std::runtime_error("El RNG " + nombre_fuente_rng(fuente) + " no está sembrado");
+    }
+
+    // Con 32 bytes a cero la probabilidad de un falso fallo es despreciable
+    std::vector<uint8_t> bytes(32);
+    try {
+        rng->randomize(bytes);
+    } catch(const std::exception& e) {
+        throw std::runtime_error("El RNG " + nombre_fuente_rng(fuente) + " no genera bytes: " + e.what());
+    }
+    if(std::all_of(bytes.begin(), bytes.end(), [](uint8_t b) { return b == 0; })) {
+        throw std::runtime_error("El RNG " + nombre_fuente_rng(fuente) + " sólo genera ceros");
+    }
+}
+
+} // namespace pqbench
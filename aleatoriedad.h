@@ -0,0 +1,80 @@
+#ifndef PQBENCH_ALEATORIEDAD_H
+#define PQBENCH_ALEATORIEDAD_H
+
+#include <botan/rng.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+Generadores de números aleatorios de las evaluaciones y contabilidad de su coste.
+
+Por defecto se usa AutoSeeded_RNG, que lee entropía del sistema al crearse y se vuelve
+a sembrar él solo, así que esas lecturas acaban dentro de los tiempos medidos y dos
+ejecuciones no dan las mismas claves. Se puede elegir también un ChaCha_RNG o un
+HMAC_DRBG(SHA-512) sembrados con una semilla fija, que no leen entropía del sistema y
+hacen reproducibles las claves.
+
+Todos se envuelven en RNGMedido, que cronometra cada llamada y la suma a un acumulado
+por hilo. medir() lo lee antes y después de cada fase, de modo que cada operación indica
+cuántas llamadas ha hecho al RNG, cuántos bytes ha sacado y cuánto tiempo ha pasado en él.
+*/
+
+namespace pqbench {
+
+enum class FuenteRNG { AUTO, CHACHA, HMAC_DRBG };
+
+// Nombre en la línea de comandos: auto, chacha, hmac-drbg
+std::string nombre_fuente_rng(FuenteRNG fuente);
+// Lanza std::invalid_argument si el nombre no corresponde a ninguna fuente
+FuenteRNG leer_fuente_rng(const std::string& nombre);
+
+// Uso del RNG por el hilo actual (acumulado) o por una fase (diferencia)
+struct LecturaRNG {
+    double llamadas = 0;
+    double bytes = 0;
+    double segundos = 0;
+};
+
+LecturaRNG lectura_rng();
+LecturaRNG operator-(const LecturaRNG& a, const LecturaRNG& b);
+
+// Envoltorio que cronometra cada llamada al RNG interno
+class RNGMedido final : public Botan::RandomNumberGenerator {
+public:
+    explicit RNGMedido(std::unique_ptr<Botan::RandomNumberGenerator> rng) : m_rng(std::move(rng)) {}
+
+    std::string name() const override { return m_rng->name(); }
+    bool accepts_input() const override { return m_rng->accepts_input(); }
+    bool is_seeded() const override { return m_rng->is_seeded(); }
+    void clear() override { m_rng->clear(); }
+
+private:
+    void fill_bytes_with_input(std::span<uint8_t> salida, std::span<const uint8_t> entrada) override;
+
+    std::unique_ptr<Botan::RandomNumberGenerator> m_rng;
+};
+
+/*
+Material de siembra de 64 bytes: SHA-512(etiqueta || semilla en 8 bytes). ChaCha_RNG y
+HMAC_DRBG sólo se dan por sembrados con al menos security_level() bits (256) de entrada,
+así que la etiqueta y la semilla tal cual no bastan.
+*/
+std::vector<uint8_t> material_semilla(const std::string& etiqueta, uint64_t semilla);
+
+// RNG de la fuente indicada; la semilla sólo se usa en las fuentes sembradas
+std::unique_ptr<Botan::RandomNumberGenerator> crear_rng_fuente(FuenteRNG fuente, uint64_t semilla);
+
+// Lo mismo envuelto en RNGMedido
+std::unique_ptr<Botan::RandomNumberGenerator> crear_rng_medido(FuenteRNG fuente, uint64_t semilla);
+
+/*
+Comprueba que la fuente está sembrada y produce bytes; lanza std::runtime_error si no.
+Se llama antes de medir para que un RNG mal sembrado no falle a mitad de una fase.
+*/
+void comprobar_fuente_rng(FuenteRNG fuente, uint64_t semilla);
+
+} // namespace pqbench
+
+#endif
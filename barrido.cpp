@@ -0,0 +1,212 @@
+#include "barrido.h"
+
+#include <iomanip>
+#include <random>
+#include <stdexcept>
+
+namespace pqbench {
+
+ResultadoBarrido barrer_tamanos(const Esquema& esquema, const std::vector<uint64_t>& tamanos,
+                                size_t bloque, const Opciones& opciones) {
+    auto rng_medido = crear_rng_medido(opciones.fuente_rng, opciones.semilla_rng);
+    Botan::RandomNumberGenerator& rng = *rng_medido;
+
+    ResultadoBarrido resultado;
+    resultado.conjunto = esquema.conjunto();
+
+    auto clave = esquema.generar_clave(rng);
+    auto pub_key = clave->public_key();
+    Botan::PK_Signer signer(*clave, rng, esquema.padding_firma(opciones.firma_determinista));
+    Botan::PK_Verifier verifier(*pub_key, esquema.padding_verificacion());
+
+    /*
+    El mensaje es un mismo bloque aleatorio repetido: el contenido no cambia el coste de
+    hashearlo y así el barrido no reserva el mensaje. Botan sí lo guarda entero en SLH-DSA
+    puro (ver barrido.h), por eso ahí los tamaños se limitan antes de llegar aquí.
+    */
+    std::vector<uint8_t> datos(bloque);
+    std::mt19937_64 aleatorio(0);
+    for(auto& b : datos) {
+        b = static_cast<uint8_t>(aleatorio());
+    }
+
+    auto pasar_mensaje = [&](auto& operacion, uint64_t bytes) {
+        for(uint64_t enviados = 0; enviados < bytes; enviados += bloque) {
+            operacion.update(datos.data(), static_cast<size_t>(std::min<uint64_t>(bloque, bytes - enviados)));
+        }
+    };
+
+    for(uint64_t bytes : tamanos) {
+        PuntoBarrido punto;
+        punto.bytes = bytes;
+
+        std::vector<uint8_t> signature;
+        punto.firma = muestrear(opciones, [&] {
+            pasar_mensaje(signer, bytes);
+            signature = signer.signature(rng);
+        });
+
+        bool valida = true;
+        punto.verificacion = muestrear(opciones, [&] {
+            pasar_mensaje(verifier, bytes);
+            valida = verifier.check_signature(signature.data(), signature.size()) && valida;
+        });
+        punto.verificada = valida;
+
+        resultado.puntos.push_back(std::move(punto));
+    }
+
+    return resultado;
+}
+
+uint64_t punto_equilibrio(const ResultadoBarrido& a, const ResultadoBarrido& b, bool firma) {
+    uint64_t desde = 0;
+
+    // Se recorre de mayor a menor tamaño hasta el primero en el que `a` deja de ganar
+    for(size_t i = std::min(a.puntos.size(), b.puntos.size()); i-- > 0;) {
+        const PuntoBarrido& pa = a.puntos[i];
+        const PuntoBarrido& pb = b.puntos[i];
+        double ta = (firma ? pa.firma : pa.verificacion).segundos.mediana;
+        double tb = (firma ? pb.firma : pb.verificacion).segundos.mediana;
+
+        if(pa.bytes != pb.bytes || ta >= tb) {
+            break;
+        }
+        desde = pa.bytes;
+    }
+
+    return desde;
+}
+
+static std::string nombre_variante(const Conjunto& conjunto) {
+    return conjunto.nombre + (conjunto.prehash ? " (pre-hash)" : "");
+}
+
+static void imprimir_barrido(const ResultadoBarrido& resultado, std::ostream& salida) {
+    salida << "BARRIDO DE TAMAÑOS DE MENSAJE DE " << nombre_variante(resultado.conjunto) << "\n"
+           << std::setw(12) << "Tamaño" << std::setw(15) << "Firma p50 (s)" << std::setw(14) << "Firma MB/s"
+           << std::setw(16) << "Verif. p50 (s)" << std::setw(14) << "Verif. MB/s" << "\n";
+
+    for(const auto& punto : resultado.puntos) {
+        double firma = punto.firma.segundos.mediana;
+        double verificacion = punto.verificacion.segundos.mediana;
+
+        salida << std::setw(12) << formatear_bytes(punto.bytes)
+               << std::setw(15) << firma
+               << std::setw(14) << std::fixed << std::setprecision(2) << (firma > 0 ? punto.bytes / firma / 1e6 : 0)
+               << std::defaultfloat << std::setprecision(6) << std::setw(16) << verificacion
+               << std::setw(14) << std::fixed << std::setprecision(2) << (verificacion > 0 ? punto.bytes / verificacion / 1e6 : 0)
+               << std::defaultfloat << std::setprecision(6)
+               << (punto.verificada ? "" : "  [!] Firma Errónea") << "\n";
+    }
+}
+
+static void imprimir_equilibrio(const ResultadoBarrido& prehash, const ResultadoBarrido& otro, std::ostream& salida) {
+    salida << "  frente a " << std::left << std::setw(28) << nombre_variante(otro.conjunto) << std::right;
+
+    for(bool firma : {true, false}) {
+        uint64_t desde = punto_equilibrio(prehash, otro, firma);
+        salida << (firma ? " firma: " : " | verificación: ")
+               << (desde == 0 ? "no se alcanza" : "desde " + formatear_bytes(desde));
+    }
+    salida << "\n";
+}
+
+int ejecutar_barrido(const Argumentos& args) {
+    if(args.posicionales().empty()) {
+        std::cerr << "Uso: ./pqbench barrido <set|familia|todos>... [--min=0] [--max=24] [--bloque=65536]"
+                     " [--max-puro=26] [--iteraciones=N] [--calentamiento=N] [--outliers[=k]]\n";
+        return 1;
+    }
+
+    Opciones opciones = leer_opciones(args);
+    long minimo = args.entero("min", 0);
+    long maximo = args.entero("max", 24);
+    long maximo_puro = args.entero("max-puro", 26);
+    long bloque = args.entero("bloque", 65536);
+
+    if(minimo < 0 || maximo > 40 || minimo > maximo || maximo_puro < minimo || bloque < 1) {
+        std::cerr << "Opciones inválidas para el modo barrido.\n";
+        return 1;
+    }
+
+    std::vector<uint64_t> tamanos;
+    for(long e = minimo; e <= maximo; ++e) {
+        tamanos.push_back(uint64_t(1) << e);
+    }
+
+    // Los sets de SLH-DSA se miden siempre en las dos variantes para poder compararlas
+    std::vector<Conjunto> elegidos;
+    for(const auto& nombre : args.posicionales()) {
+        std::vector<Conjunto> encontrados = seleccionar(nombre, false);
+        if(encontrados.empty()) {
+            std::cerr << "Set de parámetros inválido: " << nombre << "\n";
+            return 1;
+        }
+
+        for(auto conjunto : encontrados) {
+            elegidos.push_back(conjunto);
+            if(conjunto.familia == Familia::SLH_DSA) {
+                conjunto.prehash = true;
+                elegidos.push_back(conjunto);
+            }
+        }
+    }
+
+    if(opciones.contadores_hw) {
+        activar_contadores_hw();
+    }
+
+    int fallos = 0;
+    std::vector<ResultadoBarrido> resultados;
+    for(const auto& conjunto : elegidos) {
+        try {
+            // SLH-DSA puro guarda el mensaje entero en memoria, así que no pasa de 2^max-puro bytes
+            std::vector<uint64_t> tamanos_set = tamanos;
+            if(conjunto.familia == Familia::SLH_DSA && !conjunto.prehash && maximo_puro < maximo) {
+                tamanos_set.resize(static_cast<size_t>(maximo_puro - minimo + 1));
+                std::cout << "Se omiten en " << nombre_variante(conjunto) << " los tamaños mayores de "
+                          << formatear_bytes(tamanos_set.back()) << ": sin pre-hash Botan guarda el mensaje entero.\n";
+            }
+
+            auto esquema = crear_esquema(conjunto);
+            resultados.push_back(barrer_tamanos(*esquema, tamanos_set, bloque, opciones));
+            imprimir_barrido(resultados.back(), std::cout);
+            std::cout << "\n";
+
+            const auto& puntos = resultados.back().puntos;
+            fallos += std::any_of(puntos.begin(), puntos.end(), [](const PuntoBarrido& p) { return !p.verificada; });
+        } catch(const std::exception& e) {
+            std::cerr << "Excepción en barrido(" << conjunto.nombre << "): " << e.what() << "\n";
+            ++fallos;
+        }
+    }
+
+    /*
+    Punto de equilibrio de cada variante con pre-hash: el tamaño a partir del cual es
+    más rápida que la misma variante pura y que cada set de ML-DSA medido.
+    */
+    bool cabecera = false;
+    for(const auto& prehash : resultados) {
+        if(!prehash.conjunto.prehash) {
+            continue;
+        }
+
+        if(!cabecera) {
+            std::cout << "PUNTO DE EQUILIBRIO DEL PRE-HASH (tamaño a partir del cual el pre-hash es más rápido)\n";
+            cabecera = true;
+        }
+        std::cout << nombre_variante(prehash.conjunto) << "\n";
+
+        for(const auto& otro : resultados) {
+            bool pura = otro.conjunto.nombre == prehash.conjunto.nombre && !otro.conjunto.prehash;
+            if(pura || otro.conjunto.familia == Familia::ML_DSA) {
+                imprimir_equilibrio(prehash, otro, std::cout);
+            }
+        }
+    }
+
+    return fallos == 0 ? 0 : 1;
+}
+
+} // namespace pqbench
@@ -0,0 +1,59 @@
+#ifndef PQBENCH_BARRIDO_H
+#define PQBENCH_BARRIDO_H
+
+#include "pqbench.h"
+
+/*
+Barrido de tamaños de mensaje.
+
+La evaluación normal firma siempre el mensaje fijo de 4 bytes, pero en producción se
+firman desde unos pocos bytes hasta artefactos de varios GB. Aquí el mensaje se pasa
+a signer.update() y verifier.update() por bloques, como se haría leyendo un fichero,
+para tamaños crecientes. Con esto se ve a partir de qué tamaño compensa el pre-hash
+de SLH-DSA frente a la variante pura y frente a ML-DSA.
+
+Pasar el mensaje por bloques no ahorra memoria en todas las variantes: SLH-DSA puro
+recorre el mensaje dos veces (para el aleatorizador R y para H_msg), así que Botan
+lo guarda entero hasta signature() y check_signature(), y un punto de 2^30 bytes
+reserva al menos 1 GiB. En esa variante sólo se miden los tamaños hasta 2^max-puro.
+*/
+
+namespace pqbench {
+
+// Firma y verificación de un mensaje de un tamaño
+struct PuntoBarrido {
+    uint64_t bytes = 0;
+    Operacion firma;
+    Operacion verificacion;
+    bool verificada = false;
+};
+
+struct ResultadoBarrido {
+    Conjunto conjunto;
+    std::vector<PuntoBarrido> puntos;
+};
+
+/*
+Firma y verifica mensajes de cada uno de los tamaños indicados, pasándolos en bloques
+de `bloque` bytes. El firmador y el verificador se construyen una única vez.
+*/
+ResultadoBarrido barrer_tamanos(const Esquema& esquema, const std::vector<uint64_t>& tamanos,
+                                size_t bloque, const Opciones& opciones);
+
+/*
+Menor tamaño del barrido a partir del cual `a` es más rápido que `b` en todos los
+tamaños mayores (comparando medianas). Devuelve 0 si no se alcanza dentro del barrido.
+*/
+uint64_t punto_equilibrio(const ResultadoBarrido& a, const ResultadoBarrido& b, bool firma);
+
+/*
+Punto de entrada del modo desde la línea de comandos:
+  ./pqbench barrido <set|familia|todos>... [--min=0] [--max=24] [--max-puro=26] [--bloque=65536] [opciones de medición]
+Los tamaños van de 2^min a 2^max bytes (2^max-puro como mucho en SLH-DSA sin pre-hash).
+Los sets de SLH-DSA se miden con y sin pre-hash.
+*/
+int ejecutar_barrido(const Argumentos& args);
+
+} // namespace pqbench
+
+#endif
@@ -1,4 +1,7 @@
-import subprocess, csv, re, sys
+import subprocess, csv, json, os, re, sys, time
+from concurrent.futures import ThreadPoolExecutor, as_completed
+from queue import Queue
+from threading import Lock
 
 ALGORITMOS = {
     0: "TODOS",
@@ -19,7 +22,7 @@ XMSS_PARAMS = [
     "XMSS-SHA2_10_512", "XMSS-SHA2_16_512", "XMSS-SHA2_20_512",
     "XMSS-SHAKE_10_256", "XMSS-SHAKE_16_256", "XMSS-SHAKE_20_256",
     "XMSS-SHAKE_10_512", "XMSS-SHAKE_16_512", "XMSS-SHAKE_20_512"
-    
+
 ]
 
 MLDSA_PARAMS = [
@@ -32,95 +35,278 @@ CABECERAS = ["Parametro", "Prehash", "Keygen_tiempo", "Keygen_ciclos","Tamaño_c
               "Firma_tiempo", "Firma_ciclos", "Tamaño_firma", "Verificacion_tiempo", "Verificacion_ciclos",
               "Tiempo total", "Ciclos_totales"
               ]
-            
-# Resultados de los diferntes sets de parámetros
-resultados = []
 
+# pqbench --json escribe un objeto por set con este esquema (ver resultado_json.h)
+VERSION_ESQUEMA = 1
 
+# Operaciones del JSON que van al CSV y prefijo de sus columnas
+FASES = {
+    "keygen": "Keygen",
+    "firma": "Firma",
+    "verificacion": "Verificacion"
+}
+# Contadores hardware (perf_event_open) de cada fase. Se añaden al final de cada fila.
+CONTADORES_HW = True
+EVENTOS_HW = ["instrucciones", "IPC", "fallos_L1d", "fallos_LLC", "fallos_salto", "fallos_dTLB"]
+# Memoria de cada fase (reservas, pico del montón, pila y RSS) y pico de RSS del proceso. Van tras los contadores.
+MEMORIA = True
+CAMPOS_MEM = {
+    "reservas": "reservas",
+    "bytes_reservados": "bytes_reservados",
+    "pico_monton": "pico_monton",
+    "pila": "pila",
+    "pico_rss": "pico_RSS"
+}
+# Energía por operación de cada fase con RAPL (--energia). Va tras la memoria; sin RAPL las columnas quedan como N/A.
+# RAPL mide todo el paquete, así que con varios sets en paralelo la energía de uno incluye la de los demás:
+# para medirla hay que dejar un único núcleo en NUCLEOS.
+ENERGIA = False
+CAMPOS_EN = {
+    "julios": "julios",
+    "julios_nucleo": "julios_nucleo",
+    "ops_por_julio": "ops_por_julio"
+}
+# Huella del entorno de ejecución de cada set (núcleo, gobernador, turbo, SMT, frecuencia y carga). Va al final de cada fila.
+ENTORNO = True
+CAMPOS_ENT = {
+    "maquina": "Maquina",
+    "nucleo": "Nucleo",
+    "prioridad": "Prioridad",
+    "gobernador": "Gobernador",
+    "turbo": "Turbo",
+    "smt": "SMT",
+    "hermanos_smt": "Hermanos_SMT",
+    "frecuencia_inicial_mhz": "Frecuencia_inicial_MHz",
+    "frecuencia_final_mhz": "Frecuencia_final_MHz",
+    "carga": "Carga"
+}
+# Las claves de XMSS se generan una vez y se reutilizan entre ejecuciones (ver --cache-claves en el README)
+CACHE_CLAVES_XMSS = True
+
+"""
+Ejecución en paralelo: cada set se evalúa en su propio proceso fijado con --nucleo a un núcleo
+libre de NUCLEOS, de modo que nunca hay dos sets en el mismo núcleo. Por defecto se usan todos los
+núcleos en los que puede ejecutarse el script; con NUCLEOS = [2] se vuelve a la ejecución en serie.
+Los núcleos que comparten caché o son hermanos SMT se molestan entre sí, así que para resultados
+finos conviene dejar sólo un hilo por núcleo físico.
+El keygen de XMSS reparte el árbol entre los hilos del pool de Botan, que se dimensiona con los
+núcleos permitidos al proceso; fijado a uno solo pasaría a ser secuencial. Por eso los sets de XMSS
+no se fijan con --nucleo: esperan a tener libres todos los núcleos de NUCLEOS, se ejecutan solos
+sobre ellos y lo indican en Avisos_entorno.
+"""
+NUCLEOS = None
+# Tiempo máximo (s) de cada set: si se supera se mata el proceso y su fila queda como "Timeout".
+PRESUPUESTO_POR_DEFECTO = 900
+PRESUPUESTOS = [
+    (r"XMSS-.*_20_", 4 * 3600),
+    (r"XMSS-.*_16_", 1800),
+]
+# Tiempo máximo (s) de todo el barrido: los sets que no han empezado al agotarse no se ejecutan (None = sin límite)
+PRESUPUESTO_TOTAL = None
+
+if CONTADORES_HW:
+    CABECERAS += [f"{fase}_{evento}" for fase in FASES.values() for evento in EVENTOS_HW]
+if MEMORIA:
+    CABECERAS += [f"{fase}_{campo}" for fase in FASES.values() for campo in CAMPOS_MEM.values()]
+    CABECERAS.append("Pico_RSS_proceso")
+if ENERGIA:
+    CABECERAS += [f"{fase}_{campo}" for fase in FASES.values() for campo in CAMPOS_EN.values()]
+if ENTORNO:
+    CABECERAS += list(CAMPOS_ENT.values())
+    CABECERAS.append("Avisos_entorno")
+# Resultado de la ejecución del set: OK, Firma errónea, Timeout, Error o No ejecutado
+CABECERAS.append("Estado")
+
+
+def presupuesto(param):
+    for patron, segundos in PRESUPUESTOS:
+        if re.search(patron, param):
+            return segundos
+    return PRESUPUESTO_POR_DEFECTO
+
+
+def valor(dato):
+    """
+    Valor para el CSV: los desconocidos (null en el JSON) salen como N/A.
+    """
+    return "N/A" if dato is None else dato
 
-# Contador de fallos. Un benchmark de un set falla cuando hay un error en la ejecución o la firma no se verifica correctamente.
-FALLOS = 0 
 
-# Función para extraer el valor de la línea
-def extraer_valor(linea: str):
+def fila_resultado(param, prehash, resultado):
+    """
+    Construye la fila del CSV, en el orden de CABECERAS, a partir del objeto JSON de pqbench.
     """
-    Busca un número en la línea y lo convierte a int o float.
-    Si no hay número, devuelve None.
+    ops = resultado["operaciones"]
+    mediana = lambda op, campo: ops[op][campo]["mediana"]
+
+    fila = [param, prehash,
+            mediana("keygen", "segundos"), int(mediana("keygen", "ciclos")),
+            resultado["tam_clave_publica"], resultado["tam_clave_privada"],
+            mediana("firma", "segundos"), int(mediana("firma", "ciclos")), resultado["tam_firma"],
+            mediana("verificacion", "segundos"), int(mediana("verificacion", "ciclos"))]
+
+    # Se calculan el tiempo total y los ciclos totales
+    fila.append(fila[2] + fila[6] + fila[9])
+    fila.append(fila[3] + fila[7] + fila[10])
+
+    # Contadores hardware de cada fase, en el orden de las cabeceras (N/A si no hay)
+    if CONTADORES_HW:
+        for op in FASES:
+            hw = ops[op].get("hw", {})
+            fila += [valor(hw.get(evento)) for evento in EVENTOS_HW]
+
+    # Memoria de cada fase (N/A si no se ha medido, p. ej. el keygen de una clave de la caché)
+    if MEMORIA:
+        for op in FASES:
+            memoria = ops[op].get("memoria", {})
+            fila += [valor(memoria.get(campo)) for campo in CAMPOS_MEM]
+        fila.append(valor(resultado.get("pico_rss_proceso")))
+
+    if ENERGIA:
+        for op in FASES:
+            energia = ops[op].get("energia", {})
+            fila += [valor(energia.get(campo)) for campo in CAMPOS_EN]
+
+    if ENTORNO:
+        entorno = resultado["entorno"]
+        fila += [valor(entorno.get(campo)) for campo in CAMPOS_ENT]
+        avisos = resultado["avisos_entorno"]
+        fila.append(" | ".join(avisos) if avisos else "No")
+
+    fila.append("OK" if resultado["verificada"] else "Firma errónea")
+    return fila
+
+
+def fila_fallida(param, prehash, estado):
     """
-    coincidencia = re.search(r"[-+]?\d*\.\d+|\d+", linea)
-    if coincidencia:
-        valor_str = coincidencia.group(0)
-        # Convertir a float si contiene punto decimal, si no, a int
-        return float(valor_str) if '.' in valor_str else int(valor_str)
-    return None
+    Fila de un set que no ha dado resultado: todo N/A salvo el nombre, el pre-hash y el estado.
+    """
+    return [param, prehash] + ["N/A"] * (len(CABECERAS) - 3) + [estado]
 
 
-def escribirCSV(algoritmo):
+def escribirCSV(algoritmo, filas):
+    """
+    Reescribe el CSV con las filas terminadas hasta ahora. Se escribe en un fichero temporal y se
+    renombra, así que si el script muere a mitad el CSV sigue teniendo todas las filas anteriores.
+    """
+    nombre = f"{algoritmo}-Resultados.csv"
     try:
-        with open(f"{algoritmo}-Resultados.csv", mode="w", newline="") as archivo:
-                writer = csv.writer(archivo)
-                writer.writerows(datos)
-
-        archivo.close()
-            
-        print(f"\nResultados guardados en '{algoritmo}-Resultados.csv'")
-        
+        with open(nombre + ".tmp", mode="w", newline="") as archivo:
+            writer = csv.writer(archivo)
+            writer.writerow(CABECERAS)
+            writer.writerows(fila for fila in filas if fila is not None)
+        os.replace(nombre + ".tmp", nombre)
     except Exception as e:
         print(f"Error al guardar los resultados: {e}")
         sys.exit(1)
 
 
-def extraer_resultados(salida):
-    global resultados,datos, CABECERAS
+def ejecutar_comando(algoritmo, param, prehash, nucleos):
     """
-    Extrae los resultados de la salida del comando y los guarda en un csv.
+    Evalúa un set en los núcleos indicados y devuelve (estado, resultado JSON o None, segundos).
+    Con un solo núcleo el proceso se fija a él con --nucleo; con varios se limita a ellos con
+    sched_setaffinity y se deja a Botan repartir su pool entre todos.
     """
-    # En este punto resultados ya tiene los dos primeros valores (parametro y prehash)
-    # El resto de valores van a venir en orden.
-    for linea in salida.splitlines():
-        valor = extraer_valor(linea)
-
-        if valor is not None and "SET DE" not in linea:
-            resultados.append(valor)
-        else:
-            if "Firma Errónea" in linea:
-                FALLOS += 1
-                print("Firma Errónea.")
-
-    # Se calculan los ciclos totales y el tiempo total
-    ciclos_totales = resultados[3] + resultados[7] + resultados[10]
-    tiempo_total = resultados[2] + resultados[6] + resultados[9]
-    resultados.append(tiempo_total)
-    resultados.append(ciclos_totales)
-
-    # Se añaden los resultados a la lista de datos
-    datos.append(resultados)
-    return 0
-
-
-def ejecutar_comando(algoritmo, param, prehash=3): # PreHash = 3 -> No se utiliza en este algoritmo.
+    comando = ["./pqbench", param, "--json"]
+    if len(nucleos) == 1:
+        comando.append(f"--nucleo={nucleos[0]}")
+    if CONTADORES_HW:
+        comando.append("--contadores")
+    if MEMORIA:
+        comando.append("--memoria")
+    if ENERGIA:
+        comando.append("--energia")
+    if CACHE_CLAVES_XMSS and algoritmo == "XMSS":
+        comando.append("--cache-claves")
+    if prehash:
+        comando.append("--prehash")
+
+    inicio = time.monotonic()
+    try:
+        proceso = subprocess.run(comando, capture_output=True, text=True, timeout=presupuesto(param),
+                                 preexec_fn=None if len(nucleos) == 1 else lambda: os.sched_setaffinity(0, nucleos))
+    except subprocess.TimeoutExpired:
+        return f"Timeout ({presupuesto(param)}s)", None, time.monotonic() - inicio
+    segundos = time.monotonic() - inicio
+
+    # Con --json stdout sólo lleva los objetos de resultados; el resto de la salida va a stderr
+    for linea in proceso.stdout.splitlines():
+        if not linea.startswith("{"):
+            continue
+        resultado = json.loads(linea)
+        if resultado.get("version_esquema") != VERSION_ESQUEMA:
+            return f"Error (esquema {resultado.get('version_esquema')}, se esperaba {VERSION_ESQUEMA})", None, segundos
+        if len(nucleos) > 1:
+            resultado["avisos_entorno"].append(f"sin fijar a un núcleo (núcleos {','.join(map(str, nucleos))})")
+        return ("OK" if resultado["verificada"] else "Firma errónea"), resultado, segundos
+
+    error = proceso.stderr.strip().splitlines()
+    return f"Error ({proceso.returncode}: {error[-1] if error else 'sin salida'})", None, segundos
+
+
+def ejecutar_barrido(trabajos):
     """
-    Ejecuta un comando en la terminal y devuelve la salida.
+    Ejecuta los trabajos (algoritmo, param, prehash) en paralelo, uno por núcleo de NUCLEOS, y va
+    escribiendo el CSV de cada algoritmo a medida que terminan. Devuelve el número de fallos.
     """
-    print(f"\n[+] EJECUTANDO {param}", end="")
-    comando = [f"./{algoritmo}", param]
-    if prehash!= 3:
-        print(f"(prehash={"Sí" if prehash else "No"})", end="")
-        comando.insert(1, str(prehash))
-    print()
-
-    resultado = subprocess.run(
-        comando,
-        capture_output=True,
-        text=True,
-    )
-    salida = resultado.stdout
-    if resultado.returncode != 0:
-        print(f"Error en la ejecución de {param} (prehash={"Sí" if prehash else "No"})")
-             
-    # Extraer los resultados de la salida
-    extraer_resultados(salida)
-    return resultado.returncode
+    nucleos = NUCLEOS if NUCLEOS is not None else sorted(os.sched_getaffinity(0))
+    if ENERGIA and len(nucleos) > 1:
+        print("[!] La energía de RAPL es la de todo el paquete: con varios núcleos cada set incluye la de los demás.")
+
+    libres = Queue()
+    for nucleo in nucleos:
+        libres.put(nucleo)
+    # Los núcleos se reservan de uno en uno bajo el cerrojo para que un set de XMSS que espera a
+    # tenerlos todos no se quede sin ellos por los sets que empiezan mientras tanto
+    reserva = Lock()
+
+    # Cada fila se guarda en su posición del orden original para que el CSV no dependa de qué termina antes
+    filas = {algoritmo: [None] * sum(1 for t in trabajos if t[0] == algoritmo) for algoritmo, _, _ in trabajos}
+    posiciones = {}
+    for algoritmo, param, prehash in trabajos:
+        posiciones[(algoritmo, param, prehash)] = sum(1 for clave in posiciones if clave[0] == algoritmo)
+
+    inicio = time.monotonic()
+
+    def trabajo(algoritmo, param, prehash):
+        # Los sets que no han empezado cuando se agota el presupuesto total no se ejecutan
+        if PRESUPUESTO_TOTAL is not None and time.monotonic() - inicio > PRESUPUESTO_TOTAL:
+            return "No ejecutado (presupuesto total agotado)", None, 0, None
+        with reserva:
+            asignados = [libres.get() for _ in range(len(nucleos) if algoritmo == "XMSS" else 1)]
+        try:
+            return (*ejecutar_comando(algoritmo, param, prehash, sorted(asignados)), sorted(asignados))
+        finally:
+            for nucleo in asignados:
+                libres.put(nucleo)
+
+    # Los sets más largos empiezan primero para que no queden solos al final del barrido
+    orden = sorted(trabajos, key=lambda t: -presupuesto(t[1]))
+
+    fallos = 0
+    with ThreadPoolExecutor(max_workers=len(nucleos)) as pool:
+        futuros = {pool.submit(trabajo, *t): t for t in orden}
+        for futuro in as_completed(futuros):
+            algoritmo, param, prehash = futuros[futuro]
+            estado, resultado, segundos, asignados = futuro.result()
+
+            texto_prehash = "N/A" if prehash is None else ("Sí" if prehash else "No")
+            if resultado is not None:
+                fila = fila_resultado(param, texto_prehash, resultado)
+            else:
+                fila = fila_fallida(param, texto_prehash, estado)
+            if estado != "OK":
+                fallos += 1
+
+            filas[algoritmo][posiciones[(algoritmo, param, prehash)]] = fila
+            escribirCSV(algoritmo, filas[algoritmo])
+
+            sufijo = "" if prehash is None else f" (prehash={texto_prehash})"
+            print(f"[+] {param}{sufijo}: {estado} en {segundos:.1f}s" + (f" (núcleo{'s' if len(asignados) > 1 else ''} {','.join(map(str, asignados))})" if asignados else ""))
+
+    for algoritmo in filas:
+        print(f"\nResultados guardados en '{algoritmo}-Resultados.csv'")
+    return fallos
 
 
 if __name__ == "__main__":
@@ -129,11 +315,11 @@ if __name__ == "__main__":
 
     print("[+] SELECCIONA EL ALGORITMO:\n")
 
-    
-    
+
+
     for key, algoritmo in ALGORITMOS.items():
         print(f"[{key}] {algoritmo}")
-    
+
 
     try:
         num_algo = int(input("\n>> "))
@@ -144,54 +330,23 @@ if __name__ == "__main__":
         sys.exit(1)
 
     algoritmo = ALGORITMOS[num_algo]
-    
-    
-    print("\n[+] EJECUTANDO BENCHMARK PARA EL ALGORITMO:", algoritmo)
 
-    if algoritmo == "SLH-DSA" or algoritmo == "TODOS":
-        datos = [CABECERAS] # Estrucutura que se va a escribir en el CSV
-        for prehash in [0, 1]:
-            for param in SLHDSA_PARAMS:
-
-                resultados = [param]
-                if prehash == 0:
-                    resultados.append("No")
-                else:
-                    resultados.append("Sí")
-
-                code = ejecutar_comando("SLH-DSA", param, prehash)
-                if code != 0:
-                    FALLOS += 1
-
-        # Una vez se han probado todos los parámetros, se guardan los resultados en el CSV\
-        escribirCSV("SLH-DSA")
-        
-    if algoritmo == "XMSS" or algoritmo == "TODOS":
-        datos = [CABECERAS] # Estrucutura que se va a escribir en el CSV
-        for param in XMSS_PARAMS:
-
-            resultados = [param, "N/A"]
 
-            code = ejecutar_comando("XMSS", param)
+    print("\n[+] EJECUTANDO BENCHMARK PARA EL ALGORITMO:", algoritmo)
 
-            if code != 0:
-                FALLOS += 1
+    # Trabajos (algoritmo, set, prehash) en el orden en que van al CSV. prehash = None -> no se utiliza en este algoritmo.
+    trabajos = []
+    if algoritmo == "SLH-DSA" or algoritmo == "TODOS":
+        for prehash in [False, True]:
+            trabajos += [("SLH-DSA", param, prehash) for param in SLHDSA_PARAMS]
 
-        # Una vez se han probado todos los parámetros, se guardan los resultados en el CSV\
-        escribirCSV("XMSS")
+    if algoritmo == "XMSS" or algoritmo == "TODOS":
+        trabajos += [("XMSS", param, None) for param in XMSS_PARAMS]
 
     if algoritmo == "ML-DSA" or algoritmo == "TODOS":
-        datos = [CABECERAS] # Estrucutura que se va a escribir en el CSV
-        for param in MLDSA_PARAMS:
-            resultados = [param, "N/A"]
-
-            code = ejecutar_comando("ML-DSA", param)
-            
-            if code != 0:
-                FALLOS += 1
+        trabajos += [("ML-DSA", param, None) for param in MLDSA_PARAMS]
 
-        # Una vez se han probado todos los parámetros, se guardan los resultados en el CSV\
-        escribirCSV("ML-DSA")
+    FALLOS = ejecutar_barrido(trabajos)
 
     print("\n[+] BENCHMARK FINALIZADO")
-    print(f"[+] FALLOS: {FALLOS}")
\ No newline at end of file
+    print(f"[+] FALLOS: {FALLOS}")
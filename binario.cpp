@@ -0,0 +1,135 @@
+#include "binario.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace pqbench {
+
+void poner_entero(std::vector<uint8_t>& datos, uint64_t valor, size_t bytes) {
+    for(size_t i = 0; i < bytes; ++i) {
+        datos.push_back(static_cast<uint8_t>(valor >> (8 * i)));
+    }
+}
+
+uint64_t leer_entero(std::span<const uint8_t> datos, size_t& pos, size_t bytes) {
+    if(pos > datos.size() || datos.size() - pos < bytes) {
+        throw std::runtime_error("Fichero truncado");
+    }
+
+    uint64_t valor = 0;
+    for(size_t i = 0; i < bytes; ++i) {
+        valor |= static_cast<uint64_t>(datos[pos + i]) << (8 * i);
+    }
+    pos += bytes;
+    return valor;
+}
+
+void poner_campo(std::vector<uint8_t>& datos, std::span<const uint8_t> campo, size_t bytes_longitud) {
+    poner_entero(datos, campo.size(), bytes_longitud);
+    datos.insert(datos.end(), campo.begin(), campo.end());
+}
+
+std::span<const uint8_t> leer_campo(std::span<const uint8_t> datos, size_t& pos, size_t bytes_longitud) {
+    size_t tam = leer_entero(datos, pos, bytes_longitud);
+    if(datos.size() - pos < tam) {
+        throw std::runtime_error("Fichero truncado");
+    }
+
+    std::span<const uint8_t> campo = datos.subspan(pos, tam);
+    pos += tam;
+    return campo;
+}
+
+std::vector<uint8_t> leer_fichero(const std::string& fichero) {
+    std::ifstream entrada(fichero, std::ios::binary | std::ios::ate);
+    if(!entrada) {
+        throw std::runtime_error("No se pudo abrir " + fichero);
+    }
+
+    std::vector<uint8_t> contenido(static_cast<size_t>(entrada.tellg()));
+    entrada.seekg(0);
+    entrada.read(reinterpret_cast<char*>(contenido.data()), contenido.size());
+    if(!entrada) {
+        throw std::runtime_error("No se pudo leer " + fichero);
+    }
+    return contenido;
+}
+
+void escribir_fichero(const std::string& fichero, std::span<const uint8_t> datos) {
+    std::ofstream salida(fichero, std::ios::binary | std::ios::trunc);
+    salida.write(reinterpret_cast<const char*>(datos.data()), datos.size());
+    if(!salida) {
+        throw std::runtime_error("No se pudo escribir " + fichero);
+    }
+}
+
+void escribir_fichero_atomico(const std::string& fichero, std::span<const uint8_t> datos) {
+    std::string temporal = fichero + ".tmp";
+
+    int fd = ::open(temporal.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if(fd < 0) {
+        throw std::runtime_error("No se pudo crear " + temporal + ": " + std::strerror(errno));
+    }
+
+    if(!escribir_todo(fd, datos.data(), datos.size())) {
+        ::close(fd);
+        throw std::runtime_error("No se pudo escribir " + temporal + ": " + std::strerror(errno));
+    }
+
+    if(::fsync(fd) != 0 || ::close(fd) != 0 || ::rename(temporal.c_str(), fichero.c_str()) != 0) {
+        throw std::runtime_error("No se pudo guardar " + fichero + ": " + std::strerror(errno));
+    }
+
+    // El renombrado se hace persistente con un fsync del directorio
+    sincronizar_directorio(fichero);
+}
+
+void sincronizar_directorio(const std::string& fichero) {
+    size_t barra = fichero.find_last_of('/');
+    std::string directorio = barra == std::string::npos ? "." : fichero.substr(0, std::max<size_t>(barra, 1));
+    int dir = ::open(directorio.c_str(), O_RDONLY | O_DIRECTORY);
+    if(dir >= 0) {
+        ::fsync(dir);
+        ::close(dir);
+    }
+}
+
+bool escribir_todo(int fd, const void* datos, size_t bytes) {
+    const uint8_t* p = static_cast<const uint8_t*>(datos);
+    while(bytes > 0) {
+        ssize_t n = ::write(fd, p, bytes);
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        if(n <= 0) {
+            return false;
+        }
+        p += n;
+        bytes -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool leer_todo(int fd, void* datos, size_t bytes) {
+    uint8_t* p = static_cast<uint8_t*>(datos);
+    while(bytes > 0) {
+        ssize_t n = ::read(fd, p, bytes);
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        if(n <= 0) {
+            return false;
+        }
+        p += n;
+        bytes -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace pqbench
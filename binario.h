@@ -0,0 +1,52 @@
+#ifndef PQBENCH_BINARIO_H
+#define PQBENCH_BINARIO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+/*
+Utilidades para los ficheros binarios que escribe pqbench (lotes, firmas separadas...).
+Todos los enteros se guardan en little-endian y los campos de longitud variable van
+precedidos de su longitud.
+*/
+
+namespace pqbench {
+
+// Añade un entero de `bytes` bytes al final de datos
+void poner_entero(std::vector<uint8_t>& datos, uint64_t valor, size_t bytes);
+
+// Lee un entero de `bytes` bytes en pos y avanza pos; lanza una excepción si no caben
+uint64_t leer_entero(std::span<const uint8_t> datos, size_t& pos, size_t bytes);
+
+// Campo de longitud variable precedido de su longitud en `bytes_longitud` bytes
+void poner_campo(std::vector<uint8_t>& datos, std::span<const uint8_t> campo, size_t bytes_longitud = 4);
+std::span<const uint8_t> leer_campo(std::span<const uint8_t> datos, size_t& pos, size_t bytes_longitud = 4);
+
+// Lectura y escritura de un fichero completo
+std::vector<uint8_t> leer_fichero(const std::string& fichero);
+void escribir_fichero(const std::string& fichero, std::span<const uint8_t> datos);
+
+/*
+Sustituye el fichero de forma atómica: escribe una copia temporal, la lleva a disco con
+fsync y la renombra. Tras un corte se encuentra el contenido anterior o el nuevo, nunca
+uno a medias.
+*/
+void escribir_fichero_atomico(const std::string& fichero, std::span<const uint8_t> datos);
+
+// Hace persistente la entrada del fichero en su directorio (tras crearlo o renombrarlo)
+void sincronizar_directorio(const std::string& fichero);
+
+/*
+Escriben o leen exactamente `bytes` bytes de un descriptor (fichero, tubería o socket),
+repitiendo las llamadas cortas o interrumpidas. Devuelven false si hay un error o si el
+otro extremo se cierra antes.
+*/
+bool escribir_todo(int fd, const void* datos, size_t bytes);
+bool leer_todo(int fd, void* datos, size_t bytes);
+
+} // namespace pqbench
+
+#endif
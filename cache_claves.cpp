@@ -0,0 +1,128 @@
+#include "cache_claves.h"
+#include "binario.h"
+
+#include <botan/chacha_rng.h>
+
+#include <bit>
+#include <filesystem>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pqbench {
+
+static const char MAGIA_CLAVE[8] = {'P', 'Q', 'B', 'C', 'L', 'A', 'V', '1'};
+
+std::string ruta_clave_cacheada(const std::string& directorio, const Conjunto& conjunto, uint64_t semilla) {
+    return directorio + "/" + conjunto.nombre + "-" + std::to_string(semilla) + ".clave";
+}
+
+std::unique_ptr<Botan::RandomNumberGenerator> rng_semilla(uint64_t semilla) {
+    // ChaCha_RNG necesita al menos 256 bits de semilla para darse por sembrado
+    return std::make_unique<Botan::ChaCha_RNG>(material_semilla("pqbench-cache-claves", semilla));
+}
+
+std::optional<ClaveCacheada> cargar_clave_cacheada(const Esquema& esquema, const std::string& ruta, uint64_t semilla) {
+    int fd = ::open(ruta.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return std::nullopt;
+    }
+
+    struct stat info;
+    if(::fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return std::nullopt;
+    }
+
+    // La clave se reconstruye directamente desde la proyección del fichero
+    size_t tam = static_cast<size_t>(info.st_size);
+    void* proyeccion = ::mmap(nullptr, tam, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(proyeccion == MAP_FAILED) {
+        return std::nullopt;
+    }
+
+    std::span<const uint8_t> datos(static_cast<const uint8_t*>(proyeccion), tam);
+    std::optional<ClaveCacheada> cacheada;
+
+    try {
+        if(tam < sizeof(MAGIA_CLAVE) || !std::equal(MAGIA_CLAVE, MAGIA_CLAVE + sizeof(MAGIA_CLAVE), datos.begin())) {
+            throw std::runtime_error("formato desconocido");
+        }
+
+        size_t pos = sizeof(MAGIA_CLAVE);
+        std::span<const uint8_t> nombre = leer_campo(datos, pos, 2);
+        uint64_t semilla_fichero = leer_entero(datos, pos, 8);
+        double segundos = std::bit_cast<double>(leer_entero(datos, pos, 8));
+        uint64_t ciclos = leer_entero(datos, pos, 8);
+        std::span<const uint8_t> bits = leer_campo(datos, pos);
+
+        if(std::string(nombre.begin(), nombre.end()) != esquema.conjunto().nombre || semilla_fichero != semilla) {
+            throw std::runtime_error("corresponde a otro set o a otra semilla");
+        }
+
+        cacheada = ClaveCacheada{esquema.cargar_clave_privada(bits), segundos, ciclos};
+    } catch(const std::exception& e) {
+        // Una entrada corrupta se trata como si no existiera y se regenera
+        std::cerr << "[!] Se ignora la clave en caché " << ruta << ": " << e.what() << "\n";
+    }
+
+    ::munmap(proyeccion, tam);
+    return cacheada;
+}
+
+void guardar_clave_cacheada(const std::string& ruta, const Conjunto& conjunto, uint64_t semilla,
+                            const Botan::Private_Key& clave, double segundos_keygen, uint64_t ciclos_keygen) {
+
+    std::filesystem::path directorio = std::filesystem::path(ruta).parent_path();
+    if(!directorio.empty()) {
+        std::filesystem::create_directories(directorio);
+    }
+
+    Botan::secure_vector<uint8_t> bits = clave.private_key_bits();
+
+    std::vector<uint8_t> contenido(MAGIA_CLAVE, MAGIA_CLAVE + sizeof(MAGIA_CLAVE));
+    poner_campo(contenido, std::span(reinterpret_cast<const uint8_t*>(conjunto.nombre.data()), conjunto.nombre.size()), 2);
+    poner_entero(contenido, semilla, 8);
+    poner_entero(contenido, std::bit_cast<uint64_t>(segundos_keygen), 8);
+    poner_entero(contenido, ciclos_keygen, 8);
+    poner_campo(contenido, bits);
+
+    escribir_fichero_atomico(ruta, contenido);
+}
+
+ClaveObtenida obtener_clave(const Esquema& esquema, const Opciones& opciones) {
+    ClaveObtenida obtenida;
+
+    if(!opciones.cache_claves.empty()) {
+        obtenida.ruta = ruta_clave_cacheada(opciones.cache_claves, esquema.conjunto(), opciones.semilla_claves);
+        if(!opciones.regenerar_claves) {
+            if(auto cacheada = cargar_clave_cacheada(esquema, obtenida.ruta, opciones.semilla_claves)) {
+                obtenida.clave = std::move(cacheada->clave);
+                obtenida.keygen = {cacheada->segundos_keygen, cacheada->ciclos_keygen};
+                obtenida.de_cache = true;
+                return obtenida;
+            }
+        }
+    }
+
+    obtenida.keygen = medir([&] {
+        if(obtenida.ruta.empty()) {
+            Botan::AutoSeeded_RNG rng;
+            obtenida.clave = esquema.generar_clave(rng);
+        } else {
+            obtenida.clave = esquema.generar_clave(*rng_semilla(opciones.semilla_claves));
+        }
+    });
+
+    if(!obtenida.ruta.empty()) {
+        guardar_clave_cacheada(obtenida.ruta, esquema.conjunto(), opciones.semilla_claves, *obtenida.clave,
+                               obtenida.keygen.segundos, obtenida.keygen.ciclos);
+    }
+    return obtenida;
+}
+
+} // namespace pqbench
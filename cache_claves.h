@@ -0,0 +1,60 @@
+#ifndef PQBENCH_CACHE_CLAVES_H
+#define PQBENCH_CACHE_CLAVES_H
+
+#include "pqbench.h"
+
+#include <optional>
+
+/*
+Caché de claves en disco.
+
+Generar una clave XMSS de altura 20 lleva varios minutos (y más con n = 64 o SHAKE), así
+que repetir el barrido completo regenerando cada clave es inviable. Con la caché, la clave
+de cada set se genera una vez a partir de una semilla (con un ChaCha_RNG determinista) y
+se guarda con private_key_bits(), que en XMSS incluye el índice de la siguiente hoja. En
+las ejecuciones siguientes el fichero se proyecta con mmap y se carga la clave, y al
+terminar se vuelve a guardar con el índice avanzado, como haría un firmador de larga
+duración que conserva su clave entre reinicios.
+
+Formato del fichero:
+  "PQBCLAV1", u16 longitud + nombre del set, u64 semilla,
+  u64 tiempo de keygen (bits del double), u64 ciclos de keygen,
+  u32 longitud + private_key_bits()
+*/
+
+namespace pqbench {
+
+// Clave leída de la caché, con el coste que tuvo generarla
+struct ClaveCacheada {
+    std::unique_ptr<Botan::Private_Key> clave;
+    double segundos_keygen = 0;
+    uint64_t ciclos_keygen = 0;
+};
+
+// Fichero de la caché para un set y una semilla: <directorio>/<set>-<semilla>.clave
+std::string ruta_clave_cacheada(const std::string& directorio, const Conjunto& conjunto, uint64_t semilla);
+
+// RNG determinista con el que se generan las claves de la caché
+std::unique_ptr<Botan::RandomNumberGenerator> rng_semilla(uint64_t semilla);
+
+// Carga la clave del fichero si existe y corresponde al set y la semilla
+std::optional<ClaveCacheada> cargar_clave_cacheada(const Esquema& esquema, const std::string& ruta, uint64_t semilla);
+
+// Guarda (o actualiza) la clave de forma atómica, creando el directorio si hace falta
+void guardar_clave_cacheada(const std::string& ruta, const Conjunto& conjunto, uint64_t semilla,
+                            const Botan::Private_Key& clave, double segundos_keygen, uint64_t ciclos_keygen);
+
+// Clave para los modos que firman muchas veces con ella
+struct ClaveObtenida {
+    std::unique_ptr<Botan::Private_Key> clave;
+    Medicion keygen;           // Medido ahora o, si viene de la caché, al generarla
+    bool de_cache = false;
+    std::string ruta;          // Fichero de la caché ("" si no se usa)
+};
+
+// Carga la clave de la caché si las opciones lo piden y está; si no, la genera (y la guarda)
+ClaveObtenida obtener_clave(const Esquema& esquema, const Opciones& opciones);
+
+} // namespace pqbench
+
+#endif
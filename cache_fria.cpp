@@ -0,0 +1,228 @@
+#include "cache_fria.h"
+#include "cache_claves.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+#include <unistd.h>
+
+namespace pqbench {
+
+static const size_t LINEA_CACHE = 64;
+
+size_t tam_cache_llc() {
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    long bytes = ::sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if(bytes > 0) {
+        return static_cast<size_t>(bytes);
+    }
+#endif
+
+    // La caché de mayor nivel que indique sysfs, p. ej. "32768K"
+    size_t mayor = 0;
+    for(int indice = 0; indice < 8; ++indice) {
+        std::ifstream fichero("/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(indice) + "/size");
+        std::string texto;
+        if(!(fichero >> texto)) {
+            break;
+        }
+        char* fin = nullptr;
+        size_t bytes = std::strtoull(texto.c_str(), &fin, 10);
+        if(*fin == 'K') {
+            bytes *= 1024;
+        } else if(*fin == 'M') {
+            bytes *= 1024 * 1024;
+        }
+        mayor = std::max(mayor, bytes);
+    }
+    return mayor;
+}
+
+ExpulsorCache::ExpulsorCache(size_t bytes) : m_buffer(bytes, 1) {}
+
+void ExpulsorCache::expulsar() {
+    // Escribir en cada línea obliga a traerla en exclusiva y echa lo que hubiera
+    volatile uint8_t* datos = m_buffer.data();
+    for(size_t i = 0; i < m_buffer.size(); i += LINEA_CACHE) {
+        datos[i] = static_cast<uint8_t>(datos[i] + 1);
+    }
+}
+
+void vaciar_lineas(const void* puntero, size_t bytes) {
+#ifdef PQBENCH_TSC
+    auto inicio = reinterpret_cast<uintptr_t>(puntero) & ~(LINEA_CACHE - 1);
+    auto fin = reinterpret_cast<uintptr_t>(puntero) + bytes;
+    for(uintptr_t linea = inicio; linea < fin; linea += LINEA_CACHE) {
+        _mm_clflush(reinterpret_cast<const void*>(linea));
+    }
+    _mm_mfence();
+#else
+    (void)puntero;
+    (void)bytes;
+#endif
+}
+
+// ----- MODO cache-fria -----
+
+// Latencias de una operación en caliente y en frío
+struct ResultadoCacheFria {
+    const char* nombre;
+    Operacion caliente;
+    Operacion fria;
+};
+
+static void imprimir_cache_fria(const std::vector<ResultadoCacheFria>& resultados, std::ostream& salida) {
+    salida << columna("Operación", 14) << columna("Caché", 10) << columna("mín (s)", 13)
+           << columna("p50 (s)", 13) << columna("p90 (s)", 13) << columna("p99 (s)", 13)
+           << columna("máx (s)", 13) << columna("Ciclos p50", 14) << columna("Frío/cal.", 11) << "\n";
+
+    for(const auto& r : resultados) {
+        for(bool fria : {false, true}) {
+            const Operacion& o = fria ? r.fria : r.caliente;
+            const Estadisticas& e = o.segundos;
+            salida << columna(fria ? "" : r.nombre, 14) << columna(fria ? "fría" : "caliente", 10)
+                   << std::setw(13) << e.min << std::setw(13) << e.mediana << std::setw(13) << e.p90
+                   << std::setw(13) << e.p99 << std::setw(13) << e.max
+                   << std::setw(14) << static_cast<uint64_t>(o.ciclos.mediana);
+            if(fria && r.caliente.segundos.mediana > 0) {
+                salida << std::setw(10) << std::fixed << std::setprecision(2) << e.mediana / r.caliente.segundos.mediana
+                       << "x" << std::defaultfloat << std::setprecision(6);
+            }
+            salida << "\n";
+        }
+    }
+}
+
+int ejecutar_cache_fria(const Argumentos& args) {
+    if(args.posicionales().size() != 1) {
+        std::cerr << "Uso: ./pqbench cache-fria <set|familia|todos> [--buffer=bytes] [--keygen] [--prehash] [--iteraciones=100]"
+                     " [--calentamiento=N] [--outliers[=k]] [--cache-claves[=d]]\n";
+        return 1;
+    }
+
+    Opciones opciones = leer_opciones(args);
+    // Para comparar distribuciones hace falta más de una muestra
+    if(!args.activa("iteraciones")) {
+        opciones.iteraciones = 100;
+    }
+
+    size_t llc = tam_cache_llc();
+    long buffer = args.entero("buffer", llc > 0 ? static_cast<long>(2 * llc) : 64L * 1024 * 1024);
+    if(buffer < static_cast<long>(LINEA_CACHE)) {
+        std::cerr << "--buffer debe ser de al menos " << LINEA_CACHE << " bytes.\n";
+        return 1;
+    }
+
+    std::vector<Conjunto> elegidos = seleccionar(args.posicionales()[0], args.activa("prehash"));
+    if(elegidos.empty()) {
+        std::cerr << "Set de parámetros inválido.\n";
+        return 1;
+    }
+
+    ExpulsorCache expulsor(static_cast<size_t>(buffer));
+    std::cout << "LLC: " << (llc > 0 ? formatear_bytes(llc) : "desconocida") << " | buffer de expulsión: "
+              << formatear_bytes(expulsor.bytes()) << " | " << opciones.iteraciones << " muestras por operación\n\n";
+
+    const Botan::secure_vector<uint8_t>& msg = mensaje_fijo();
+    int fallos = 0;
+    for(const auto& conjunto : elegidos) {
+        try {
+            auto esquema = crear_esquema(conjunto);
+            Botan::AutoSeeded_RNG rng;
+            // Repetir el keygen de XMSS cientos de veces llevaría demasiado tiempo
+            bool con_keygen = conjunto.familia != Familia::XMSS || args.activa("keygen");
+
+            /*
+            Se registran los bloques que reservan la clave, el firmador y el verificador. Al
+            cerrar el registro se siguen quitando los que se liberan, así que durante las
+            mediciones en frío sólo se vacían bloques vivos.
+            */
+            empezar_registro_bloques();
+            ClaveObtenida obtenida = obtener_clave(*esquema, opciones);
+            auto pub_key = obtenida.clave->public_key();
+            Botan::PK_Signer signer(*obtenida.clave, rng, esquema->padding_firma(opciones.firma_determinista));
+            Botan::PK_Verifier verifier(*pub_key, esquema->padding_verificacion());
+            cerrar_registro_bloques();
+
+            std::vector<uint8_t> signature = signer.sign_message(msg, rng);
+            bool verificada = true;
+
+            std::unique_ptr<Botan::Private_Key> clave_nueva;
+            auto keygen = [&] { clave_nueva = esquema->generar_clave(rng); };
+            auto firmar = [&] {
+                signer.update(msg.data(), msg.size());
+                signature = signer.signature(rng);
+            };
+            auto verificar = [&] {
+                verifier.update(msg.data(), msg.size());
+                verificada = verifier.check_signature(signature.data(), signature.size()) && verificada;
+            };
+
+            RegistroBloques registro;
+            auto enfriar = [&] {
+                expulsor.expulsar();
+                registro = recorrer_bloques_registrados(vaciar_lineas);
+                vaciar_lineas(msg.data(), msg.size());
+                vaciar_lineas(signature.data(), signature.size());
+                vaciar_lineas(&signer, sizeof(signer));
+                vaciar_lineas(&verifier, sizeof(verifier));
+            };
+
+            // En frío se mide sólo la segunda fase; la expulsión queda fuera
+            ResultadoCacheFria r_keygen{"keygen", {}, {}}, r_firma{"firma", {}, {}}, r_verificacion{"verificación", {}, {}};
+            if(con_keygen) {
+                r_keygen.fria = muestrear_fases(opciones, enfriar, keygen)[1];
+            }
+            r_firma.fria = muestrear_fases(opciones, enfriar, firmar)[1];
+            r_verificacion.fria = muestrear_fases(opciones, enfriar, verificar)[1];
+
+            // A partir de aquí no se vacía nada: el registro ya no hace falta
+            terminar_registro_bloques();
+
+            // En caliente, una ejecución previa sin medir deja todo en caché
+            if(con_keygen) {
+                keygen();
+                r_keygen.caliente = muestrear(opciones, keygen);
+            }
+            firmar();
+            r_firma.caliente = muestrear(opciones, firmar);
+            verificar();
+            r_verificacion.caliente = muestrear(opciones, verificar);
+
+            std::vector<ResultadoCacheFria> resultados;
+            if(con_keygen) {
+                resultados.push_back(std::move(r_keygen));
+            }
+            resultados.push_back(std::move(r_firma));
+            resultados.push_back(std::move(r_verificacion));
+
+            if(!obtenida.ruta.empty()) {
+                guardar_clave_cacheada(obtenida.ruta, conjunto, opciones.semilla_claves, *obtenida.clave,
+                                       obtenida.keygen.segundos, obtenida.keygen.ciclos);
+            }
+
+            std::cout << "CACHÉ FRÍA FRENTE A CALIENTE EN " << conjunto.nombre << (conjunto.prehash ? " (pre-hash)" : "")
+                      << " | bloques vaciados con clflush: " << registro.bloques << " (" << formatear_bytes(registro.bytes) << ")"
+                      << (registro.perdidos > 0 ? " | [!] bloques sin registrar: " + std::to_string(registro.perdidos) : "") << "\n";
+            imprimir_cache_fria(resultados, std::cout);
+            if(!con_keygen) {
+                std::cout << "Keygen de XMSS no medido (--keygen para medirlo)\n";
+            }
+            if(!verificada) {
+                std::cout << "[!] Firma Errónea\n";
+                ++fallos;
+            }
+            std::cout << "\n";
+        } catch(const std::exception& e) {
+            terminar_registro_bloques();
+            std::cerr << "Excepción en cache-fria(" << conjunto.nombre << "): " << e.what() << "\n";
+            ++fallos;
+        }
+    }
+
+    return fallos == 0 ? 0 : 1;
+}
+
+} // namespace pqbench
@@ -0,0 +1,50 @@
+#ifndef PQBENCH_CACHE_FRIA_H
+#define PQBENCH_CACHE_FRIA_H
+
+#include "pqbench.h"
+
+/*
+Latencia con las cachés frías frente a calientes.
+
+En producción la firma se intercala con otras peticiones, así que entre una llamada y la
+siguiente el material de la clave, las tablas de Botan y el estado del hash suelen haber
+salido de la caché. Antes de cada keygen, firma o verificación medida en frío:
+- Se recorre un buffer mayor que la caché de último nivel (LLC), escribiendo una vez en
+  cada línea, para expulsar todo lo que hubiera en ella.
+- Se expulsan con clflush los bloques del montón de la clave, el firmador y el
+  verificador (registrados al construirlos, ver memoria.h), el mensaje y la firma.
+La medición en caliente repite la operación seguida, como hasta ahora.
+*/
+
+namespace pqbench {
+
+// Tamaño de la caché de último nivel en bytes, o 0 si no se conoce
+size_t tam_cache_llc();
+
+// Expulsa la caché recorriendo un buffer propio
+class ExpulsorCache {
+public:
+    explicit ExpulsorCache(size_t bytes);
+
+    void expulsar();
+    size_t bytes() const { return m_buffer.size(); }
+
+private:
+    std::vector<uint8_t> m_buffer;
+};
+
+// clflush de todas las líneas de caché del rango (no hace nada fuera de x86)
+void vaciar_lineas(const void* puntero, size_t bytes);
+
+/*
+Punto de entrada del modo desde la línea de comandos:
+  ./pqbench cache-fria <set|familia|todos> [--buffer=bytes] [--keygen] [--prehash] [--iteraciones=100]
+                       [--calentamiento=N] [--outliers[=k]] [--cache-claves[=d]]
+Por defecto el buffer es el doble de la LLC (64 MiB si no se conoce). El keygen de XMSS
+sólo se mide con --keygen.
+*/
+int ejecutar_cache_fria(const Argumentos& args);
+
+} // namespace pqbench
+
+#endif
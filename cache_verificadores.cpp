@@ -0,0 +1,327 @@
+#include "cache_verificadores.h"
+
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+#include <malloc.h>
+
+namespace pqbench {
+
+// Bytes en uso del montón según glibc
+static size_t bytes_en_uso() {
+    return mallinfo2().uordblks;
+}
+
+// ----- CACHÉ -----
+
+CacheVerificadores::CacheVerificadores(size_t max_entradas, size_t max_bytes) :
+    m_max_entradas(max_entradas), m_max_bytes(max_bytes) {}
+
+Botan::PK_Verifier& CacheVerificadores::obtener(const Esquema& esquema, std::span<const uint8_t> clave_publica) {
+    /*
+    El set forma parte de la clave: los mismos bytes no son la misma clave en otro set. Se
+    reutiliza el mismo buffer para no reservar memoria en cada acierto.
+    */
+    std::string& clave = m_busqueda;
+    clave.assign(esquema.conjunto().nombre);
+    clave.push_back('\0');
+    clave.append(clave_publica.begin(), clave_publica.end());
+
+    auto encontrada = m_indice.find(clave);
+    if(encontrada != m_indice.end()) {
+        ++m_aciertos;
+        Entrada& entrada = m_entradas[encontrada->second];
+        entrada.referenciada = true;
+        return *entrada.verifier;
+    }
+
+    ++m_fallos;
+
+    /*
+    La primera vez que aparece un set se mide cuánto ocupa su entrada en el montón y se
+    usa esa cifra para las demás entradas del mismo set.
+    */
+    const std::string& set = esquema.conjunto().nombre;
+    bool medir_set = !m_bytes_por_set.contains(set);
+    size_t antes = medir_set ? bytes_en_uso() : 0;
+
+    auto pub_key = esquema.cargar_clave_publica(clave_publica);
+    auto verifier = std::make_unique<Botan::PK_Verifier>(*pub_key, esquema.padding_verificacion());
+
+    if(medir_set) {
+        size_t despues = bytes_en_uso();
+        m_bytes_por_set[set] = despues > antes ? despues - antes : 0;
+    }
+    size_t bytes = m_bytes_por_set[set] + clave.size();
+
+    // Se expulsa hasta que la nueva entrada quepa (si no cabe ni sola, se queda sola)
+    while(m_ocupadas > 0 && ((m_max_entradas > 0 && m_ocupadas >= m_max_entradas) ||
+                             (m_max_bytes > 0 && m_bytes + bytes > m_max_bytes))) {
+        expulsar();
+    }
+
+    // Se reutiliza el hueco de una entrada expulsada o se añade uno nuevo
+    size_t posicion = m_entradas.size();
+    if(!m_libres.empty()) {
+        posicion = m_libres.back();
+        m_libres.pop_back();
+    } else {
+        m_entradas.emplace_back();
+    }
+
+    Entrada& entrada = m_entradas[posicion];
+    entrada.clave = clave;
+    entrada.pub_key = std::move(pub_key);
+    entrada.verifier = std::move(verifier);
+    entrada.bytes = bytes;
+    entrada.referenciada = false;
+    entrada.ocupada = true;
+
+    m_indice.emplace(clave, posicion);
+    ++m_ocupadas;
+    m_bytes += bytes;
+    return *entrada.verifier;
+}
+
+void CacheVerificadores::expulsar() {
+    for(;;) {
+        Entrada& entrada = m_entradas[m_manecilla];
+        m_manecilla = (m_manecilla + 1) % m_entradas.size();
+
+        if(!entrada.ocupada) {
+            continue;
+        }
+
+        // Segunda oportunidad para las entradas usadas desde la última vuelta
+        if(entrada.referenciada) {
+            entrada.referenciada = false;
+            continue;
+        }
+
+        m_indice.erase(entrada.clave);
+        m_bytes -= entrada.bytes;
+        --m_ocupadas;
+        ++m_expulsiones;
+        entrada = Entrada{};
+        m_libres.push_back(&entrada - m_entradas.data());
+        return;
+    }
+}
+
+EstadoCacheVerificadores CacheVerificadores::estado() const {
+    EstadoCacheVerificadores estado;
+    estado.aciertos = m_aciertos;
+    estado.fallos = m_fallos;
+    estado.expulsiones = m_expulsiones;
+    estado.entradas = m_ocupadas;
+    estado.bytes = m_bytes;
+    return estado;
+}
+
+size_t medir_bytes_verificador(const Esquema& esquema, std::span<const uint8_t> clave_publica, size_t muestras) {
+    std::vector<std::unique_ptr<Botan::Public_Key>> claves;
+    std::vector<std::unique_ptr<Botan::PK_Verifier>> verificadores;
+    claves.reserve(muestras);
+    verificadores.reserve(muestras);
+
+    size_t antes = bytes_en_uso();
+    for(size_t i = 0; i < muestras; ++i) {
+        claves.push_back(esquema.cargar_clave_publica(clave_publica));
+        verificadores.push_back(std::make_unique<Botan::PK_Verifier>(*claves.back(), esquema.padding_verificacion()));
+    }
+    size_t despues = bytes_en_uso();
+
+    return despues > antes ? (despues - antes) / std::max<size_t>(muestras, 1) : 0;
+}
+
+// ----- MODO cache-verificadores -----
+
+// Firmantes del banco de pruebas: su clave pública y la firma del mensaje fijo
+struct Firmante {
+    std::vector<uint8_t> clave_publica;
+    std::vector<uint8_t> firma;
+};
+
+/*
+Secuencia de firmantes con popularidad de Zipf: el firmante de rango k aparece con
+probabilidad proporcional a 1 / k^s. Los rangos se reparten al azar entre los firmantes.
+*/
+static std::vector<size_t> secuencia_zipf(size_t firmantes, size_t longitud, double s, uint64_t semilla) {
+    std::mt19937_64 aleatorio(semilla);
+
+    std::vector<double> acumulada(firmantes);
+    double total = 0;
+    for(size_t k = 0; k < firmantes; ++k) {
+        total += 1.0 / std::pow(static_cast<double>(k + 1), s);
+        acumulada[k] = total;
+    }
+
+    std::vector<size_t> rangos(firmantes);
+    std::iota(rangos.begin(), rangos.end(), 0);
+    std::shuffle(rangos.begin(), rangos.end(), aleatorio);
+
+    std::uniform_real_distribution<double> uniforme(0, total);
+    std::vector<size_t> secuencia(longitud);
+    for(auto& firmante : secuencia) {
+        size_t rango = std::lower_bound(acumulada.begin(), acumulada.end(), uniforme(aleatorio)) - acumulada.begin();
+        firmante = rangos[std::min(rango, firmantes - 1)];
+    }
+    return secuencia;
+}
+
+// Resultado de reproducir la secuencia con una capacidad de caché (0 = sin caché)
+struct ResultadoCacheVerificadores {
+    size_t capacidad = 0;
+    double segundos = 0;
+    uint64_t fallidas = 0;
+    EstadoCacheVerificadores estado;
+};
+
+static ResultadoCacheVerificadores reproducir(const Esquema& esquema, const std::vector<Firmante>& firmantes,
+                                              const std::vector<size_t>& secuencia, size_t capacidad, size_t max_bytes) {
+    const Botan::secure_vector<uint8_t>& msg = mensaje_fijo();
+
+    ResultadoCacheVerificadores resultado;
+    resultado.capacidad = capacidad;
+
+    auto verificar = [&](Botan::PK_Verifier& verifier, const Firmante& firmante) {
+        verifier.update(msg.data(), msg.size());
+        resultado.fallidas += !verifier.check_signature(firmante.firma.data(), firmante.firma.size());
+    };
+
+    auto inicio = std::chrono::steady_clock::now();
+    if(capacidad == 0) {
+        // Sin caché cada verificación decodifica la clave y construye su verificador
+        for(size_t i : secuencia) {
+            auto pub_key = esquema.cargar_clave_publica(firmantes[i].clave_publica);
+            Botan::PK_Verifier verifier(*pub_key, esquema.padding_verificacion());
+            verificar(verifier, firmantes[i]);
+        }
+    } else {
+        CacheVerificadores cache(capacidad, max_bytes);
+        for(size_t i : secuencia) {
+            verificar(cache.obtener(esquema, firmantes[i].clave_publica), firmantes[i]);
+        }
+        resultado.estado = cache.estado();
+    }
+    resultado.segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+
+    return resultado;
+}
+
+static void imprimir_cache(const std::vector<ResultadoCacheVerificadores>& resultados, size_t verificaciones,
+                           std::ostream& salida) {
+    salida << std::setw(12) << "Capacidad" << std::setw(11) << "Aciertos" << std::setw(13) << "Expulsiones"
+           << std::setw(14) << "Memoria" << std::setw(12) << "verif/s" << std::setw(13) << "Aceleración" << "\n";
+
+    double base = resultados.front().segundos;
+    for(const auto& r : resultados) {
+        const EstadoCacheVerificadores& e = r.estado;
+        double aciertos = e.aciertos + e.fallos > 0 ? 100.0 * e.aciertos / (e.aciertos + e.fallos) : 0;
+
+        salida << std::setw(12) << (r.capacidad == 0 ? "sin caché" : std::to_string(r.capacidad))
+               << std::setw(10) << std::fixed << std::setprecision(1) << aciertos << "%"
+               << std::setw(13) << e.expulsiones << std::setw(14) << formatear_bytes(e.bytes)
+               << std::setw(12) << (r.segundos > 0 ? verificaciones / r.segundos : 0)
+               << std::setw(13) << std::setprecision(2) << (r.segundos > 0 ? base / r.segundos : 0)
+               << std::defaultfloat << std::setprecision(6)
+               << (r.fallidas > 0 ? "  [!] Firmas no verificadas: " + std::to_string(r.fallidas) : "") << "\n";
+    }
+}
+
+int ejecutar_cache_verificadores(const Argumentos& args) {
+    if(args.posicionales().size() != 1) {
+        std::cerr << "Uso: ./pqbench cache-verificadores <set|familia|todos> [--firmantes=200] [--verificaciones=20000]"
+                     " [--zipf=1.0] [--capacidades=F/16,F/4,F] [--bytes=0] [--prehash]\n";
+        return 1;
+    }
+
+    long firmantes = args.entero("firmantes", 200);
+    long verificaciones = args.entero("verificaciones", 20000);
+    double zipf = args.real("zipf", 1.0);
+    long max_bytes = args.entero("bytes", 0);
+    std::vector<long> capacidades = args.enteros("capacidades", {std::max(firmantes / 16, 1L), std::max(firmantes / 4, 1L), firmantes});
+
+    if(firmantes < 1 || verificaciones < 1 || zipf < 0 || max_bytes < 0 ||
+       std::any_of(capacidades.begin(), capacidades.end(), [](long c) { return c < 1; })) {
+        std::cerr << "Opciones inválidas para el modo cache-verificadores.\n";
+        return 1;
+    }
+
+    std::vector<Conjunto> elegidos = seleccionar(args.posicionales()[0], args.activa("prehash"));
+    if(elegidos.empty()) {
+        std::cerr << "Set de parámetros inválido.\n";
+        return 1;
+    }
+
+    // La misma secuencia de firmantes para todos los sets y capacidades
+    std::vector<size_t> secuencia = secuencia_zipf(firmantes, verificaciones, zipf, 0);
+
+    int fallos = 0;
+    for(const auto& conjunto : elegidos) {
+        // Cada firmante necesita su propio keygen, y en XMSS con altura 20 cada uno tarda minutos
+        if(conjunto.familia == Familia::XMSS) {
+            std::cout << "Se omite " << conjunto.nombre << ": generar una clave XMSS por firmante es demasiado lento.\n\n";
+            continue;
+        }
+
+        try {
+            auto esquema = crear_esquema(conjunto);
+            const Botan::secure_vector<uint8_t>& msg = mensaje_fijo();
+
+            Botan::AutoSeeded_RNG rng;
+            std::vector<Firmante> banco(firmantes);
+            for(auto& firmante : banco) {
+                auto clave = esquema->generar_clave(rng);
+                firmante.clave_publica = clave->public_key_bits();
+                Botan::PK_Signer signer(*clave, rng, esquema->padding_firma());
+                firmante.firma = signer.sign_message(msg, rng);
+            }
+
+            // Cuánto de cada verificación es preparar el verificador y cuánto check_signature
+            std::vector<double> preparar, comprobar;
+            for(size_t i = 0; i < std::min<size_t>(banco.size(), 32); ++i) {
+                std::unique_ptr<Botan::Public_Key> pub_key;
+                std::unique_ptr<Botan::PK_Verifier> verifier;
+                preparar.push_back(medir([&] {
+                    pub_key = esquema->cargar_clave_publica(banco[i].clave_publica);
+                    verifier = std::make_unique<Botan::PK_Verifier>(*pub_key, esquema->padding_verificacion());
+                }).segundos);
+                comprobar.push_back(medir([&] {
+                    verifier->update(msg.data(), msg.size());
+                    verifier->check_signature(banco[i].firma.data(), banco[i].firma.size());
+                }).segundos);
+            }
+
+            std::cout << "CACHÉ DE VERIFICADORES DE " << conjunto.nombre << (conjunto.prehash ? " (pre-hash)" : "")
+                      << " | " << firmantes << " firmantes | " << verificaciones << " verificaciones | Zipf s = " << zipf
+                      << (max_bytes > 0 ? " | límite de " + formatear_bytes(max_bytes) : "") << "\n"
+                      << "Decodificar clave + construir PK_Verifier (p50): " << calcular_estadisticas(preparar).mediana << " s\n"
+                      << "check_signature (p50): " << calcular_estadisticas(comprobar).mediana << " s\n"
+                      << "Memoria por entrada: " << formatear_bytes(medir_bytes_verificador(*esquema, banco[0].clave_publica))
+                      << " (clave pública serializada: " << formatear_bytes(banco[0].clave_publica.size()) << ")\n";
+
+            std::vector<ResultadoCacheVerificadores> resultados;
+            resultados.push_back(reproducir(*esquema, banco, secuencia, 0, 0));
+            for(long capacidad : capacidades) {
+                resultados.push_back(reproducir(*esquema, banco, secuencia, capacidad, max_bytes));
+            }
+
+            imprimir_cache(resultados, verificaciones, std::cout);
+            std::cout << "\n";
+
+            fallos += std::any_of(resultados.begin(), resultados.end(),
+                                  [](const ResultadoCacheVerificadores& r) { return r.fallidas > 0; });
+        } catch(const std::exception& e) {
+            std::cerr << "Excepción en cache-verificadores(" << conjunto.nombre << "): " << e.what() << "\n";
+            ++fallos;
+        }
+    }
+
+    return fallos == 0 ? 0 : 1;
+}
+
+} // namespace pqbench
@@ -0,0 +1,95 @@
+#ifndef PQBENCH_CACHE_VERIFICADORES_H
+#define PQBENCH_CACHE_VERIFICADORES_H
+
+#include "pqbench.h"
+
+#include <unordered_map>
+
+/*
+Caché de verificadores para verificar firmas de muchos firmantes distintos.
+
+Con miles de firmantes, decodificar cada clave pública y construir su PK_Verifier puede
+costar más que check_signature (en ML-DSA incluye expandir la matriz pública). La caché
+guarda, para cada public_key_bits() ya visto, la clave decodificada y su verificador
+listo para usar.
+
+La expulsión sigue el algoritmo CLOCK, una aproximación de LRU: cada entrada tiene un
+bit de referencia que se activa al usarla, y la manecilla recorre las entradas quitando
+el bit a las usadas y expulsando la primera que no lo tenga. Un acierto sólo activa el
+bit, sin reordenar ninguna lista.
+
+La capacidad se limita en entradas y en bytes. Los bytes de cada entrada son los que
+ocupa en el montón una clave pública decodificada con su verificador, medidos al crear
+la primera entrada de cada set. El verificador devuelto sólo es válido hasta la
+siguiente llamada a obtener(), que puede expulsarlo.
+
+No es segura entre hilos: cada hilo verificador tiene su propia caché.
+*/
+
+namespace pqbench {
+
+// Contadores de la caché desde que se creó
+struct EstadoCacheVerificadores {
+    uint64_t aciertos = 0;
+    uint64_t fallos = 0;
+    uint64_t expulsiones = 0;
+    size_t entradas = 0;
+    size_t bytes = 0;
+};
+
+class CacheVerificadores {
+public:
+    // 0 en cualquiera de los límites = sin límite en esa dimensión
+    CacheVerificadores(size_t max_entradas, size_t max_bytes);
+
+    // Verificador de la clave pública; la decodifica y lo construye si no está en la caché
+    Botan::PK_Verifier& obtener(const Esquema& esquema, std::span<const uint8_t> clave_publica);
+
+    EstadoCacheVerificadores estado() const;
+
+private:
+    struct Entrada {
+        std::string clave;                       // Set y public_key_bits()
+        std::unique_ptr<Botan::Public_Key> pub_key;
+        std::unique_ptr<Botan::PK_Verifier> verifier;
+        size_t bytes = 0;
+        bool referenciada = false;
+        bool ocupada = false;
+    };
+
+    size_t bytes_entrada(const Esquema& esquema);
+    void expulsar();
+
+    size_t m_max_entradas;
+    size_t m_max_bytes;
+    std::vector<Entrada> m_entradas;
+    std::vector<size_t> m_libres; // Huecos de entradas expulsadas
+    std::unordered_map<std::string, size_t> m_indice;
+    std::string m_busqueda; // Buffer de la clave que se busca
+    std::unordered_map<std::string, size_t> m_bytes_por_set;
+    size_t m_manecilla = 0;
+    size_t m_ocupadas = 0;
+    size_t m_bytes = 0;
+
+    uint64_t m_aciertos = 0;
+    uint64_t m_fallos = 0;
+    uint64_t m_expulsiones = 0;
+};
+
+/*
+Bytes del montón que ocupa una clave pública decodificada con su PK_Verifier, de media
+sobre `muestras` claves (según mallinfo2 de glibc).
+*/
+size_t medir_bytes_verificador(const Esquema& esquema, std::span<const uint8_t> clave_publica, size_t muestras = 32);
+
+/*
+Punto de entrada del modo desde la línea de comandos:
+  ./pqbench cache-verificadores <set|familia|todos> [--firmantes=200] [--verificaciones=20000]
+                                [--zipf=1.0] [--capacidades=F/16,F/4,F] [--bytes=0] [--prehash]
+Los sets de XMSS se omiten: hace falta una clave nueva por firmante.
+*/
+int ejecutar_cache_verificadores(const Argumentos& args);
+
+} // namespace pqbench
+
+#endif
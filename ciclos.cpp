@@ -0,0 +1,194 @@
+#include "ciclos.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <vector>
+
+#ifdef PQBENCH_TSC
+#include <cpuid.h>
+#endif
+
+namespace pqbench {
+
+// Busca en /proc/cpuinfo el primer valor del campo indicado
+static std::string campo_cpuinfo(const std::string& campo) {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string linea;
+    while(std::getline(cpuinfo, linea)) {
+        if(linea.rfind(campo, 0) == 0) {
+            auto separador = linea.find(':');
+            if(separador != std::string::npos) {
+                return linea.substr(separador + 1);
+            }
+        }
+    }
+    return "";
+}
+
+#ifdef PQBENCH_TSC
+
+// Bit 8 de EDX en la hoja 0x80000007 de CPUID: TSC invariante
+static bool cpuid_tsc_invariante(bool& disponible) {
+    unsigned int eax, ebx, ecx, edx;
+    disponible = __get_cpuid_max(0x80000000, nullptr) >= 0x80000007 &&
+                 __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return disponible && (edx & (1u << 8));
+}
+
+/*
+Frecuencia del TSC según CPUID:
+- Hoja 0x15: relación TSC/cristal y frecuencia del cristal (procesadores Intel recientes).
+- Hoja 0x16: frecuencia base en MHz, que coincide con la del TSC en Intel.
+*/
+static double cpuid_frecuencia_tsc(std::string& fuente) {
+    unsigned int maximo = __get_cpuid_max(0, nullptr);
+    unsigned int eax, ebx, ecx, edx;
+
+    if(maximo >= 0x15 && __get_cpuid_count(0x15, 0, &eax, &ebx, &ecx, &edx) && eax != 0 && ebx != 0 && ecx != 0) {
+        fuente = "CPUID 0x15";
+        return static_cast<double>(ecx) * ebx / eax;
+    }
+
+    if(maximo >= 0x16 && __get_cpuid_count(0x16, 0, &eax, &ebx, &ecx, &edx) && (eax & 0xFFFF) != 0) {
+        fuente = "CPUID 0x16";
+        return (eax & 0xFFFF) * 1e6;
+    }
+
+    return 0;
+}
+
+/*
+Estima cuántos ciclos de núcleo corresponden a cada ciclo de referencia. El bucle
+dec/jnz ejecuta una iteración por ciclo de núcleo en los procesadores x86 actuales,
+así que basta con comparar el número de iteraciones con los ciclos del TSC.
+*/
+static double medir_ratio_nucleo() {
+    auto bucle = [](uint64_t iteraciones) {
+        asm volatile("1: dec %0\n\tjnz 1b" : "+r"(iteraciones) :: "cc");
+    };
+
+    const uint64_t iteraciones = 20'000'000;
+    bucle(iteraciones); // Calentamiento para que el núcleo alcance su frecuencia
+
+    std::vector<double> ratios;
+    for(int i = 0; i < 5; ++i) {
+        uint64_t inicio = ciclos_inicio();
+        bucle(iteraciones);
+        uint64_t fin = ciclos_fin();
+        ratios.push_back(static_cast<double>(iteraciones) / (fin - inicio));
+    }
+
+    std::sort(ratios.begin(), ratios.end());
+    return ratios[ratios.size() / 2];
+}
+
+#endif
+
+// Frecuencia nominal que aparece en el nombre del modelo ("... @ 2.80GHz")
+static double cpuinfo_frecuencia_nominal() {
+    std::string modelo = campo_cpuinfo("model name");
+    auto arroba = modelo.find('@');
+    auto ghz = modelo.find("GHz");
+    if(arroba == std::string::npos || ghz == std::string::npos || ghz < arroba) {
+        return 0;
+    }
+
+    try {
+        return std::stod(modelo.substr(arroba + 1, ghz - arroba - 1)) * 1e9;
+    } catch(const std::exception&) {
+        return 0;
+    }
+}
+
+static InfoContador calibrar() {
+    InfoContador info;
+
+#ifdef PQBENCH_TSC
+    info.tsc = true;
+
+    // ---------------- TSC INVARIANTE ----------------
+    bool cpuid_disponible = false;
+    info.invariante = cpuid_tsc_invariante(cpuid_disponible);
+    info.fuente_invariante = "CPUID 0x80000007";
+
+    if(!cpuid_disponible) {
+        std::string flags = campo_cpuinfo("flags");
+        info.invariante = flags.find("constant_tsc") != std::string::npos &&
+                          flags.find("nonstop_tsc") != std::string::npos;
+        info.fuente_invariante = "/proc/cpuinfo";
+    }
+
+    // ---------------- SOBRECARGA DE LA MEDICIÓN ----------------
+    // Mínimo de muchas mediciones vacías: lo que cuesta siempre el propio contador
+    uint64_t sobrecarga = UINT64_MAX;
+    for(int i = 0; i < 10000; ++i) {
+        uint64_t inicio = ciclos_inicio();
+        uint64_t fin = ciclos_fin();
+        sobrecarga = std::min(sobrecarga, fin - inicio);
+    }
+    info.sobrecarga = sobrecarga;
+
+    // ---------------- FRECUENCIA DEL TSC ----------------
+    auto t_inicio = std::chrono::steady_clock::now();
+    uint64_t c_inicio = ciclos_inicio();
+    while(std::chrono::steady_clock::now() - t_inicio < std::chrono::milliseconds(50)) {}
+    uint64_t c_fin = ciclos_fin();
+    auto t_fin = std::chrono::steady_clock::now();
+    info.frecuencia_tsc_medida = (c_fin - c_inicio) / std::chrono::duration<double>(t_fin - t_inicio).count();
+
+    info.frecuencia_tsc = cpuid_frecuencia_tsc(info.fuente_frecuencia);
+    if(info.frecuencia_tsc == 0) {
+        info.frecuencia_tsc = cpuinfo_frecuencia_nominal();
+        info.fuente_frecuencia = "/proc/cpuinfo (model name)";
+    }
+    if(info.frecuencia_tsc == 0) {
+        info.frecuencia_tsc = info.frecuencia_tsc_medida;
+        info.fuente_frecuencia = "medida";
+    }
+
+    // ---------------- RELACIÓN CON LOS CICLOS DE NÚCLEO ----------------
+    info.ratio_nucleo = medir_ratio_nucleo();
+#else
+    info.frecuencia_tsc = 1e9;
+    info.frecuencia_tsc_medida = 1e9;
+    info.fuente_frecuencia = "reloj monotónico (ns)";
+    info.fuente_invariante = "no aplica";
+#endif
+
+    return info;
+}
+
+const InfoContador& contador() {
+    static const InfoContador info = calibrar();
+    return info;
+}
+
+double a_ciclos_nucleo(double ciclos_referencia) {
+    return ciclos_referencia * contador().ratio_nucleo;
+}
+
+void imprimir_contador(std::ostream& salida) {
+    const InfoContador& info = contador();
+
+    salida << "CONTADOR DE CICLOS\n";
+    if(!info.tsc) {
+        salida << "Sin TSC: los ciclos son nanosegundos del reloj monotónico\n\n";
+        return;
+    }
+
+    salida << "Lectura serializada: lfence/rdtsc - rdtscp/lfence\n"
+           << "TSC invariante: " << (info.invariante ? "Sí" : "No") << " (" << info.fuente_invariante << ")\n"
+           << "Frecuencia del TSC: " << info.frecuencia_tsc / 1e6 << " MHz (" << info.fuente_frecuencia << "), "
+           << info.frecuencia_tsc_medida / 1e6 << " MHz medida\n"
+           << "Sobrecarga de la medición: " << info.sobrecarga << " ciclos (se resta)\n"
+           << "Ciclos de núcleo por ciclo de referencia: " << info.ratio_nucleo
+           << " (~" << info.ratio_nucleo * info.frecuencia_tsc_medida / 1e6 << " MHz de núcleo)\n";
+
+    if(!info.invariante) {
+        salida << "[!] El TSC no es invariante: los ciclos dependen de la frecuencia y de los estados de reposo\n";
+    }
+    salida << "\n";
+}
+
+} // namespace pqbench
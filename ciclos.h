@@ -0,0 +1,82 @@
+#ifndef PQBENCH_CICLOS_H
+#define PQBENCH_CICLOS_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PQBENCH_TSC 1
+#else
+#include <chrono>
+#endif
+
+/*
+Contador de ciclos de CPU.
+
+En x86 se lee el TSC (contador de ciclos de referencia) de forma serializada para que
+el procesador no adelante ni retrase instrucciones del código medido fuera de la
+ventana de medición:
+- ciclos_inicio(): lfence; rdtsc; lfence
+- ciclos_fin():    rdtscp; lfence
+
+Al arrancar se calibra el coste de una medición vacía, que se resta a cada medición,
+y se detecta si el TSC es invariante, su frecuencia y la relación con la frecuencia
+real del núcleo. En otras arquitecturas se usa el reloj monotónico en nanosegundos.
+*/
+
+namespace pqbench {
+
+inline uint64_t ciclos_inicio() {
+#ifdef PQBENCH_TSC
+    _mm_lfence();
+    uint64_t ciclos = __rdtsc();
+    _mm_lfence();
+    return ciclos;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+inline uint64_t ciclos_fin() {
+#ifdef PQBENCH_TSC
+    unsigned int procesador;
+    uint64_t ciclos = __rdtscp(&procesador);
+    _mm_lfence();
+    return ciclos;
+#else
+    return ciclos_inicio();
+#endif
+}
+
+// Características del contador de ciclos, detectadas y calibradas una sola vez
+struct InfoContador {
+    bool tsc = false;                   // false: no hay TSC y se cuentan nanosegundos
+    bool invariante = false;            // El TSC avanza a ritmo constante (no depende de la frecuencia ni de estados de reposo)
+    std::string fuente_invariante;
+    double frecuencia_tsc = 0;          // Hz
+    std::string fuente_frecuencia;
+    double frecuencia_tsc_medida = 0;   // Hz, medida contra el reloj monotónico
+    double ratio_nucleo = 0;            // Ciclos de núcleo por ciclo de referencia (0 si no se conoce)
+    uint64_t sobrecarga = 0;            // Ciclos que cuesta una medición vacía
+};
+
+// Devuelve la información del contador. La primera llamada hace la calibración (~0.1 s).
+const InfoContador& contador();
+
+// Resta a una medición la sobrecarga calibrada del propio contador
+inline uint64_t restar_sobrecarga(uint64_t ciclos) {
+    uint64_t sobrecarga = contador().sobrecarga;
+    return ciclos > sobrecarga ? ciclos - sobrecarga : 0;
+}
+
+// Convierte ciclos de referencia (TSC) a ciclos de núcleo estimados
+double a_ciclos_nucleo(double ciclos_referencia);
+
+void imprimir_contador(std::ostream& salida);
+
+} // namespace pqbench
+
+#endif
@@ -0,0 +1,437 @@
+#include "comparar.h"
+#include "cache_claves.h"
+
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+namespace pqbench {
+
+// Campos de una línea CSV; admite campos entre comillas con "" como comilla escapada
+static std::vector<std::string> dividir_csv(const std::string& linea) {
+    std::vector<std::string> campos(1);
+    bool entre_comillas = false;
+    for(size_t i = 0; i < linea.size(); ++i) {
+        char c = linea[i];
+        if(entre_comillas) {
+            if(c == '"' && i + 1 < linea.size() && linea[i + 1] == '"') {
+                campos.back() += '"';
+                ++i;
+            } else if(c == '"') {
+                entre_comillas = false;
+            } else {
+                campos.back() += c;
+            }
+        } else if(c == '"') {
+            entre_comillas = true;
+        } else if(c == ',') {
+            campos.emplace_back();
+        } else if(c != '\r') {
+            campos.back() += c;
+        }
+    }
+    return campos;
+}
+
+// Número de un campo, o nullopt si no lo es (p. ej. "N/A")
+static std::optional<double> leer_numero(const std::string& texto) {
+    try {
+        size_t leidos = 0;
+        double valor = std::stod(texto, &leidos);
+        if(leidos == texto.size()) {
+            return valor;
+        }
+    } catch(const std::exception&) {}
+    return std::nullopt;
+}
+
+std::vector<ReferenciaOperacion> leer_referencia(const std::string& fichero) {
+    std::ifstream entrada(fichero);
+    if(!entrada) {
+        throw std::runtime_error("No se puede abrir " + fichero);
+    }
+
+    std::string linea;
+    std::getline(entrada, linea);
+    std::vector<std::string> cabeceras = dividir_csv(linea);
+    auto columna_de = [&](const std::string& nombre) -> long {
+        auto it = std::find(cabeceras.begin(), cabeceras.end(), nombre);
+        return it == cabeceras.end() ? -1 : it - cabeceras.begin();
+    };
+
+    long parametro = columna_de("Parametro");
+    long prehash = columna_de("Prehash");
+    if(parametro < 0 || prehash < 0) {
+        throw std::runtime_error(fichero + ": faltan las columnas Parametro y Prehash");
+    }
+
+    // Un CSV de muestras tiene una fila por muestra; uno de resultados, una columna por operación
+    long operacion = columna_de("Operacion");
+    long segundos = columna_de("Segundos");
+    bool de_muestras = operacion >= 0 && segundos >= 0;
+
+    const std::pair<const char*, const char*> columnas_tiempo[] = {
+        {"keygen", "Keygen_tiempo"}, {"firma", "Firma_tiempo"}, {"verificacion", "Verificacion_tiempo"}};
+    std::vector<std::pair<std::string, long>> tiempos;
+    if(!de_muestras) {
+        for(const auto& [nombre, columna] : columnas_tiempo) {
+            if(columna_de(columna) < 0) {
+                throw std::runtime_error(fichero + ": falta la columna " + columna);
+            }
+            tiempos.emplace_back(nombre, columna_de(columna));
+        }
+    }
+    long estado = columna_de("Estado");
+
+    /*
+    Los CSV anteriores a la columna Estado salen de los programas originales, que medían el
+    keygen junto con la construcción del PK_Signer y la verificación junto con public_key()
+    y la construcción del PK_Verifier. Se comparan con la suma de las fases equivalentes.
+    */
+    if(!de_muestras && estado < 0) {
+        tiempos[0].first = OPERACION_KEYGEN_FIRMADOR;
+        tiempos[2].first = OPERACION_VERIFICADOR_VERIFICACION;
+    }
+
+    std::vector<ReferenciaOperacion> referencias;
+    auto buscar = [&](const std::string& p, bool ph, const std::string& op) -> ReferenciaOperacion& {
+        for(auto& r : referencias) {
+            if(r.parametro == p && r.prehash == ph && r.operacion == op) {
+                return r;
+            }
+        }
+        referencias.push_back({p, ph, op, {}});
+        return referencias.back();
+    };
+
+    while(std::getline(entrada, linea)) {
+        std::vector<std::string> campos = dividir_csv(linea);
+        if(campos.size() < cabeceras.size()) {
+            continue;
+        }
+
+        // Las filas de sets que fallaron o no terminaron no sirven como referencia
+        if(estado >= 0 && campos[estado] != "OK") {
+            continue;
+        }
+
+        const std::string& p = campos[parametro];
+        bool ph = campos[prehash] == "Sí";
+        if(de_muestras) {
+            if(auto valor = leer_numero(campos[segundos])) {
+                buscar(p, ph, campos[operacion]).segundos.push_back(*valor);
+            }
+        } else {
+            for(const auto& [nombre, columna] : tiempos) {
+                if(auto valor = leer_numero(campos[columna])) {
+                    buscar(p, ph, nombre).segundos.push_back(*valor);
+                }
+            }
+        }
+    }
+
+    return referencias;
+}
+
+static Comparacion comparar(const ReferenciaOperacion& referencia, std::vector<double> actual,
+                            double umbral, double confianza, size_t remuestreos) {
+    Comparacion c;
+    c.parametro = referencia.parametro;
+    c.prehash = referencia.prehash;
+    c.operacion = referencia.operacion;
+
+    std::vector<double> base = referencia.segundos;
+    c.base = calcular_estadisticas(base).mediana;
+    c.actual = calcular_estadisticas(actual).mediana;
+    c.cambio = c.base > 0 ? c.actual / c.base - 1 : 0;
+
+    Intervalo cociente = bootstrap_cociente_medianas(base, actual, confianza, remuestreos);
+    c.intervalo = {cociente.inferior - 1, cociente.superior - 1};
+
+    // Con una sola muestra en la referencia sólo se puede usar el intervalo
+    bool significativo = c.intervalo.inferior > 0 || c.intervalo.superior < 0;
+    if(base.size() > 1) {
+        c.p = mann_whitney_p(base, actual);
+        significativo = significativo && c.p < 1 - confianza;
+    }
+
+    if(significativo && std::abs(c.cambio) >= umbral) {
+        c.veredicto = c.cambio > 0 ? 1 : -1;
+    }
+    return c;
+}
+
+static std::string porcentaje(double valor) {
+    std::ostringstream texto;
+    texto << std::showpos << std::fixed << std::setprecision(1) << 100 * valor << " %";
+    return texto.str();
+}
+
+static void imprimir_comparaciones(std::vector<Comparacion> comparaciones, double confianza, std::ostream& salida) {
+    // De peor a mejor cambio, para que las regresiones salgan arriba
+    std::sort(comparaciones.begin(), comparaciones.end(),
+              [](const Comparacion& a, const Comparacion& b) { return a.cambio > b.cambio; });
+
+    std::ostringstream titulo_intervalo;
+    titulo_intervalo << "IC " << 100 * confianza << " %";
+
+    // "Operación" ocupa un byte más de lo que se ve, así que se rellena a mano
+    salida << std::left << std::setw(34) << "Set" << "Operación" << std::string(17, ' ') << std::right
+           << columna("Referencia", 13) << columna("Actual", 13) << columna("Cambio", 10)
+           << columna(titulo_intervalo.str(), 22) << columna("p", 10) << "  Veredicto\n";
+
+    for(const auto& c : comparaciones) {
+        std::ostringstream intervalo;
+        intervalo << "[" << porcentaje(c.intervalo.inferior) << ", " << porcentaje(c.intervalo.superior) << "]";
+
+        std::ostringstream p;
+        if(c.p >= 0) {
+            p << std::setprecision(2) << c.p;
+        } else {
+            p << "-";
+        }
+
+        std::ostringstream base, actual;
+        base << c.base << "s";
+        actual << c.actual << "s";
+
+        const char* veredicto = c.veredicto > 0 ? "REGRESIÓN" : c.veredicto < 0 ? "mejora" : "=";
+        salida << std::left << std::setw(34) << c.parametro + (c.prehash ? " (pre-hash)" : "")
+               << std::setw(26) << c.operacion << std::right
+               << columna(base.str(), 13) << columna(actual.str(), 13) << columna(porcentaje(c.cambio), 10)
+               << columna(intervalo.str(), 22) << columna(p.str(), 10) << "  " << veredicto << "\n";
+    }
+}
+
+// Tiempos de las muestras de una operación
+static std::vector<double> tiempos(const Operacion& operacion) {
+    std::vector<double> segundos;
+    for(const auto& m : operacion.muestras) {
+        segundos.push_back(m.segundos);
+    }
+    return segundos;
+}
+
+// Suma muestra a muestra de dos fases tomadas juntas con muestrear_fases()
+static std::vector<double> tiempos_sumados(const Operacion& primera, const Operacion& segunda) {
+    std::vector<double> segundos = tiempos(primera);
+    if(segunda.muestras.size() != segundos.size()) {
+        return {};
+    }
+    for(size_t i = 0; i < segundos.size(); ++i) {
+        segundos[i] += segunda.muestras[i].segundos;
+    }
+    return segundos;
+}
+
+// Muestras conservadas (sin los atípicos, con el mismo criterio que resumir())
+static std::vector<double> tiempos_conservados(const std::vector<double>& tiempos, double umbral_outliers) {
+    auto conservar = filtrar_outliers_mad(tiempos, umbral_outliers);
+    std::vector<double> conservados;
+    for(size_t i = 0; i < tiempos.size(); ++i) {
+        if(conservar[i]) {
+            conservados.push_back(tiempos[i]);
+        }
+    }
+    return conservados;
+}
+
+// Mínimo de muestras con el que se compara un set; si no caben en el presupuesto se omite
+static const size_t MIN_MUESTRAS = 5;
+
+/*
+Segundos de una iteración de evaluar() según las medianas de la referencia: una firma,
+una verificación y el keygen si se vuelve a medir. Es 0 si la referencia no los tiene.
+*/
+static double coste_iteracion(const std::vector<ReferenciaOperacion>& referencias, const std::string& parametro,
+                              bool prehash, bool con_keygen) {
+    double coste = 0;
+    for(const auto& r : referencias) {
+        if(r.parametro == parametro && r.prehash == prehash && !r.segundos.empty() &&
+           (r.operacion.rfind("keygen", 0) != 0 || con_keygen)) {
+            coste += calcular_estadisticas(r.segundos).mediana;
+        }
+    }
+    return coste;
+}
+
+int ejecutar_comparar(const Argumentos& args) {
+    if(args.posicionales().empty()) {
+        std::cerr << "Uso: ./pqbench comparar <referencia.csv>... [--umbral=5] [--confianza=0.95] [--remuestreos=2000]"
+                     " [--sets=ML-DSA,...] [--keygen] [--guardar=muestras.csv] [--iteraciones=30] [--presupuesto=600]"
+                     " [--outliers[=k]]\n";
+        return 1;
+    }
+
+    Opciones opciones = leer_opciones(args);
+    // Para comparar distribuciones hace falta más de una muestra
+    if(!args.activa("iteraciones")) {
+        opciones.iteraciones = 30;
+    }
+
+    double umbral = args.real("umbral", 5) / 100;
+    double confianza = args.real("confianza", 0.95);
+    long remuestreos = args.entero("remuestreos", 2000);
+    double presupuesto = args.real("presupuesto", 600);
+    if(umbral < 0 || confianza <= 0 || confianza >= 1 || remuestreos < 100 || presupuesto <= 0) {
+        std::cerr << "--umbral debe ser >= 0, --confianza estar entre 0 y 1, --remuestreos ser >= 100"
+                     " y --presupuesto > 0\n";
+        return 1;
+    }
+
+    // Si una operación está en varias referencias se compara una sola vez, con la del primer fichero
+    std::vector<ReferenciaOperacion> referencias;
+    size_t repetidas = 0;
+    for(const auto& fichero : args.posicionales()) {
+        for(auto& leida : leer_referencia(fichero)) {
+            bool repetida = std::any_of(referencias.begin(), referencias.end(), [&](const ReferenciaOperacion& r) {
+                return r.parametro == leida.parametro && r.prehash == leida.prehash && r.operacion == leida.operacion;
+            });
+            if(repetida) {
+                ++repetidas;
+            } else {
+                referencias.push_back(std::move(leida));
+            }
+        }
+    }
+    if(repetidas > 0) {
+        std::cerr << "[!] " << repetidas << " operaciones están en más de una referencia: se usa la del primer fichero\n";
+    }
+
+    // --sets filtra por prefijo del nombre: "ML-DSA" deja todos los de ML-DSA
+    std::vector<std::string> filtro = args.textos("sets", {});
+    std::erase_if(referencias, [&](const ReferenciaOperacion& r) {
+        return !filtro.empty() && std::none_of(filtro.begin(), filtro.end(),
+            [&](const std::string& prefijo) { return r.parametro.rfind(prefijo, 0) == 0; });
+    });
+
+    // Sets a evaluar, en el orden de la referencia
+    std::vector<std::pair<std::string, bool>> sets;
+    for(const auto& r : referencias) {
+        if(std::find(sets.begin(), sets.end(), std::make_pair(r.parametro, r.prehash)) == sets.end()) {
+            sets.emplace_back(r.parametro, r.prehash);
+        }
+    }
+    if(sets.empty()) {
+        std::cerr << "La referencia no tiene ningún set que comparar.\n";
+        return 1;
+    }
+
+    std::cout << "Referencia: " << referencias.size() << " operaciones de " << sets.size() << " sets | "
+              << opciones.iteraciones << " muestras por operación | presupuesto " << presupuesto << " s por set | umbral "
+              << 100 * umbral << " % | confianza " << 100 * confianza << " %\n\n";
+
+    std::ofstream guardar;
+    if(args.activa("guardar")) {
+        guardar.open(args.texto("guardar", "muestras.csv"));
+        if(!guardar) {
+            std::cerr << "No se puede crear " << args.texto("guardar", "muestras.csv") << "\n";
+            return 1;
+        }
+        guardar << "Parametro,Prehash,Operacion,Segundos\n" << std::setprecision(9);
+    }
+
+    int fallos = 0;
+    size_t omitidos = 0;
+    std::vector<Comparacion> comparaciones;
+    for(const auto& [parametro, prehash] : sets) {
+        try {
+            Conjunto conjunto = buscar_conjunto(parametro, prehash);
+            auto esquema = crear_esquema(conjunto);
+
+            // Repetir el keygen de XMSS decenas de veces llevaría horas: se usa la caché
+            Opciones opciones_set = opciones;
+            bool con_keygen = conjunto.familia != Familia::XMSS || args.activa("keygen");
+            if(!con_keygen && opciones_set.cache_claves.empty()) {
+                opciones_set.cache_claves = ".pqbench-claves";
+            }
+
+            /*
+            Las muestras se limitan a las que caben en --presupuesto según la referencia: una
+            firma de XMSS con altura 16 o 20 puede tardar minutos.
+            */
+            double coste = coste_iteracion(referencias, parametro, prehash, con_keygen);
+            if(coste > 0) {
+                size_t caben = static_cast<size_t>(presupuesto / coste);
+                if(caben < MIN_MUESTRAS + opciones_set.calentamiento) {
+                    std::cout << "[!] " << parametro << (prehash ? " (pre-hash)" : "") << " omitido: cada iteración tarda unos "
+                              << coste << " s y en " << presupuesto << " s no caben " << MIN_MUESTRAS
+                              << " muestras (sube --presupuesto)\n";
+                    ++omitidos;
+                    continue;
+                }
+                opciones_set.iteraciones = std::min(opciones_set.iteraciones, caben - opciones_set.calentamiento);
+            }
+
+            // La clave se genera una sola vez antes de medir, no en cada iteración del keygen
+            if(!con_keygen) {
+                obtener_clave(*esquema, opciones_set);
+                opciones_set.regenerar_claves = false;
+            }
+
+            std::cout << "[+] " << parametro << (prehash ? " (pre-hash)" : "") << " (" << opciones_set.iteraciones
+                      << " muestras)..." << std::flush;
+            Resultado resultado = evaluar(*esquema, opciones_set);
+            std::cout << (resultado.verificada ? " hecho\n" : " Firma Errónea\n");
+            fallos += !resultado.verificada;
+
+            std::map<std::string, std::vector<double>> operaciones = {
+                {"firma", tiempos(resultado.firma)},
+                {"verificacion", tiempos(resultado.verificacion)},
+                {OPERACION_VERIFICADOR_VERIFICACION, tiempos_sumados(resultado.preparacion_verificador, resultado.verificacion)}};
+            if(!resultado.clave_en_cache) {
+                operaciones["keygen"] = tiempos(resultado.keygen);
+                operaciones[OPERACION_KEYGEN_FIRMADOR] = tiempos_sumados(resultado.keygen, resultado.preparacion_firmador);
+            }
+
+            for(const auto& referencia : referencias) {
+                if(referencia.parametro != parametro || referencia.prehash != prehash) {
+                    continue;
+                }
+
+                auto it = operaciones.find(referencia.operacion);
+                if(it == operaciones.end()) {
+                    continue;
+                }
+
+                std::vector<double> actual = tiempos_conservados(it->second, opciones.umbral_outliers);
+                if(actual.empty() || referencia.segundos.empty()) {
+                    continue;
+                }
+                comparaciones.push_back(comparar(referencia, actual, umbral, confianza, static_cast<size_t>(remuestreos)));
+
+                if(guardar) {
+                    const char* texto_prehash = conjunto.familia != Familia::SLH_DSA ? "N/A" : prehash ? "Sí" : "No";
+                    for(double segundos : actual) {
+                        guardar << parametro << "," << texto_prehash << "," << referencia.operacion << "," << segundos << "\n";
+                    }
+                }
+            }
+        } catch(const std::exception& e) {
+            std::cerr << "Excepción en comparar(" << parametro << "): " << e.what() << "\n";
+            ++fallos;
+        }
+    }
+
+    std::cout << "\n";
+    imprimir_comparaciones(comparaciones, confianza, std::cout);
+
+    size_t regresiones = std::count_if(comparaciones.begin(), comparaciones.end(), [](const auto& c) { return c.veredicto > 0; });
+    size_t mejoras = std::count_if(comparaciones.begin(), comparaciones.end(), [](const auto& c) { return c.veredicto < 0; });
+    std::cout << "\n" << regresiones << " regresiones, " << mejoras << " mejoras, "
+              << comparaciones.size() - regresiones - mejoras << " sin cambio significativo";
+    if(omitidos > 0) {
+        std::cout << ", " << omitidos << " sets omitidos por el presupuesto";
+    }
+    if(fallos > 0) {
+        std::cout << ", " << fallos << " sets con errores";
+    }
+    std::cout << "\n";
+
+    return regresiones == 0 && fallos == 0 ? 0 : 1;
+}
+
+} // namespace pqbench
@@ -0,0 +1,75 @@
+#ifndef PQBENCH_COMPARAR_H
+#define PQBENCH_COMPARAR_H
+
+#include "pqbench.h"
+
+/*
+Comparación con unos resultados de referencia para detectar regresiones de rendimiento.
+
+La referencia puede ser:
+- Un CSV de benchmark.py (*-Resultados.csv), del que se leen por set las medianas de
+  Keygen_tiempo, Firma_tiempo y Verificacion_tiempo. Como sólo hay un valor por
+  operación, la referencia se toma como fija y el intervalo de confianza es el de la
+  mediana actual. Si el CSV no tiene la columna Estado es de los programas originales,
+  cuyo keygen incluía construir el PK_Signer y cuya verificación incluía public_key() y
+  construir el PK_Verifier; esas columnas se comparan con las operaciones
+  "keygen+firmador" y "verificador+verificacion", la suma de las fases de evaluar().
+- Un CSV de muestras guardado con --guardar (Parametro, Prehash, Operacion, Segundos:
+  una fila por muestra). Con muestras en los dos lados se aplica además la prueba U de
+  Mann-Whitney y el intervalo bootstrap remuestrea también la referencia.
+
+Cada set de la referencia se vuelve a evaluar con evaluar() tomando --iteraciones muestras
+(30 por defecto), limitadas a las que caben en --presupuesto segundos (600 por defecto)
+según lo que tardan firma, verificación y keygen en la referencia; si no caben 5, el set se
+omite (p. ej. XMSS con altura 20; con altura 16 caben unas 20). Si un set está en varias referencias se compara una sola vez, con la del primer
+fichero. Para cada operación se calcula el cambio de la mediana y su intervalo
+bootstrap; un cambio cuenta como regresión o mejora si el intervalo no incluye el 0, el
+p-valor (si lo hay) es menor que 1 - confianza y el cambio supera --umbral. Se imprime una
+tabla ordenada de peor a mejor cambio y el modo termina con 1 si hay alguna regresión, de
+modo que se puede usar como comprobación tras actualizar Botan o cambiar de máquina.
+*/
+
+namespace pqbench {
+
+// Referencia de una operación de un set
+struct ReferenciaOperacion {
+    std::string parametro;
+    bool prehash = false;
+    std::string operacion;        // "keygen", "firma", "verificacion" o una de las sumas de abajo
+    std::vector<double> segundos; // Un único valor si viene de un CSV de medianas
+};
+
+// Operaciones con las que se comparan los CSV de resultados sin columna Estado
+constexpr const char* OPERACION_KEYGEN_FIRMADOR = "keygen+firmador";
+constexpr const char* OPERACION_VERIFICADOR_VERIFICACION = "verificador+verificacion";
+
+// Lee un CSV de resultados o de muestras; lanza una excepción si no tiene el formato esperado
+std::vector<ReferenciaOperacion> leer_referencia(const std::string& fichero);
+
+// Comparación de una operación
+struct Comparacion {
+    std::string parametro;
+    bool prehash = false;
+    std::string operacion;
+    double base = 0;          // Mediana de la referencia
+    double actual = 0;        // Mediana actual
+    double cambio = 0;        // actual / base - 1
+    Intervalo intervalo;      // Intervalo del cambio
+    double p = -1;            // p-valor de Mann-Whitney (-1 si la referencia no tiene muestras)
+    int veredicto = 0;        // 1 = regresión, -1 = mejora, 0 = sin cambio significativo
+};
+
+/*
+Punto de entrada del modo desde la línea de comandos:
+  ./pqbench comparar <referencia.csv>... [--umbral=5] [--confianza=0.95] [--remuestreos=2000]
+                     [--sets=ML-DSA,SLH-DSA-SHA2-128s] [--keygen] [--guardar=muestras.csv]
+                     [--iteraciones=30] [--presupuesto=600] [--calentamiento=N] [--outliers[=k]] [--nucleo=N]
+El umbral es en porcentaje. En XMSS el keygen sólo se vuelve a medir con --keygen; si no,
+la clave se genera una vez (o se toma de la caché de claves) antes de medir y la
+comparación del keygen se omite.
+*/
+int ejecutar_comparar(const Argumentos& args);
+
+} // namespace pqbench
+
+#endif
@@ -0,0 +1,151 @@
+#include "coste_rng.h"
+
+#include <iomanip>
+#include <stdexcept>
+
+namespace pqbench {
+
+// Resultado de una fuente de RNG y un tipo de firma
+struct ResultadoCosteRNG {
+    FuenteRNG fuente = FuenteRNG::AUTO;
+    bool determinista = false;
+    Operacion keygen;      // Sólo en la primera fila de cada fuente
+    Operacion firma;
+    bool repetible = false; // Dos firmas del mismo mensaje son idénticas
+    bool verificada = false;
+};
+
+static std::vector<uint8_t> firmar(Botan::PK_Signer& signer, Botan::RandomNumberGenerator& rng) {
+    const Botan::secure_vector<uint8_t>& msg = mensaje_fijo();
+    signer.update(msg.data(), msg.size());
+    return signer.signature(rng);
+}
+
+static std::vector<ResultadoCosteRNG> medir_fuente(const Esquema& esquema, FuenteRNG fuente, const Opciones& opciones) {
+    auto rng = crear_rng_medido(fuente, opciones.semilla_rng);
+    std::unique_ptr<Botan::Private_Key> clave;
+
+    std::vector<ResultadoCosteRNG> resultados;
+    Operacion keygen = muestrear(opciones, [&] { clave = esquema.generar_clave(*rng); });
+    auto pub_key = clave->public_key();
+
+    std::vector<bool> modos{false};
+    if(esquema.conjunto().familia != Familia::XMSS) {
+        modos.push_back(true);
+    }
+
+    for(bool determinista : modos) {
+        ResultadoCosteRNG resultado;
+        resultado.fuente = fuente;
+        resultado.determinista = determinista;
+        if(resultados.empty()) {
+            resultado.keygen = keygen;
+        }
+
+        Botan::PK_Signer signer(*clave, *rng, esquema.padding_firma(determinista));
+        std::vector<uint8_t> signature;
+        resultado.firma = muestrear(opciones, [&] { signature = firmar(signer, *rng); });
+
+        // En XMSS la segunda firma usa otra hoja, así que nunca es repetible
+        resultado.repetible = firmar(signer, *rng) == signature;
+
+        const Botan::secure_vector<uint8_t>& msg = mensaje_fijo();
+        Botan::PK_Verifier verifier(*pub_key, esquema.padding_verificacion());
+        verifier.update(msg.data(), msg.size());
+        resultado.verificada = verifier.check_signature(signature.data(), signature.size());
+
+        resultados.push_back(std::move(resultado));
+    }
+
+    return resultados;
+}
+
+static void imprimir_coste_rng(const std::vector<ResultadoCosteRNG>& resultados, bool xmss, std::ostream& salida) {
+    salida << std::setw(11) << "Fuente" << std::setw(14) << "Firma" << std::setw(13) << "Keygen"
+           << std::setw(13) << "RNG keygen" << std::setw(13) << "Firma (s)" << std::setw(13) << "RNG firma"
+           << std::setw(8) << "% RNG" << std::setw(10) << "Llamadas" << std::setw(8) << "Bytes"
+           << std::setw(11) << "Repetible" << "\n";
+
+    for(const auto& r : resultados) {
+        double porcentaje = r.firma.segundos.media > 0 ? 100.0 * r.firma.rng.segundos / r.firma.segundos.media : 0;
+
+        salida << std::setw(11) << nombre_fuente_rng(r.fuente)
+               << columna(xmss ? "única" : r.determinista ? "determinista" : "hedged", 14);
+        if(r.keygen.muestras.empty()) {
+            salida << std::setw(13) << "" << std::setw(13) << "";
+        } else {
+            salida << std::setw(13) << r.keygen.segundos.mediana << std::setw(13) << r.keygen.rng.segundos;
+        }
+        salida << std::setw(13) << r.firma.segundos.mediana << std::setw(13) << r.firma.rng.segundos
+               << std::setw(7) << std::fixed << std::setprecision(1) << porcentaje << "%"
+               << std::defaultfloat << std::setprecision(6)
+               << std::setw(10) << r.firma.rng.llamadas << std::setw(8) << r.firma.rng.bytes
+               << columna(r.repetible ? "sí" : "no", 11)
+               << (r.verificada ? "" : "  [!] Firma Errónea") << "\n";
+    }
+
+    if(xmss) {
+        return;
+    }
+
+    // Coste de la firma hedged respecto a la determinista con cada fuente
+    for(size_t i = 0; i + 1 < resultados.size(); i += 2) {
+        double hedged = resultados[i].firma.segundos.mediana;
+        double determinista = resultados[i + 1].firma.segundos.mediana;
+        if(determinista > 0) {
+            salida << "Firma hedged frente a determinista (" << nombre_fuente_rng(resultados[i].fuente) << "): "
+                   << std::showpos << std::fixed << std::setprecision(1) << 100.0 * (hedged - determinista) / determinista
+                   << std::noshowpos << std::defaultfloat << std::setprecision(6) << " %\n";
+        }
+    }
+}
+
+int ejecutar_coste_rng(const Argumentos& args) {
+    if(args.posicionales().size() != 1) {
+        std::cerr << "Uso: ./pqbench rng <set|familia|todos> [--fuentes=auto,chacha,hmac-drbg] [--semilla-rng=N] [--prehash]"
+                     " [--iteraciones=N] [--calentamiento=N] [--outliers[=k]]\n";
+        return 1;
+    }
+
+    Opciones opciones = leer_opciones(args);
+    std::vector<FuenteRNG> fuentes;
+    for(const auto& nombre : args.textos("fuentes", {"auto", "chacha", "hmac-drbg"})) {
+        fuentes.push_back(leer_fuente_rng(nombre));
+        comprobar_fuente_rng(fuentes.back(), opciones.semilla_rng);
+    }
+
+    std::vector<Conjunto> elegidos = seleccionar(args.posicionales()[0], args.activa("prehash"));
+    if(elegidos.empty()) {
+        std::cerr << "Set de parámetros inválido.\n";
+        return 1;
+    }
+
+    int fallos = 0;
+    for(const auto& conjunto : elegidos) {
+        try {
+            auto esquema = crear_esquema(conjunto);
+
+            std::vector<ResultadoCosteRNG> resultados;
+            for(FuenteRNG fuente : fuentes) {
+                auto filas = medir_fuente(*esquema, fuente, opciones);
+                resultados.insert(resultados.end(), filas.begin(), filas.end());
+            }
+
+            std::cout << "COSTE DEL RNG EN " << conjunto.nombre << (conjunto.prehash ? " (pre-hash)" : "")
+                      << " | tiempos en segundos: mediana de la operación y media dentro del RNG"
+                      << " | semilla de las fuentes sembradas: " << opciones.semilla_rng << "\n";
+            imprimir_coste_rng(resultados, conjunto.familia == Familia::XMSS, std::cout);
+            std::cout << "\n";
+
+            fallos += std::any_of(resultados.begin(), resultados.end(),
+                                  [](const ResultadoCosteRNG& r) { return !r.verificada; });
+        } catch(const std::exception& e) {
+            std::cerr << "Excepción en rng(" << conjunto.nombre << "): " << e.what() << "\n";
+            ++fallos;
+        }
+    }
+
+    return fallos == 0 ? 0 : 1;
+}
+
+} // namespace pqbench
@@ -0,0 +1,27 @@
+#ifndef PQBENCH_COSTE_RNG_H
+#define PQBENCH_COSTE_RNG_H
+
+#include "pqbench.h"
+
+/*
+Coste del RNG en la generación de claves y en la firma.
+
+Para cada fuente de RNG (aleatoriedad.h) se mide el keygen y la firma, separando el
+tiempo que pasa dentro de las llamadas al RNG. En ML-DSA y SLH-DSA la firma se mide en
+su versión hedged, que mezcla 32 bytes aleatorios en cada firma (o n bytes en SLH-DSA),
+y en la determinista, que no llama al RNG y da siempre la misma firma para el mismo
+mensaje. La firma XMSS no usa el RNG, así que sólo tiene una versión.
+*/
+
+namespace pqbench {
+
+/*
+Punto de entrada del modo desde la línea de comandos:
+  ./pqbench rng <set|familia|todos> [--fuentes=auto,chacha,hmac-drbg] [--semilla-rng=N] [--prehash]
+                [--iteraciones=N] [--calentamiento=N] [--outliers[=k]]
+*/
+int ejecutar_coste_rng(const Argumentos& args);
+
+} // namespace pqbench
+
+#endif
@@ -0,0 +1,398 @@
+#include "cpu.h"
+#include "binario.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <botan/build.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#elif defined(__aarch64__) && defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+namespace pqbench {
+
+// ----- DETECCIÓN -----
+
+// Nombres de BOTAN_CLEAR_CPUID de las características presentes en la CPU
+static std::vector<std::string> detectar() {
+    std::vector<std::string> detectadas;
+    auto anotar = [&](bool presente, const char* nombre) {
+        if(presente) {
+            detectadas.push_back(nombre);
+        }
+    };
+
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return detectadas;
+    }
+    unsigned int ecx1 = ecx, edx1 = edx;
+
+    // Los registros AVX sólo se pueden usar si el sistema operativo los guarda (XGETBV)
+    uint64_t xcr0 = 0;
+    if(ecx1 & (1u << 27)) {
+        uint32_t bajo, alto;
+        __asm__ volatile("xgetbv" : "=a"(bajo), "=d"(alto) : "c"(0));
+        xcr0 = (static_cast<uint64_t>(alto) << 32) | bajo;
+    }
+    bool estado_avx = (xcr0 & 0x06) == 0x06;
+    bool estado_avx512 = (xcr0 & 0xE6) == 0xE6;
+
+    unsigned int ebx7 = 0, ecx7 = 0, eax7_1 = 0;
+    if(__get_cpuid_max(0, nullptr) >= 7) {
+        __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx);
+        ebx7 = ebx;
+        ecx7 = ecx;
+        __get_cpuid_count(7, 1, &eax, &ebx, &ecx, &edx);
+        eax7_1 = eax;
+    }
+
+    anotar(edx1 & (1u << 26), "sse2");
+    anotar(ecx1 & (1u << 9), "ssse3");
+    anotar(ecx1 & (1u << 19), "sse41");
+    anotar(ecx1 & (1u << 20), "sse42");
+    anotar(estado_avx && (ebx7 & (1u << 5)), "avx2");
+    // Botan sólo usa AVX-512 si están F, DQ, BW y VL
+    anotar(estado_avx512 && (ebx7 & (1u << 16)) && (ebx7 & (1u << 17)) && (ebx7 & (1u << 30)) && (ebx7 & (1u << 31)), "avx512");
+    anotar((ebx7 & (1u << 3)) && (ebx7 & (1u << 8)), "bmi2");
+    anotar(ebx7 & (1u << 19), "adx");
+    anotar(ecx1 & (1u << 25), "aesni");
+    anotar(ecx1 & (1u << 1), "clmul");
+    anotar(ebx7 & (1u << 29), "sha");
+    anotar(estado_avx && (eax7_1 & 1u), "sha512");
+    anotar(ecx7 & (1u << 8), "gfni");
+    anotar(ecx1 & (1u << 30), "rdrand");
+    anotar(ebx7 & (1u << 18), "rdseed");
+#elif defined(__aarch64__) && defined(__linux__)
+    unsigned long hwcap = ::getauxval(AT_HWCAP);
+    anotar(hwcap & HWCAP_ASIMD, "neon");
+    anotar(hwcap & HWCAP_AES, "armv8aes");
+    anotar(hwcap & HWCAP_PMULL, "armv8pmull");
+    anotar(hwcap & HWCAP_SHA1, "armv8sha1");
+    anotar(hwcap & HWCAP_SHA2, "armv8sha2");
+    anotar(hwcap & HWCAP_SHA3, "armv8sha3");
+    anotar(hwcap & HWCAP_SHA512, "armv8sha512");
+#endif
+
+    return detectadas;
+}
+
+// Características de BOTAN_CLEAR_CPUID en este proceso
+static std::vector<std::string> desactivadas_entorno() {
+    std::vector<std::string> nombres;
+    const char* valor = std::getenv("BOTAN_CLEAR_CPUID");
+    if(valor) {
+        std::istringstream lista(valor);
+        std::string nombre;
+        while(std::getline(lista, nombre, ',')) {
+            if(!nombre.empty()) {
+                nombres.push_back(nombre);
+            }
+        }
+    }
+    return nombres;
+}
+
+std::vector<CaracteristicaCPU> caracteristicas_cpu() {
+    std::vector<std::string> desactivadas = desactivadas_entorno();
+
+    std::vector<CaracteristicaCPU> caracteristicas;
+    for(const auto& nombre : detectar()) {
+        bool desactivada = std::find(desactivadas.begin(), desactivadas.end(), nombre) != desactivadas.end();
+        caracteristicas.push_back({nombre, true, desactivada});
+    }
+    return caracteristicas;
+}
+
+std::vector<std::string> modulos_cpu_botan() {
+    std::vector<std::string> modulos;
+#if defined(BOTAN_HAS_SIMD_32)
+    modulos.push_back("simd");
+#endif
+#if defined(BOTAN_HAS_SIMD_AVX2)
+    modulos.push_back("simd_avx2");
+#endif
+#if defined(BOTAN_HAS_SIMD_AVX512)
+    modulos.push_back("simd_avx512");
+#endif
+#if defined(BOTAN_HAS_SHA2_32_X86)
+    modulos.push_back("sha2_32_x86");
+#endif
+#if defined(BOTAN_HAS_SHA2_32_X86_AVX2)
+    modulos.push_back("sha2_32_x86_avx2");
+#endif
+#if defined(BOTAN_HAS_SHA2_32_X86_BMI2)
+    modulos.push_back("sha2_32_x86_bmi2");
+#endif
+#if defined(BOTAN_HAS_SHA2_64_X86)
+    modulos.push_back("sha2_64_x86");
+#endif
+#if defined(BOTAN_HAS_SHA2_64_X86_AVX2)
+    modulos.push_back("sha2_64_x86_avx2");
+#endif
+#if defined(BOTAN_HAS_SHA2_64_BMI2)
+    modulos.push_back("sha2_64_bmi2");
+#endif
+#if defined(BOTAN_HAS_KECCAK_PERM_BMI2)
+    modulos.push_back("keccak_perm_bmi2");
+#endif
+#if defined(BOTAN_HAS_SHA2_32_ARMV8)
+    modulos.push_back("sha2_32_armv8");
+#endif
+#if defined(BOTAN_HAS_SHA2_64_ARMV8)
+    modulos.push_back("sha2_64_armv8");
+#endif
+#if defined(BOTAN_HAS_AES_NI)
+    modulos.push_back("aes_ni");
+#endif
+#if defined(BOTAN_HAS_AES_VAES)
+    modulos.push_back("aes_vaes");
+#endif
+#if defined(BOTAN_HAS_AES_ARMV8)
+    modulos.push_back("aes_armv8");
+#endif
+    return modulos;
+}
+
+void desactivar_caracteristicas_cpu(const std::vector<std::string>& nombres) {
+    std::string valor;
+    for(const auto& nombre : nombres) {
+        valor += (valor.empty() ? "" : ",") + nombre;
+    }
+    ::setenv("BOTAN_CLEAR_CPUID", valor.c_str(), 1);
+}
+
+void imprimir_caracteristicas_cpu(std::ostream& salida) {
+    std::string detectadas, activas, desactivadas, modulos;
+    for(const auto& c : caracteristicas_cpu()) {
+        detectadas += " " + c.nombre;
+        (c.desactivada ? desactivadas : activas) += " " + c.nombre;
+    }
+    for(const auto& m : modulos_cpu_botan()) {
+        modulos += " " + m;
+    }
+
+    salida << "CARACTERÍSTICAS DE LA CPU\n"
+           << "Detectadas:" << (detectadas.empty() ? " ninguna" : detectadas) << "\n"
+           << "Desactivadas con BOTAN_CLEAR_CPUID:" << (desactivadas.empty() ? " ninguna" : desactivadas) << "\n"
+           << "Disponibles para Botan:" << (activas.empty() ? " ninguna" : activas) << "\n"
+           << "Módulos de Botan con código específico:" << (modulos.empty() ? " ninguno" : modulos) << "\n\n";
+}
+
+// ----- ABLACIÓN -----
+
+// Resultado que el hijo envía al padre por la tubería
+struct MuestraAblacion {
+    double keygen;
+    double firma;
+    double verificacion;
+    uint8_t clave_en_cache;
+    uint8_t verificada;
+};
+
+// Código del proceso hijo: nunca vuelve
+[[noreturn]] static void hijo_ablacion(const Conjunto& conjunto, const std::vector<std::string>& desactivadas,
+                                       const Opciones& opciones, int fd) {
+    int codigo = 0;
+    try {
+        desactivar_caracteristicas_cpu(desactivadas);
+
+        auto esquema = crear_esquema(conjunto);
+        Resultado resultado = evaluar(*esquema, opciones);
+        MuestraAblacion muestra{resultado.keygen.segundos.mediana, resultado.firma.segundos.mediana,
+                                resultado.verificacion.segundos.mediana, resultado.clave_en_cache, resultado.verificada};
+
+        if(!escribir_todo(fd, &muestra, sizeof(muestra))) {
+            codigo = 1;
+        }
+    } catch(const std::exception& e) {
+        std::cerr << "Excepción en la ablación de " << conjunto.nombre << ": " << e.what() << "\n";
+        codigo = 1;
+    }
+
+    ::close(fd);
+    // _exit para no ejecutar en el hijo los destructores estáticos del padre
+    ::_exit(codigo);
+}
+
+AblacionCPU medir_sin_caracteristicas(const Conjunto& conjunto, const std::vector<std::string>& desactivadas,
+                                      const Opciones& opciones) {
+    int tuberia[2];
+    if(::pipe(tuberia) != 0) {
+        throw std::runtime_error(std::string("No se pudo crear la tubería: ") + std::strerror(errno));
+    }
+
+    std::cout.flush();
+    std::cerr.flush();
+
+    pid_t pid = ::fork();
+    if(pid < 0) {
+        ::close(tuberia[0]);
+        ::close(tuberia[1]);
+        throw std::runtime_error(std::string("No se pudo crear el proceso hijo: ") + std::strerror(errno));
+    }
+    if(pid == 0) {
+        ::close(tuberia[0]);
+        hijo_ablacion(conjunto, desactivadas, opciones, tuberia[1]);
+    }
+    ::close(tuberia[1]);
+
+    AblacionCPU resultado;
+    resultado.desactivadas = desactivadas;
+
+    MuestraAblacion muestra{};
+    bool completo = leer_todo(tuberia[0], &muestra, sizeof(muestra));
+    ::close(tuberia[0]);
+
+    int estado = 0;
+    while(::waitpid(pid, &estado, 0) < 0 && errno == EINTR) {}
+
+    if(completo && WIFEXITED(estado) && WEXITSTATUS(estado) == 0) {
+        resultado.keygen = muestra.keygen;
+        resultado.firma = muestra.firma;
+        resultado.verificacion = muestra.verificacion;
+        resultado.clave_en_cache = muestra.clave_en_cache;
+        resultado.correcta = muestra.verificada;
+    }
+    return resultado;
+}
+
+// Cuántas veces más lento es sin las características (> 1 = las características aceleran)
+static double ralentizacion(double sin, double con) {
+    return con > 0 ? sin / con : 0;
+}
+
+static void imprimir_ablacion(const std::vector<AblacionCPU>& resultados, std::ostream& salida) {
+    const AblacionCPU& base = resultados.front();
+
+    salida << std::setw(16) << "Variante" << std::setw(13) << "Keygen (s)" << std::setw(13) << "Firma (s)"
+           << std::setw(13) << "Verif. (s)" << std::setw(10) << "Keygen x" << std::setw(10) << "Firma x"
+           << std::setw(10) << "Verif. x" << "  Desactivadas\n";
+
+    for(const auto& r : resultados) {
+        salida << std::setw(16) << r.variante;
+        if(r.firma == 0) {
+            salida << "  [!] La medición ha fallado\n";
+            continue;
+        }
+
+        std::string desactivadas;
+        for(const auto& nombre : r.desactivadas) {
+            desactivadas += (desactivadas.empty() ? "" : ",") + nombre;
+        }
+
+        salida << std::setw(13) << r.keygen << std::setw(13) << r.firma << std::setw(13) << r.verificacion
+               << std::fixed << std::setprecision(2)
+               << std::setw(10) << ralentizacion(r.keygen, base.keygen) << std::setw(10) << ralentizacion(r.firma, base.firma)
+               << std::setw(10) << ralentizacion(r.verificacion, base.verificacion)
+               << std::defaultfloat << std::setprecision(6)
+               << "  " << (desactivadas.empty() ? "-" : desactivadas)
+               << (r.correcta ? "" : "  [!] Firma Errónea") << "\n";
+    }
+
+    if(base.clave_en_cache) {
+        salida << "La clave sale de la caché: el keygen es el medido al generarla, no el de cada variante\n";
+    }
+}
+
+int ejecutar_cpu(const Argumentos& args) {
+    if(args.posicionales().size() != 1) {
+        std::cerr << "Uso: ./pqbench cpu <set|familia|todos> [--variantes=avx2,avx512,bmi2,sha,sha512,todas] [--prehash]"
+                     " [--iteraciones=N] [--calentamiento=N] [--outliers[=k]] [--cache-claves[=d]]\n";
+        return 1;
+    }
+
+    Opciones opciones = leer_opciones(args);
+    std::vector<Conjunto> elegidos = seleccionar(args.posicionales()[0], args.activa("prehash"));
+    if(elegidos.empty()) {
+        std::cerr << "Set de parámetros inválido.\n";
+        return 1;
+    }
+
+    imprimir_caracteristicas_cpu(std::cout);
+
+    std::vector<std::string> detectadas;
+    for(const auto& c : caracteristicas_cpu()) {
+        detectadas.push_back(c.nombre);
+    }
+    auto detectada = [&](const std::string& nombre) {
+        return std::find(detectadas.begin(), detectadas.end(), nombre) != detectadas.end();
+    };
+
+    /*
+    Cada variante es una lista de características unidas con '+'. Por defecto sólo se
+    prueban las que tiene la CPU: desactivar una que no está no cambia nada.
+    */
+    std::vector<std::pair<std::string, std::vector<std::string>>> variantes{{"base", {}}};
+    bool por_defecto = !args.activa("variantes");
+    for(const auto& variante : args.textos("variantes", {"avx2", "avx512", "bmi2", "sha", "sha512", "todas"})) {
+        std::vector<std::string> nombres;
+        if(variante == "todas") {
+            nombres = detectadas;
+        } else {
+            std::istringstream lista(variante);
+            std::string nombre;
+            while(std::getline(lista, nombre, '+')) {
+                if(!por_defecto || detectada(nombre)) {
+                    nombres.push_back(nombre);
+                }
+            }
+        }
+        if(!nombres.empty()) {
+            variantes.push_back({variante, nombres});
+        }
+    }
+
+    int fallos = 0;
+    std::vector<std::pair<std::string, double>> perdidas; // Ralentización de la firma sin ninguna característica
+    for(const auto& conjunto : elegidos) {
+        try {
+            std::vector<AblacionCPU> resultados;
+            for(const auto& [variante, nombres] : variantes) {
+                resultados.push_back(medir_sin_caracteristicas(conjunto, nombres, opciones));
+                resultados.back().variante = variante;
+                fallos += !resultados.back().correcta;
+            }
+
+            std::cout << "ABLACIÓN DE CARACTERÍSTICAS DE LA CPU EN " << conjunto.nombre << (conjunto.prehash ? " (pre-hash)" : "")
+                      << " | tiempos en segundos (mediana) | x = veces más lento que con todas activas\n";
+            imprimir_ablacion(resultados, std::cout);
+            std::cout << "\n";
+
+            double peor = 0;
+            for(const auto& r : resultados) {
+                peor = std::max(peor, ralentizacion(r.firma, resultados.front().firma));
+            }
+            perdidas.push_back({conjunto.nombre + (conjunto.prehash ? " (pre-hash)" : ""), peor});
+        } catch(const std::exception& e) {
+            std::cerr << "Excepción en cpu(" << conjunto.nombre << "): " << e.what() << "\n";
+            ++fallos;
+        }
+    }
+
+    // Qué sets pierden más en una CPU sin estas características
+    if(perdidas.size() > 1) {
+        std::sort(perdidas.begin(), perdidas.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+        std::cout << "SETS QUE MÁS PIERDEN EN LA FIRMA (peor variante)\n";
+        for(const auto& [nombre, peor] : perdidas) {
+            std::cout << "  " << std::left << std::setw(32) << nombre << std::right << std::fixed << std::setprecision(2)
+                      << peor << "x" << std::defaultfloat << std::setprecision(6) << "\n";
+        }
+    }
+
+    return fallos == 0 ? 0 : 1;
+}
+
+} // namespace pqbench
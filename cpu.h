@@ -0,0 +1,68 @@
+#ifndef PQBENCH_CPU_H
+#define PQBENCH_CPU_H
+
+#include "pqbench.h"
+
+/*
+Características de la CPU que puede usar Botan y ablación de cada una.
+
+Botan elige en tiempo de ejecución el código de cada primitiva según lo que detecta en la
+CPU (AVX2, AVX-512, BMI2, SHA-NI...), y permite ocultarle características con la variable
+de entorno BOTAN_CLEAR_CPUID (p. ej. "avx2,sha"), que lee una sola vez por proceso, la
+primera vez que consulta la CPU. Como la detección de Botan no es una API pública, aquí
+se repite con CPUID (o getauxval en ARM) usando los mismos nombres que BOTAN_CLEAR_CPUID, y
+se indica qué módulos con código específico se han compilado en Botan según build.h.
+
+La ablación evalúa cada set en un proceso hijo por variante, con BOTAN_CLEAR_CPUID fijada
+antes de que Botan consulte la CPU, igual que el escalado del keygen con el número de
+hilos. El proceso padre no usa Botan antes de crear los hijos.
+*/
+
+namespace pqbench {
+
+struct CaracteristicaCPU {
+    std::string nombre;   // Nombre en BOTAN_CLEAR_CPUID
+    bool detectada = false;
+    bool desactivada = false; // Está en BOTAN_CLEAR_CPUID
+};
+
+std::vector<CaracteristicaCPU> caracteristicas_cpu();
+
+// Módulos de Botan con código para instrucciones concretas que se han compilado
+std::vector<std::string> modulos_cpu_botan();
+
+/*
+Oculta a Botan las características indicadas en este proceso. Tiene que llamarse antes de
+cualquier operación criptográfica.
+*/
+void desactivar_caracteristicas_cpu(const std::vector<std::string>& nombres);
+
+void imprimir_caracteristicas_cpu(std::ostream& salida);
+
+// Medianas de una evaluación con un conjunto de características desactivadas
+struct AblacionCPU {
+    std::string variante;
+    std::vector<std::string> desactivadas;
+    double keygen = 0;
+    double firma = 0;
+    double verificacion = 0;
+    bool clave_en_cache = false; // El keygen es el guardado en la caché, no se ha medido
+    bool correcta = false;
+};
+
+// Evalúa el set en un proceso hijo con BOTAN_CLEAR_CPUID = desactivadas
+AblacionCPU medir_sin_caracteristicas(const Conjunto& conjunto, const std::vector<std::string>& desactivadas,
+                                      const Opciones& opciones);
+
+/*
+Punto de entrada del modo desde la línea de comandos:
+  ./pqbench cpu <set|familia|todos> [--variantes=avx2,avx512,bmi2,sha,sha512,todas] [--prehash]
+                [--iteraciones=N] [--calentamiento=N] [--outliers[=k]] [--cache-claves[=d]]
+Cada variante es una característica o varias unidas con '+' (p. ej. sha+bmi2); "todas"
+desactiva todas las detectadas.
+*/
+int ejecutar_cpu(const Argumentos& args);
+
+} // namespace pqbench
+
+#endif
@@ -0,0 +1,124 @@
+#include "energia.h"
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <thread>
+
+namespace pqbench {
+
+// Primera línea de un fichero, o "" si no se puede leer
+static std::string leer_linea(const std::filesystem::path& ruta) {
+    std::ifstream fichero(ruta);
+    std::string linea;
+    std::getline(fichero, linea);
+    return linea;
+}
+
+ContadoresEnergia::ContadoresEnergia(const std::string& raiz) {
+    namespace fs = std::filesystem;
+
+    std::error_code error;
+    if(!fs::is_directory(raiz, error)) {
+        m_motivo = "no existe " + raiz + " (núcleo sin powercap o máquina virtual)";
+        return;
+    }
+
+    /*
+    Los paquetes son intel-rapl:N y sus subdominios intel-rapl:N:M. Se identifican por su
+    nombre ("package-N", "core") y no por el número, que cambia entre procesadores.
+    */
+    bool sin_permiso = false;
+    for(const auto& entrada : fs::directory_iterator(raiz, error)) {
+        std::string nombre_dir = entrada.path().filename().string();
+        if(nombre_dir.rfind("intel-rapl:", 0) != 0) {
+            continue;
+        }
+
+        std::string nombre = leer_linea(entrada.path() / "name");
+        std::vector<Dominio>* destino = nullptr;
+        if(nombre.rfind("package-", 0) == 0) {
+            destino = &m_paquetes;
+        } else if(nombre == "core") {
+            destino = &m_nucleos;
+        } else {
+            continue;
+        }
+
+        std::string energia = leer_linea(entrada.path() / "energy_uj");
+        if(energia.empty()) {
+            sin_permiso = true;
+            continue;
+        }
+
+        std::string rango = leer_linea(entrada.path() / "max_energy_range_uj");
+        destino->push_back({(entrada.path() / "energy_uj").string(), rango.empty() ? 0 : std::stoull(rango)});
+    }
+
+    if(m_paquetes.empty()) {
+        m_nucleos.clear();
+        m_motivo = sin_permiso ? "no se puede leer energy_uj (desde Linux 5.10 sólo lo puede leer root)"
+                               : "no hay dominios RAPL en " + raiz;
+    }
+}
+
+std::vector<uint64_t> ContadoresEnergia::leer() const {
+    std::vector<uint64_t> valores;
+    valores.reserve(m_paquetes.size() + m_nucleos.size());
+    for(const auto* dominios : {&m_paquetes, &m_nucleos}) {
+        for(const auto& dominio : *dominios) {
+            std::ifstream fichero(dominio.ruta);
+            uint64_t valor = 0;
+            fichero >> valor;
+            valores.push_back(valor);
+        }
+    }
+    return valores;
+}
+
+LecturaEnergia ContadoresEnergia::diferencia(const std::vector<uint64_t>& antes, const std::vector<uint64_t>& despues) const {
+    LecturaEnergia energia;
+    size_t i = 0;
+    for(const auto* dominios : {&m_paquetes, &m_nucleos}) {
+        double& julios = dominios == &m_paquetes ? energia.paquete : energia.nucleo;
+        for(const auto& dominio : *dominios) {
+            // Si el contador ha vuelto a empezar, ha recorrido lo que le faltaba hasta el rango
+            uint64_t microjulios = despues[i] >= antes[i] ? despues[i] - antes[i]
+                                 : dominio.rango > antes[i] ? dominio.rango - antes[i] + despues[i] : 0;
+            julios += microjulios / 1e6;
+            ++i;
+        }
+    }
+    return energia;
+}
+
+static std::unique_ptr<ContadoresEnergia> activos;
+
+const ContadoresEnergia& activar_energia() {
+    if(!activos) {
+        activos = std::make_unique<ContadoresEnergia>();
+    }
+    return *activos;
+}
+
+const ContadoresEnergia* contadores_energia() {
+    if(!activos || !activos->disponible()) {
+        return nullptr;
+    }
+    return activos.get();
+}
+
+double potencia_reposo(double segundos) {
+    const ContadoresEnergia* contadores = contadores_energia();
+    if(!contadores) {
+        return 0;
+    }
+
+    std::vector<uint64_t> antes = contadores->leer();
+    auto inicio = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(segundos));
+    LecturaEnergia energia = contadores->diferencia(antes, contadores->leer());
+    return energia.paquete / std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+}
+
+} // namespace pqbench
@@ -0,0 +1,132 @@
+#ifndef PQBENCH_ENERGIA_H
+#define PQBENCH_ENERGIA_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+Energía consumida por operación con los contadores RAPL de Linux (powercap).
+
+Cada paquete aparece en /sys/class/powercap como intel-rapl:N (también en AMD), con un
+subdominio "core" para los núcleos. Sus ficheros energy_uj son contadores de microjulios
+que vuelven a cero al llegar a max_energy_range_uj, así que la diferencia entre dos
+lecturas se corrige si el contador ha dado la vuelta; en ejecuciones largas se lee al
+menos una vez por segundo para que no pueda dar más de una vuelta entre lecturas.
+
+RAPL se actualiza más o menos cada milisegundo, mucho más despacio de lo que dura una
+verificación, así que la energía no se mide en cada muestra sino repitiendo la operación
+hasta sumar un tiempo mínimo (0.2 s por defecto) y dividiendo entre las repeticiones. Es
+la energía de todo el paquete (o de todos sus núcleos), incluida la de otros procesos y
+la de reposo, por lo que conviene medir en una máquina descargada y fijar el núcleo.
+
+Desde Linux 5.10 energy_uj sólo lo puede leer root; si no hay RAPL o no se puede leer
+se indica el motivo y la energía aparece como N/A.
+*/
+
+namespace pqbench {
+
+// Julios de cada dominio
+struct LecturaEnergia {
+    double paquete = 0;
+    double nucleo = 0;
+};
+
+class ContadoresEnergia {
+public:
+    explicit ContadoresEnergia(const std::string& raiz = "/sys/class/powercap");
+
+    bool disponible() const { return !m_paquetes.empty(); }
+    bool disponible_nucleo() const { return !m_nucleos.empty(); }
+
+    // Motivo por el que no se puede medir la energía (vacío si se puede)
+    const std::string& motivo() const { return m_motivo; }
+
+    // Valor bruto de cada contador, en microjulios
+    std::vector<uint64_t> leer() const;
+
+    // Energía entre dos lecturas, corrigiendo los contadores que hayan dado la vuelta
+    LecturaEnergia diferencia(const std::vector<uint64_t>& antes, const std::vector<uint64_t>& despues) const;
+
+private:
+    struct Dominio {
+        std::string ruta; // Fichero energy_uj
+        uint64_t rango;   // max_energy_range_uj
+    };
+
+    std::vector<Dominio> m_paquetes;
+    std::vector<Dominio> m_nucleos;
+    std::string m_motivo;
+};
+
+/*
+Activa la medición de energía de las evaluaciones posteriores. Devuelve los contadores
+para consultar su disponibilidad.
+*/
+const ContadoresEnergia& activar_energia();
+
+// Contadores activos, o nullptr si no se han activado o no están disponibles
+const ContadoresEnergia* contadores_energia();
+
+// Potencia media del paquete en vatios durante `segundos` sin hacer nada (0 si no hay RAPL)
+double potencia_reposo(double segundos = 0.25);
+
+// Energía media de una operación repetida
+struct EnergiaOperacion {
+    size_t repeticiones = 0; // 0 = no se ha medido
+    double segundos = 0;     // Tiempo total de las repeticiones
+    double julios_paquete = 0; // Por operación
+    double julios_nucleo = 0;  // Por operación (0 si no hay dominio de núcleo)
+};
+
+/*
+Repite f hasta que pasan `segundos_minimos` o se llega a `max_repeticiones` (al menos una
+vez) y devuelve la energía por repetición. Sin contadores activos no hace nada.
+*/
+template<typename F>
+EnergiaOperacion medir_energia(F&& f, double segundos_minimos, size_t max_repeticiones) {
+    EnergiaOperacion energia;
+    const ContadoresEnergia* contadores = contadores_energia();
+    if(!contadores || max_repeticiones == 0) {
+        return energia;
+    }
+
+    LecturaEnergia total;
+    auto inicio = std::chrono::steady_clock::now();
+    auto ultima_lectura = inicio;
+    std::vector<uint64_t> antes = contadores->leer();
+
+    double transcurrido = 0;
+    while(energia.repeticiones < max_repeticiones && (energia.repeticiones == 0 || transcurrido < segundos_minimos)) {
+        f();
+        ++energia.repeticiones;
+
+        auto ahora = std::chrono::steady_clock::now();
+        transcurrido = std::chrono::duration<double>(ahora - inicio).count();
+
+        // Lectura intermedia para que ningún contador dé más de una vuelta sin verse
+        if(std::chrono::duration<double>(ahora - ultima_lectura).count() >= 1.0) {
+            std::vector<uint64_t> despues = contadores->leer();
+            LecturaEnergia parcial = contadores->diferencia(antes, despues);
+            total.paquete += parcial.paquete;
+            total.nucleo += parcial.nucleo;
+            antes = std::move(despues);
+            ultima_lectura = ahora;
+        }
+    }
+
+    LecturaEnergia parcial = contadores->diferencia(antes, contadores->leer());
+    total.paquete += parcial.paquete;
+    total.nucleo += parcial.nucleo;
+
+    energia.segundos = transcurrido;
+    energia.julios_paquete = total.paquete / energia.repeticiones;
+    energia.julios_nucleo = total.nucleo / energia.repeticiones;
+    return energia;
+}
+
+} // namespace pqbench
+
+#endif
@@ -0,0 +1,174 @@
+#include "entorno.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace pqbench {
+
+// Prioridad fijada con subir_prioridad
+static std::string g_prioridad = "normal";
+
+// Primera línea de un fichero de sysfs o /proc, o "" si no existe
+static std::string leer_linea(const std::string& ruta) {
+    std::ifstream fichero(ruta);
+    std::string linea;
+    std::getline(fichero, linea);
+    return linea;
+}
+
+static std::string ruta_nucleo(int nucleo, const std::string& fichero) {
+    return "/sys/devices/system/cpu/cpu" + std::to_string(nucleo) + "/" + fichero;
+}
+
+void fijar_nucleo(int nucleo) {
+    cpu_set_t nucleos;
+    CPU_ZERO(&nucleos);
+    CPU_SET(nucleo, &nucleos);
+    if(::sched_setaffinity(0, sizeof(nucleos), &nucleos) != 0) {
+        throw std::runtime_error("No se pudo fijar el proceso al núcleo " + std::to_string(nucleo) + ": " + std::strerror(errno));
+    }
+}
+
+void subir_prioridad(const std::string& modo) {
+    if(modo == "nice") {
+        if(::setpriority(PRIO_PROCESS, 0, -20) != 0) {
+            throw std::runtime_error(std::string("No se pudo subir la prioridad a nice -20 (necesita CAP_SYS_NICE): ") + std::strerror(errno));
+        }
+        g_prioridad = "nice -20";
+    } else if(modo == "fifo") {
+        // Prioridad mínima de tiempo real: basta para no ceder el núcleo a procesos normales
+        sched_param parametros{};
+        parametros.sched_priority = ::sched_get_priority_min(SCHED_FIFO);
+        if(::sched_setscheduler(0, SCHED_FIFO, &parametros) != 0) {
+            throw std::runtime_error(std::string("No se pudo pasar a SCHED_FIFO (necesita CAP_SYS_NICE): ") + std::strerror(errno));
+        }
+        g_prioridad = "SCHED_FIFO " + std::to_string(parametros.sched_priority);
+    } else {
+        throw std::invalid_argument("Prioridad desconocida: " + modo + " (nice o fifo)");
+    }
+}
+
+double frecuencia_nucleo(int nucleo) {
+    std::string khz = leer_linea(ruta_nucleo(nucleo, "cpufreq/scaling_cur_freq"));
+    if(!khz.empty()) {
+        return std::strtod(khz.c_str(), nullptr) / 1000;
+    }
+
+    // Sin cpufreq, /proc/cpuinfo da la frecuencia de cada procesador lógico
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string linea;
+    int procesador = -1;
+    while(std::getline(cpuinfo, linea)) {
+        if(linea.rfind("processor", 0) == 0) {
+            procesador = std::atoi(linea.c_str() + linea.find(':') + 1);
+        } else if(procesador == nucleo && linea.rfind("cpu MHz", 0) == 0) {
+            return std::strtod(linea.c_str() + linea.find(':') + 1, nullptr);
+        }
+    }
+    return 0;
+}
+
+// Turbo según intel_pstate (no_turbo) o el driver genérico (boost)
+static std::string leer_turbo() {
+    std::string no_turbo = leer_linea("/sys/devices/system/cpu/intel_pstate/no_turbo");
+    if(!no_turbo.empty()) {
+        return no_turbo == "1" ? "inactivo" : "activo";
+    }
+    std::string boost = leer_linea("/sys/devices/system/cpu/cpufreq/boost");
+    if(!boost.empty()) {
+        return boost == "1" ? "activo" : "inactivo";
+    }
+    return "desconocido";
+}
+
+EntornoEjecucion leer_entorno() {
+    EntornoEjecucion entorno;
+
+    char maquina[256] = {};
+    if(::gethostname(maquina, sizeof(maquina) - 1) == 0) {
+        entorno.maquina = maquina;
+    }
+
+    entorno.nucleo = ::sched_getcpu();
+    cpu_set_t nucleos;
+    if(::sched_getaffinity(0, sizeof(nucleos), &nucleos) == 0) {
+        entorno.fijado = CPU_COUNT(&nucleos) == 1;
+    }
+    entorno.prioridad = g_prioridad;
+
+    auto o_desconocido = [](std::string valor) { return valor.empty() ? "desconocido" : valor; };
+    int nucleo = std::max(entorno.nucleo, 0);
+    entorno.gobernador = o_desconocido(leer_linea(ruta_nucleo(nucleo, "cpufreq/scaling_governor")));
+    entorno.turbo = leer_turbo();
+    entorno.smt = o_desconocido(leer_linea("/sys/devices/system/cpu/smt/control"));
+    entorno.hermanos = o_desconocido(leer_linea(ruta_nucleo(nucleo, "topology/thread_siblings_list")));
+
+    entorno.frecuencia_mhz = frecuencia_nucleo(nucleo);
+    entorno.frecuencia_min_mhz = std::strtod(leer_linea(ruta_nucleo(nucleo, "cpufreq/scaling_min_freq")).c_str(), nullptr) / 1000;
+    entorno.frecuencia_max_mhz = std::strtod(leer_linea(ruta_nucleo(nucleo, "cpufreq/scaling_max_freq")).c_str(), nullptr) / 1000;
+
+    double carga[1];
+    if(::getloadavg(carga, 1) == 1) {
+        entorno.carga = carga[0];
+    }
+
+    return entorno;
+}
+
+std::vector<std::string> avisos_entorno(const EntornoEjecucion& inicio, double carga_maxima, const EntornoEjecucion* fin) {
+    std::vector<std::string> avisos;
+
+    if(inicio.carga > carga_maxima) {
+        avisos.push_back("Máquina cargada: carga media de " + std::to_string(inicio.carga) +
+                         " (máximo " + std::to_string(carga_maxima) + ")");
+    }
+    if(inicio.gobernador != "desconocido" && inicio.gobernador != "performance") {
+        avisos.push_back("El gobernador de frecuencia es \"" + inicio.gobernador + "\", no \"performance\"");
+    }
+    if(inicio.turbo == "activo") {
+        avisos.push_back("El turbo está activo: la frecuencia depende de la temperatura y de los demás núcleos");
+    }
+
+    if(fin && inicio.frecuencia_mhz > 0 && fin->frecuencia_mhz > 0) {
+        double cambio = std::abs(fin->frecuencia_mhz - inicio.frecuencia_mhz) / inicio.frecuencia_mhz;
+        if(cambio > 0.05) {
+            avisos.push_back("La frecuencia del núcleo ha cambiado durante la evaluación: de " +
+                             std::to_string(static_cast<long>(inicio.frecuencia_mhz)) + " a " +
+                             std::to_string(static_cast<long>(fin->frecuencia_mhz)) + " MHz");
+        }
+    }
+    if(fin && fin->nucleo != inicio.nucleo) {
+        avisos.push_back("El proceso ha cambiado de núcleo durante la evaluación (usa --nucleo=N)");
+    }
+
+    return avisos;
+}
+
+void imprimir_entorno(const EntornoEjecucion& entorno, double frecuencia_final_mhz, std::ostream& salida) {
+    auto mhz = [](double valor) { return valor > 0 ? std::to_string(static_cast<long>(std::lround(valor))) : std::string("desconocida"); };
+
+    salida << "ENTORNO DE EJECUCIÓN\n"
+           << "ENT máquina: " << entorno.maquina << "\n"
+           << "ENT núcleo: " << entorno.nucleo << (entorno.fijado ? " (fijado)" : " (sin fijar)") << "\n"
+           << "ENT prioridad: " << entorno.prioridad << "\n"
+           << "ENT gobernador: " << entorno.gobernador << "\n"
+           << "ENT turbo: " << entorno.turbo << "\n"
+           << "ENT SMT: " << entorno.smt << "\n"
+           << "ENT hermanos SMT: " << entorno.hermanos << "\n"
+           << "ENT frecuencia inicial (MHz): " << mhz(entorno.frecuencia_mhz) << "\n"
+           << "ENT frecuencia final (MHz): " << mhz(frecuencia_final_mhz) << "\n"
+           << "ENT frecuencia mín-máx (MHz): " << mhz(entorno.frecuencia_min_mhz) << "-" << mhz(entorno.frecuencia_max_mhz) << "\n"
+           << "ENT carga: " << (entorno.carga >= 0 ? std::to_string(entorno.carga) : "desconocida") << "\n";
+}
+
+} // namespace pqbench
@@ -0,0 +1,63 @@
+#ifndef PQBENCH_ENTORNO_H
+#define PQBENCH_ENTORNO_H
+
+#include <string>
+#include <vector>
+
+/*
+Entorno de ejecución de las mediciones.
+
+Los ciclos y los tiempos dependen del núcleo en el que se ejecuta el código, del
+gobernador de frecuencia, del turbo y de si el núcleo comparte unidades con su hermano
+SMT. Para que las ejecuciones de distintas máquinas se puedan comparar:
+- El proceso se puede fijar a un núcleo con sched_setaffinity y subir su prioridad
+  (nice -20 o SCHED_FIFO, que necesitan CAP_SYS_NICE).
+- Se lee de sysfs el gobernador, el turbo, el estado de SMT, los hermanos del núcleo y
+  su frecuencia, y de /proc/loadavg la carga de la máquina. Esta huella acompaña a cada
+  resultado con líneas "ENT " para que benchmark.py la añada a cada fila.
+- Se avisa si la máquina está cargada, si el gobernador no es "performance", si el turbo
+  está activo o si la frecuencia del núcleo ha cambiado durante la evaluación; con
+  --estricto esos avisos hacen fallar la ejecución.
+Lo que no se puede leer (p. ej. sin cpufreq en una máquina virtual) queda como "desconocido".
+*/
+
+namespace pqbench {
+
+struct EntornoEjecucion {
+    std::string maquina;
+    int nucleo = -1;            // Núcleo en el que se ejecuta al leer el entorno
+    bool fijado = false;        // Con sched_setaffinity a ese único núcleo
+    std::string prioridad;      // "normal", "nice -20" o "SCHED_FIFO 1"
+    std::string gobernador;
+    std::string turbo;          // "activo", "inactivo" o "desconocido"
+    std::string smt;            // /sys/devices/system/cpu/smt/control
+    std::string hermanos;       // Núcleos lógicos que comparten el núcleo físico
+    double frecuencia_mhz = 0;  // Frecuencia actual del núcleo (0 = desconocida)
+    double frecuencia_min_mhz = 0;
+    double frecuencia_max_mhz = 0;
+    double carga = -1;          // Carga media del último minuto
+};
+
+// Fija el proceso (y los hilos que cree después) al núcleo indicado; lanza una excepción si falla
+void fijar_nucleo(int nucleo);
+
+// Sube la prioridad del proceso: "nice" (nice -20) o "fifo" (SCHED_FIFO); lanza una excepción si falla
+void subir_prioridad(const std::string& modo);
+
+EntornoEjecucion leer_entorno();
+
+// Frecuencia actual del núcleo en MHz (0 si no se puede leer)
+double frecuencia_nucleo(int nucleo);
+
+/*
+Avisos de ruido: carga por encima de carga_maxima, gobernador distinto de "performance",
+turbo activo y, si se indica el entorno al terminar, cambio de frecuencia de más del 5 %.
+*/
+std::vector<std::string> avisos_entorno(const EntornoEjecucion& inicio, double carga_maxima,
+                                        const EntornoEjecucion* fin = nullptr);
+
+void imprimir_entorno(const EntornoEjecucion& entorno, double frecuencia_final_mhz, std::ostream& salida);
+
+} // namespace pqbench
+
+#endif
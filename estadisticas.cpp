@@ -0,0 +1,166 @@
+#include "estadisticas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+namespace pqbench {
+
+double percentil(const std::vector<double>& ordenados, double p) {
+    if(ordenados.empty()) {
+        return 0;
+    }
+
+    // Posición fraccionaria dentro de la serie e interpolación lineal entre vecinos
+    double posicion = (p / 100.0) * (ordenados.size() - 1);
+    size_t abajo = static_cast<size_t>(std::floor(posicion));
+    size_t arriba = std::min(abajo + 1, ordenados.size() - 1);
+    double fraccion = posicion - abajo;
+
+    return ordenados[abajo] + fraccion * (ordenados[arriba] - ordenados[abajo]);
+}
+
+Estadisticas calcular_estadisticas(std::vector<double> valores) {
+    Estadisticas e;
+    e.muestras = valores.size();
+    if(valores.empty()) {
+        return e;
+    }
+
+    std::sort(valores.begin(), valores.end());
+
+    e.min = valores.front();
+    e.max = valores.back();
+    e.mediana = percentil(valores, 50);
+    e.p90 = percentil(valores, 90);
+    e.p99 = percentil(valores, 99);
+    e.media = std::accumulate(valores.begin(), valores.end(), 0.0) / valores.size();
+
+    if(valores.size() > 1) {
+        double suma = 0;
+        for(double v : valores) {
+            suma += (v - e.media) * (v - e.media);
+        }
+        e.desviacion = std::sqrt(suma / (valores.size() - 1));
+    }
+
+    return e;
+}
+
+std::vector<bool> filtrar_outliers_mad(const std::vector<double>& valores, double umbral) {
+    std::vector<bool> conservar(valores.size(), true);
+    if(umbral <= 0 || valores.size() < 3) {
+        return conservar;
+    }
+
+    std::vector<double> ordenados(valores);
+    std::sort(ordenados.begin(), ordenados.end());
+    double mediana = percentil(ordenados, 50);
+
+    std::vector<double> desviaciones;
+    for(double v : valores) {
+        desviaciones.push_back(std::abs(v - mediana));
+    }
+    std::sort(desviaciones.begin(), desviaciones.end());
+    double mad = percentil(desviaciones, 50);
+
+    if(mad == 0) {
+        return conservar;
+    }
+
+    for(size_t i = 0; i < valores.size(); ++i) {
+        conservar[i] = std::abs(valores[i] - mediana) <= umbral * 1.4826 * mad;
+    }
+
+    return conservar;
+}
+
+// Mediana de una serie sin ordenar (la reordena)
+static double mediana(std::vector<double>& valores) {
+    std::sort(valores.begin(), valores.end());
+    return percentil(valores, 50);
+}
+
+Intervalo bootstrap_cociente_medianas(const std::vector<double>& base, const std::vector<double>& actual,
+                                      double confianza, size_t remuestreos, uint64_t semilla) {
+    if(base.empty() || actual.empty()) {
+        return {};
+    }
+
+    std::mt19937_64 generador(semilla);
+    auto remuestrear = [&](const std::vector<double>& serie, std::vector<double>& destino) {
+        std::uniform_int_distribution<size_t> indice(0, serie.size() - 1);
+        for(double& v : destino) {
+            v = serie[indice(generador)];
+        }
+        return mediana(destino);
+    };
+
+    std::vector<double> copia_base(base.size());
+    std::vector<double> copia_actual(actual.size());
+    std::vector<double> cocientes;
+    cocientes.reserve(remuestreos);
+    for(size_t i = 0; i < remuestreos; ++i) {
+        double m_base = base.size() == 1 ? base[0] : remuestrear(base, copia_base);
+        double m_actual = remuestrear(actual, copia_actual);
+        if(m_base > 0) {
+            cocientes.push_back(m_actual / m_base);
+        }
+    }
+
+    if(cocientes.empty()) {
+        return {};
+    }
+    std::sort(cocientes.begin(), cocientes.end());
+    return {percentil(cocientes, 50 * (1 - confianza)), percentil(cocientes, 50 * (1 + confianza))};
+}
+
+double mann_whitney_p(const std::vector<double>& a, const std::vector<double>& b) {
+    if(a.empty() || b.empty()) {
+        return 1;
+    }
+
+    // Rangos de la serie conjunta; los empates reciben el rango medio
+    std::vector<std::pair<double, bool>> todos; // (valor, es de a)
+    for(double v : a) {
+        todos.emplace_back(v, true);
+    }
+    for(double v : b) {
+        todos.emplace_back(v, false);
+    }
+    std::sort(todos.begin(), todos.end());
+
+    double rangos_a = 0;
+    double empates = 0; // Suma de t^3 - t de cada grupo de empates
+    for(size_t i = 0; i < todos.size();) {
+        size_t j = i;
+        while(j < todos.size() && todos[j].first == todos[i].first) {
+            ++j;
+        }
+        double rango = (i + 1 + j) / 2.0;
+        for(size_t k = i; k < j; ++k) {
+            if(todos[k].second) {
+                rangos_a += rango;
+            }
+        }
+        double t = static_cast<double>(j - i);
+        empates += t * t * t - t;
+        i = j;
+    }
+
+    double n1 = static_cast<double>(a.size());
+    double n2 = static_cast<double>(b.size());
+    double n = n1 + n2;
+    double u = rangos_a - n1 * (n1 + 1) / 2;
+    double media = n1 * n2 / 2;
+    double varianza = n1 * n2 / 12 * ((n + 1) - empates / (n * (n - 1)));
+    if(varianza <= 0) {
+        return 1;
+    }
+
+    double z = (std::abs(u - media) - 0.5) / std::sqrt(varianza);
+    return std::min(1.0, std::erfc(std::max(z, 0.0) / std::sqrt(2.0)));
+}
+
+} // namespace pqbench
@@ -0,0 +1,66 @@
+#ifndef PQBENCH_ESTADISTICAS_H
+#define PQBENCH_ESTADISTICAS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+Estadísticas de una serie de muestras de una operación (keygen, firma o verificación).
+*/
+
+namespace pqbench {
+
+// Estadísticos de una serie de valores
+struct Estadisticas {
+    size_t muestras = 0;
+    double min = 0;
+    double mediana = 0;
+    double media = 0;
+    double desviacion = 0; // Desviación típica muestral
+    double p90 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+// Calcula los estadísticos de una serie de valores (no tiene por qué estar ordenada)
+Estadisticas calcular_estadisticas(std::vector<double> valores);
+
+// Percentil p (entre 0 y 100) de una serie ordenada, interpolando entre muestras
+double percentil(const std::vector<double>& ordenados, double p);
+
+/*
+Rechazo de valores atípicos basado en la mediana de las desviaciones absolutas (MAD).
+Devuelve, para cada valor, si se conserva: se descartan los valores cuya distancia a la
+mediana supera umbral * 1.4826 * MAD (1.4826 escala la MAD a la desviación típica de
+una normal). Con umbral <= 0 o MAD nula se conservan todos.
+*/
+std::vector<bool> filtrar_outliers_mad(const std::vector<double>& valores, double umbral);
+
+// Intervalo de confianza [inferior, superior] de un estimador
+struct Intervalo {
+    double inferior = 0;
+    double superior = 0;
+};
+
+/*
+Intervalo bootstrap de percentiles para el cociente mediana(actual) / mediana(base):
+se remuestrean con reemplazo las dos series `remuestreos` veces y se toman los
+percentiles (1 - confianza) / 2 y (1 + confianza) / 2 de los cocientes. Si la base tiene
+un único valor se trata como fijo y el intervalo es el de la mediana actual dividida
+entre él. La semilla hace que el intervalo sea reproducible.
+*/
+Intervalo bootstrap_cociente_medianas(const std::vector<double>& base, const std::vector<double>& actual,
+                                      double confianza, size_t remuestreos, uint64_t semilla = 0);
+
+/*
+Prueba U de Mann-Whitney de dos colas: probabilidad de obtener una diferencia de rangos
+al menos tan grande si las dos series vienen de la misma distribución. Usa la
+aproximación normal con corrección de empates y de continuidad, razonable a partir de
+unas 8 muestras por serie. Devuelve 1 si alguna serie está vacía.
+*/
+double mann_whitney_p(const std::vector<double>& a, const std::vector<double>& b);
+
+} // namespace pqbench
+
+#endif
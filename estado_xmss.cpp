@@ -0,0 +1,403 @@
+#include "estado_xmss.h"
+#include "binario.h"
+#include "cache_claves.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace pqbench {
+
+// ----- FICHERO DE ESTADO -----
+
+static const size_t TAM_RANURA = 64;
+static const char MAGIA_ESTADO[4] = {'P', 'Q', 'B', 'E'};
+
+// FNV-1a de 32 bits: basta para detectar una ranura escrita a medias
+static uint32_t suma_comprobacion(std::span<const uint8_t> datos) {
+    uint32_t h = 2166136261u;
+    for(uint8_t b : datos) {
+        h = (h ^ b) * 16777619u;
+    }
+    return h;
+}
+
+static std::vector<uint8_t> codificar_ranura(uint64_t secuencia, uint64_t reservada) {
+    std::vector<uint8_t> ranura(MAGIA_ESTADO, MAGIA_ESTADO + sizeof(MAGIA_ESTADO));
+    std::vector<uint8_t> contenido;
+    poner_entero(contenido, secuencia, 8);
+    poner_entero(contenido, reservada, 8);
+
+    poner_entero(ranura, suma_comprobacion(contenido), 4);
+    ranura.insert(ranura.end(), contenido.begin(), contenido.end());
+    ranura.resize(TAM_RANURA, 0);
+    return ranura;
+}
+
+// Devuelve {secuencia, reservada} de la ranura, o nada si no es válida
+static std::optional<std::pair<uint64_t, uint64_t>> decodificar_ranura(std::span<const uint8_t> ranura) {
+    if(ranura.size() < TAM_RANURA || !std::equal(MAGIA_ESTADO, MAGIA_ESTADO + sizeof(MAGIA_ESTADO), ranura.begin())) {
+        return std::nullopt;
+    }
+
+    size_t pos = sizeof(MAGIA_ESTADO);
+    uint32_t suma = static_cast<uint32_t>(leer_entero(ranura, pos, 4));
+    if(suma != suma_comprobacion(ranura.subspan(pos, 16))) {
+        return std::nullopt;
+    }
+
+    uint64_t secuencia = leer_entero(ranura, pos, 8);
+    uint64_t reservada = leer_entero(ranura, pos, 8);
+    return std::make_pair(secuencia, reservada);
+}
+
+static void escribir_en(int fd, std::span<const uint8_t> datos, off_t desplazamiento, const std::string& fichero) {
+    size_t escritos = 0;
+    while(escritos < datos.size()) {
+        ssize_t n = ::pwrite(fd, datos.data() + escritos, datos.size() - escritos, desplazamiento + escritos);
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        if(n < 0) {
+            throw std::runtime_error("No se pudo escribir " + fichero + ": " + std::strerror(errno));
+        }
+        escritos += static_cast<size_t>(n);
+    }
+}
+
+// ----- FIRMADOR -----
+
+FirmadorXMSS::FirmadorXMSS(const Esquema& esquema, std::unique_ptr<Botan::Private_Key> clave, int fd,
+                           size_t hoja, uint64_t secuencia, size_t reserva) :
+    m_esquema(&esquema),
+    m_clave(std::move(clave)),
+    m_rng(std::make_unique<Botan::AutoSeeded_RNG>()),
+    m_fd(fd),
+    m_reservada(hoja), // Tras crear o recuperar no hay ninguna hoja reservada todavía
+    m_secuencia(secuencia),
+    m_reserva(std::max<size_t>(reserva, 1)) {
+
+    m_signer = std::make_unique<Botan::PK_Signer>(*m_clave, *m_rng, esquema.padding_firma());
+}
+
+FirmadorXMSS::FirmadorXMSS(FirmadorXMSS&& otro) noexcept :
+    m_esquema(otro.m_esquema),
+    m_clave(std::move(otro.m_clave)),
+    m_rng(std::move(otro.m_rng)),
+    m_signer(std::move(otro.m_signer)),
+    m_fd(std::exchange(otro.m_fd, -1)),
+    m_reservada(otro.m_reservada),
+    m_secuencia(otro.m_secuencia),
+    m_reserva(otro.m_reserva),
+    m_sincronizaciones(otro.m_sincronizaciones) {}
+
+FirmadorXMSS::~FirmadorXMSS() {
+    if(m_fd >= 0) {
+        ::close(m_fd);
+    }
+}
+
+FirmadorXMSS FirmadorXMSS::crear(const Esquema& esquema, const std::string& ruta,
+                                 const Botan::Private_Key& clave, size_t reserva) {
+    const EsquemaXMSS& xmss = esquema_xmss(esquema);
+    Botan::secure_vector<uint8_t> bits = clave.private_key_bits();
+    escribir_fichero_atomico(ruta + ".clave", bits);
+
+    std::string fichero = ruta + ".estado";
+    int fd = ::open(fichero.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if(fd < 0) {
+        throw std::runtime_error("No se pudo crear " + fichero + ": " + std::strerror(errno));
+    }
+
+    // Estado inicial: ninguna hoja reservada por encima de la actual de la clave
+    size_t hoja = EsquemaXMSS::A::hoja_actual(xmss.parametros(), dynamic_cast<const Botan::XMSS_PrivateKey&>(clave));
+    try {
+        escribir_en(fd, codificar_ranura(0, hoja), 0, fichero);
+        escribir_en(fd, std::vector<uint8_t>(TAM_RANURA, 0), TAM_RANURA, fichero);
+        if(::fsync(fd) != 0) {
+            throw std::runtime_error("No se pudo sincronizar " + fichero + ": " + std::strerror(errno));
+        }
+        sincronizar_directorio(fichero);
+    } catch(...) {
+        ::close(fd);
+        throw;
+    }
+
+    return FirmadorXMSS(esquema, esquema.cargar_clave_privada(bits), fd, hoja, 0, reserva);
+}
+
+FirmadorXMSS FirmadorXMSS::recuperar(const Esquema& esquema, const std::string& ruta, size_t reserva) {
+    const EsquemaXMSS& xmss = esquema_xmss(esquema);
+    std::vector<uint8_t> bits = leer_fichero(ruta + ".clave");
+
+    std::string fichero = ruta + ".estado";
+    std::vector<uint8_t> estado = leer_fichero(fichero);
+
+    // Se toma la ranura válida más reciente; la otra puede haber quedado a medias
+    std::optional<std::pair<uint64_t, uint64_t>> elegida;
+    for(size_t r = 0; r < 2 && (r + 1) * TAM_RANURA <= estado.size(); ++r) {
+        auto ranura = decodificar_ranura(std::span(estado).subspan(r * TAM_RANURA, TAM_RANURA));
+        if(ranura && (!elegida || ranura->first > elegida->first)) {
+            elegida = ranura;
+        }
+    }
+
+    if(!elegida) {
+        throw std::runtime_error("El estado " + fichero + " no es válido: no es seguro seguir firmando con esta clave");
+    }
+
+    // Se continúa en la primera hoja no reservada: las reservadas sin usar se descartan
+    auto guardada = esquema.cargar_clave_privada(bits);
+    auto clave = EsquemaXMSS::A::saltar_a_hoja(xmss.parametros(), dynamic_cast<const Botan::XMSS_PrivateKey&>(*guardada),
+                                               elegida->second);
+
+    int fd = ::open(fichero.c_str(), O_RDWR);
+    if(fd < 0) {
+        throw std::runtime_error("No se pudo abrir " + fichero + ": " + std::strerror(errno));
+    }
+
+    return FirmadorXMSS(esquema, std::move(clave), fd, elegida->second, elegida->first, reserva);
+}
+
+size_t FirmadorXMSS::hoja() const {
+    const EsquemaXMSS& xmss = esquema_xmss(*m_esquema);
+    return EsquemaXMSS::A::hoja_actual(xmss.parametros(), dynamic_cast<const Botan::XMSS_PrivateKey&>(*m_clave));
+}
+
+void FirmadorXMSS::reservar() {
+    const EsquemaXMSS& xmss = esquema_xmss(*m_esquema);
+    size_t nueva = std::min(hoja() + m_reserva, xmss.parametros().total_number_of_signatures());
+
+    // La ranura que no contiene el último estado bueno es la que se sobrescribe
+    uint64_t secuencia = m_secuencia + 1;
+    escribir_en(m_fd, codificar_ranura(secuencia, nueva), (secuencia % 2) * TAM_RANURA, "el estado de XMSS");
+    if(::fdatasync(m_fd) != 0) {
+        throw std::runtime_error(std::string("No se pudo sincronizar el estado de XMSS: ") + std::strerror(errno));
+    }
+
+    m_secuencia = secuencia;
+    m_reservada = nueva;
+    ++m_sincronizaciones;
+}
+
+std::vector<uint8_t> FirmadorXMSS::firmar(std::span<const uint8_t> mensaje) {
+    /*
+    La hoja se lee de la clave y no de un contador propio: Botan comparte el índice entre
+    todas las copias de la clave del proceso, así que otra copia puede haberlo avanzado.
+    */
+    if(hoja() >= m_reservada) {
+        reservar();
+    }
+
+    m_signer->update(mensaje.data(), mensaje.size());
+    return m_signer->signature(*m_rng);
+}
+
+// ----- MODO estado-xmss -----
+
+// Resultado de firmar con un tamaño de reserva, caer y recuperar el firmador
+struct ResultadoEstado {
+    size_t reserva = 0;
+    size_t firmas = 0;
+    double segundos = 0;
+    Estadisticas latencia;
+    size_t sincronizaciones = 0;
+    size_t hojas_perdidas = 0;   // Reservadas y no usadas al caer
+    bool recuperacion_correcta = false;
+};
+
+// Resumen que el hijo envía al padre por la tubería después de las latencias
+struct MuestraEstado {
+    double segundos;
+    uint64_t sincronizaciones;
+    uint64_t ultima_usada;
+};
+
+/*
+Código del proceso hijo: firma y cae con SIGKILL sin cerrar nada. Así el padre sólo puede
+continuar a partir de lo que haya en disco, y no del índice que Botan guarda en memoria
+para la clave.
+*/
+[[noreturn]] static void hijo_estado(const Esquema& esquema, const Botan::Private_Key& clave, size_t reserva,
+                                     size_t firmas, const std::string& ruta, int fd) {
+    try {
+        const Botan::secure_vector<uint8_t>& msg = mensaje_fijo();
+        FirmadorXMSS firmador = FirmadorXMSS::crear(esquema, ruta, clave, reserva);
+
+        std::vector<double> latencias;
+        auto inicio = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < firmas; ++i) {
+            latencias.push_back(medir([&] { firmador.firmar(msg); }).segundos);
+        }
+
+        MuestraEstado muestra{std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count(),
+                              firmador.sincronizaciones(), firmador.hoja() - 1};
+        if(escribir_todo(fd, latencias.data(), latencias.size() * sizeof(double)) &&
+           escribir_todo(fd, &muestra, sizeof(muestra))) {
+            ::raise(SIGKILL);
+        }
+    } catch(const std::exception& e) {
+        std::cerr << "Excepción firmando con reserva " << reserva << ": " << e.what() << "\n";
+    }
+
+    ::close(fd);
+    ::_exit(1);
+}
+
+static ResultadoEstado probar_reserva(const Esquema& esquema, const Botan::Private_Key& base, size_t hoja_inicial,
+                                      size_t reserva, size_t firmas, const std::string& ruta) {
+    const EsquemaXMSS& xmss = esquema_xmss(esquema);
+    const Botan::secure_vector<uint8_t>& msg = mensaje_fijo();
+
+    ResultadoEstado resultado;
+    resultado.reserva = reserva;
+    resultado.firmas = firmas;
+
+    auto clave = EsquemaXMSS::A::saltar_a_hoja(xmss.parametros(), dynamic_cast<const Botan::XMSS_PrivateKey&>(base), hoja_inicial);
+    std::unique_ptr<Botan::Public_Key> pub_key = clave->public_key();
+
+    int tuberia[2];
+    if(::pipe(tuberia) != 0) {
+        throw std::runtime_error(std::string("No se pudo crear la tubería: ") + std::strerror(errno));
+    }
+
+    std::cout.flush();
+    std::cerr.flush();
+
+    pid_t pid = ::fork();
+    if(pid < 0) {
+        ::close(tuberia[0]);
+        ::close(tuberia[1]);
+        throw std::runtime_error(std::string("No se pudo crear el proceso hijo: ") + std::strerror(errno));
+    }
+    if(pid == 0) {
+        ::close(tuberia[0]);
+        hijo_estado(esquema, *clave, reserva, firmas, ruta, tuberia[1]);
+    }
+    ::close(tuberia[1]);
+
+    std::vector<double> latencias(firmas);
+    MuestraEstado muestra{};
+    bool completo = leer_todo(tuberia[0], latencias.data(), latencias.size() * sizeof(double)) &&
+                    leer_todo(tuberia[0], &muestra, sizeof(muestra));
+    ::close(tuberia[0]);
+
+    int estado = 0;
+    while(::waitpid(pid, &estado, 0) < 0 && errno == EINTR) {}
+
+    if(!completo || !WIFSIGNALED(estado) || WTERMSIG(estado) != SIGKILL) {
+        std::filesystem::remove(ruta + ".clave");
+        std::filesystem::remove(ruta + ".estado");
+        return resultado;
+    }
+
+    resultado.segundos = muestra.segundos;
+    resultado.latencia = calcular_estadisticas(std::move(latencias));
+    resultado.sincronizaciones = muestra.sincronizaciones;
+
+    /*
+    El padre recupera desde los ficheros que dejó el hijo. La hoja desde la que sigue tiene
+    que ser la de la clave recargada y estar por encima de la última que usó el hijo, y la
+    firma hecha con ella tiene que verificar.
+    */
+    FirmadorXMSS recuperado = FirmadorXMSS::recuperar(esquema, ruta, reserva);
+    auto recargada = esquema.cargar_clave_privada(leer_fichero(ruta + ".clave"));
+    size_t hoja = EsquemaXMSS::A::hoja_actual(xmss.parametros(), dynamic_cast<const Botan::XMSS_PrivateKey&>(*recargada));
+    resultado.hojas_perdidas = hoja > muestra.ultima_usada ? hoja - muestra.ultima_usada - 1 : 0;
+    bool continua = recuperado.hoja() == hoja && hoja > muestra.ultima_usada;
+
+    std::vector<uint8_t> firma = recuperado.firmar(msg);
+    Botan::PK_Verifier verifier(*pub_key, esquema.padding_verificacion());
+    verifier.update(msg.data(), msg.size());
+    resultado.recuperacion_correcta = continua && verifier.check_signature(firma.data(), firma.size());
+
+    std::filesystem::remove(ruta + ".clave");
+    std::filesystem::remove(ruta + ".estado");
+    return resultado;
+}
+
+static void imprimir_estados(const std::vector<ResultadoEstado>& resultados, std::ostream& salida) {
+    salida << std::setw(8) << "K" << std::setw(12) << "firmas/s" << std::setw(14) << "p50 (s)" << std::setw(14) << "p99 (s)"
+           << std::setw(14) << "Máx (s)" << std::setw(8) << "fsync" << std::setw(16) << "Hojas perdidas"
+           << std::setw(16) << "Máx por caída" << std::setw(14) << "Recuperación" << "\n";
+
+    for(const auto& r : resultados) {
+        salida << std::setw(8) << r.reserva
+               << std::setw(12) << std::fixed << std::setprecision(1) << (r.segundos > 0 ? r.firmas / r.segundos : 0)
+               << std::defaultfloat << std::setprecision(6)
+               << std::setw(14) << r.latencia.mediana << std::setw(14) << r.latencia.p99 << std::setw(14) << r.latencia.max
+               << std::setw(8) << r.sincronizaciones << std::setw(16) << r.hojas_perdidas
+               << std::setw(16) << r.reserva - 1 << std::setw(14) << (r.recuperacion_correcta ? "correcta" : "ERRÓNEA") << "\n";
+    }
+}
+
+int ejecutar_estado_xmss(const Argumentos& args) {
+    if(args.posicionales().size() != 1) {
+        std::cerr << "Uso: ./pqbench estado-xmss <set XMSS> [--reservas=1,4,16,64,256] [--firmas=128] [--directorio=d]"
+                     " [--cache-claves[=d]] [--semilla=N]\n";
+        return 1;
+    }
+
+    Opciones opciones = leer_opciones(args);
+    std::vector<long> reservas = args.enteros("reservas", {1, 4, 16, 64, 256});
+    long firmas = args.entero("firmas", 128);
+    std::string directorio = args.texto("directorio", ".pqbench-estado");
+
+    if(firmas < 1 || std::any_of(reservas.begin(), reservas.end(), [](long k) { return k < 1; })) {
+        std::cerr << "Opciones inválidas para el modo estado-xmss.\n";
+        return 1;
+    }
+
+    Conjunto conjunto = buscar_conjunto(args.posicionales()[0], false);
+    auto esquema = crear_esquema(conjunto);
+    const EsquemaXMSS& xmss = esquema_xmss(*esquema);
+
+    ClaveObtenida obtenida = obtener_clave(*esquema, opciones);
+    const auto& base = dynamic_cast<const Botan::XMSS_PrivateKey&>(*obtenida.clave);
+
+    /*
+    Cada K usa su propio rango de hojas de la clave: sus firmas, las hojas que se pierden
+    en la caída y la firma de después de recuperar.
+    */
+    size_t hoja = EsquemaXMSS::A::hoja_actual(xmss.parametros(), base);
+    size_t necesarias = 0;
+    for(long k : reservas) {
+        necesarias += firmas + k;
+    }
+    if(hoja + necesarias > xmss.parametros().total_number_of_signatures()) {
+        std::cerr << "La clave no tiene hojas suficientes (" << necesarias << " necesarias desde la hoja " << hoja
+                  << "); reduce --firmas o --reservas.\n";
+        return 1;
+    }
+
+    std::filesystem::create_directories(directorio);
+    std::cout << "ESTADO PERSISTENTE DE " << conjunto.nombre << " | " << firmas << " firmas por reserva | estado en "
+              << directorio << "\n";
+
+    std::vector<ResultadoEstado> resultados;
+    for(long k : reservas) {
+        resultados.push_back(probar_reserva(*esquema, base, hoja, k, firmas, directorio + "/" + conjunto.nombre));
+        hoja += firmas + k;
+    }
+    imprimir_estados(resultados, std::cout);
+
+    // La clave de la caché avanza más allá de todas las hojas usadas aquí
+    if(!obtenida.ruta.empty()) {
+        auto avanzada = EsquemaXMSS::A::saltar_a_hoja(xmss.parametros(), base, hoja);
+        guardar_clave_cacheada(obtenida.ruta, conjunto, opciones.semilla_claves, *avanzada,
+                               obtenida.keygen.segundos, obtenida.keygen.ciclos);
+    }
+
+    bool correcto = std::all_of(resultados.begin(), resultados.end(), [](const ResultadoEstado& r) { return r.recuperacion_correcta; });
+    return correcto ? 0 : 1;
+}
+
+} // namespace pqbench
@@ -0,0 +1,73 @@
+#ifndef PQBENCH_ESTADO_XMSS_H
+#define PQBENCH_ESTADO_XMSS_H
+
+#include "pqbench.h"
+
+/*
+Estado persistente y a prueba de caídas para firmar con XMSS.
+
+Con XMSS una hoja no se puede usar dos veces, así que antes de entregar una firma el
+índice tiene que estar guardado en disco. Hacer un fsync por firma domina la latencia,
+de modo que el firmador reserva bloques de K hojas: al empezar cada bloque anota en el
+fichero de estado la primera hoja no reservada y hace un único fdatasync. Si el proceso
+cae, al recuperarse continúa en esa hoja y se pierden (nunca se reutilizan) las hojas
+reservadas que no se llegaron a usar: como mucho K - 1 por caída.
+
+Ficheros, con <ruta> la base indicada:
+  <ruta>.clave   private_key_bits() de la clave, escrito una vez de forma atómica
+  <ruta>.estado  dos ranuras de 64 bytes que se escriben de forma alterna:
+                 "PQBE", u32 suma de comprobación, u64 secuencia, u64 primera hoja no reservada
+Al recuperar se toma la ranura válida con la secuencia más alta, así que una escritura
+interrumpida a medias no deja el estado inservible.
+*/
+
+namespace pqbench {
+
+class FirmadorXMSS {
+public:
+    // Empieza a firmar con una clave nueva desde la hoja en la que esté
+    static FirmadorXMSS crear(const Esquema& esquema, const std::string& ruta,
+                              const Botan::Private_Key& clave, size_t reserva);
+
+    // Recupera el firmador tras un reinicio o una caída
+    static FirmadorXMSS recuperar(const Esquema& esquema, const std::string& ruta, size_t reserva);
+
+    FirmadorXMSS(FirmadorXMSS&& otro) noexcept;
+    FirmadorXMSS& operator=(FirmadorXMSS&&) = delete;
+    ~FirmadorXMSS();
+
+    // Firma el mensaje; si la hoja no estaba reservada, reserva antes el siguiente bloque
+    std::vector<uint8_t> firmar(std::span<const uint8_t> mensaje);
+
+    size_t hoja() const;                               // Siguiente hoja que se usará, según la clave
+    size_t reservada() const { return m_reservada; }   // Primera hoja no reservada
+    size_t sincronizaciones() const { return m_sincronizaciones; }
+    std::unique_ptr<Botan::Public_Key> clave_publica() const { return m_clave->public_key(); }
+
+private:
+    FirmadorXMSS(const Esquema& esquema, std::unique_ptr<Botan::Private_Key> clave, int fd,
+                 size_t hoja, uint64_t secuencia, size_t reserva);
+
+    void reservar();
+
+    const Esquema* m_esquema;
+    std::unique_ptr<Botan::Private_Key> m_clave;
+    std::unique_ptr<Botan::AutoSeeded_RNG> m_rng;
+    std::unique_ptr<Botan::PK_Signer> m_signer;
+    int m_fd;
+    size_t m_reservada;
+    uint64_t m_secuencia;
+    size_t m_reserva;
+    size_t m_sincronizaciones = 0;
+};
+
+/*
+Punto de entrada del modo desde la línea de comandos:
+  ./pqbench estado-xmss <set XMSS> [--reservas=1,4,16,64,256] [--firmas=128] [--directorio=d]
+                        [--cache-claves[=d]] [--semilla=N]
+*/
+int ejecutar_estado_xmss(const Argumentos& args);
+
+} // namespace pqbench
+
+#endif
@@ -0,0 +1,359 @@
+#include "fichero.h"
+#include "binario.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pqbench {
+
+// ----- FIRMA SEPARADA -----
+
+static const char MAGIA_FIRMA[8] = {'P', 'Q', 'B', 'F', 'I', 'R', 'M', '1'};
+
+void FirmaFichero::guardar(const std::string& fichero) const {
+    std::vector<uint8_t> contenido(MAGIA_FIRMA, MAGIA_FIRMA + sizeof(MAGIA_FIRMA));
+    poner_entero(contenido, conjunto.prehash ? 1 : 0, 1);
+    poner_campo(contenido, std::span(reinterpret_cast<const uint8_t*>(conjunto.nombre.data()), conjunto.nombre.size()), 2);
+    poner_campo(contenido, clave_publica);
+    poner_campo(contenido, firma);
+    escribir_fichero(fichero, contenido);
+}
+
+FirmaFichero FirmaFichero::cargar(const std::string& fichero) {
+    std::vector<uint8_t> contenido = leer_fichero(fichero);
+    if(contenido.size() < sizeof(MAGIA_FIRMA) || !std::equal(MAGIA_FIRMA, MAGIA_FIRMA + sizeof(MAGIA_FIRMA), contenido.begin())) {
+        throw std::runtime_error("El fichero " + fichero + " no es una firma de pqbench");
+    }
+
+    size_t pos = sizeof(MAGIA_FIRMA);
+    bool prehash = leer_entero(contenido, pos, 1) != 0;
+    std::span<const uint8_t> nombre = leer_campo(contenido, pos, 2);
+    std::span<const uint8_t> clave = leer_campo(contenido, pos);
+    std::span<const uint8_t> bytes = leer_campo(contenido, pos);
+
+    FirmaFichero firma;
+    firma.conjunto = buscar_conjunto(std::string(nombre.begin(), nombre.end()), prehash);
+    firma.clave_publica.assign(clave.begin(), clave.end());
+    firma.firma.assign(bytes.begin(), bytes.end());
+    return firma;
+}
+
+// ----- LECTURA DEL FICHERO -----
+
+static double segundos_desde(std::chrono::steady_clock::time_point inicio) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+}
+
+static void lanzar_errno(const std::string& que, const std::string& fichero) {
+    throw std::runtime_error(que + " " + fichero + ": " + std::strerror(errno));
+}
+
+namespace {
+
+// Descriptor que se cierra al salir del ámbito, también si actualizar() o terminar() lanzan
+struct Descriptor {
+    int fd;
+
+    explicit Descriptor(int fd) : fd(fd) {}
+    ~Descriptor() { ::close(fd); }
+    Descriptor(const Descriptor&) = delete;
+    Descriptor& operator=(const Descriptor&) = delete;
+};
+
+/*
+Proyección que se deshace al salir del ámbito. En el camino normal se deshace antes con
+liberar() para poder medir el munmap como E/S.
+*/
+struct Proyeccion {
+    void* datos = nullptr;
+    size_t tam = 0;
+
+    Proyeccion() = default;
+    ~Proyeccion() { liberar(); }
+    Proyeccion(const Proyeccion&) = delete;
+    Proyeccion& operator=(const Proyeccion&) = delete;
+
+    void liberar() {
+        if(datos != nullptr) {
+            ::munmap(datos, tam);
+            datos = nullptr;
+        }
+    }
+};
+
+} // namespace
+
+/*
+Pasa el fichero completo a actualizar(datos, tam) y después llama a terminar().
+Con buffer = 0 se usa mmap; si no, read() con un buffer de ese tamaño.
+*/
+template<typename Actualizar, typename Terminar>
+static RecorridoFichero recorrer_fichero(const std::string& fichero, size_t buffer, bool frio,
+                                         Actualizar&& actualizar, Terminar&& terminar) {
+    RecorridoFichero recorrido;
+
+    int abierto = ::open(fichero.c_str(), O_RDONLY);
+    if(abierto < 0) {
+        lanzar_errno("No se pudo abrir", fichero);
+    }
+    Descriptor descriptor(abierto);
+    int fd = descriptor.fd;
+
+    // Las páginas limpias se pueden expulsar de la caché sin privilegios
+    if(frio) {
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+
+    struct stat info;
+    if(::fstat(fd, &info) != 0) {
+        lanzar_errno("No se pudo consultar", fichero);
+    }
+    size_t tam = static_cast<size_t>(info.st_size);
+
+    struct rusage uso_antes, uso_despues;
+    ::getrusage(RUSAGE_THREAD, &uso_antes);
+
+    if(buffer == 0) {
+        auto inicio = std::chrono::steady_clock::now();
+        Proyeccion proyeccion;
+        if(tam > 0) {
+            void* datos = ::mmap(nullptr, tam, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(datos == MAP_FAILED) {
+                lanzar_errno("No se pudo proyectar", fichero);
+            }
+            proyeccion.datos = datos;
+            proyeccion.tam = tam;
+            ::madvise(datos, tam, MADV_SEQUENTIAL);
+        }
+        recorrido.segundos_es += segundos_desde(inicio);
+
+        inicio = std::chrono::steady_clock::now();
+        if(tam > 0) {
+            actualizar(static_cast<const uint8_t*>(proyeccion.datos), tam);
+        }
+        terminar();
+        recorrido.segundos_computo += segundos_desde(inicio);
+
+        inicio = std::chrono::steady_clock::now();
+        proyeccion.liberar();
+        recorrido.segundos_es += segundos_desde(inicio);
+    } else {
+        std::vector<uint8_t> datos(buffer);
+
+        while(true) {
+            auto inicio = std::chrono::steady_clock::now();
+            ssize_t leidos = ::read(fd, datos.data(), datos.size());
+            recorrido.segundos_es += segundos_desde(inicio);
+
+            if(leidos < 0) {
+                if(errno == EINTR) {
+                    continue;
+                }
+                lanzar_errno("Error al leer", fichero);
+            }
+            if(leidos == 0) {
+                break;
+            }
+
+            inicio = std::chrono::steady_clock::now();
+            actualizar(datos.data(), static_cast<size_t>(leidos));
+            recorrido.segundos_computo += segundos_desde(inicio);
+        }
+
+        auto inicio = std::chrono::steady_clock::now();
+        terminar();
+        recorrido.segundos_computo += segundos_desde(inicio);
+    }
+
+    ::getrusage(RUSAGE_THREAD, &uso_despues);
+    recorrido.fallos_menores = uso_despues.ru_minflt - uso_antes.ru_minflt;
+    recorrido.fallos_mayores = uso_despues.ru_majflt - uso_antes.ru_majflt;
+
+    return recorrido;
+}
+
+/*
+Repite la pasada con cada método según las opciones de medición. pasada(buffer)
+devuelve el recorrido y si el resultado es correcto.
+*/
+template<typename Pasada>
+static std::vector<MedicionFichero> medir_metodos(const std::vector<long>& buffers, const Opciones& opciones, Pasada&& pasada) {
+    std::vector<MedicionFichero> mediciones;
+
+    std::vector<long> metodos = {0};
+    metodos.insert(metodos.end(), buffers.begin(), buffers.end());
+
+    for(long buffer : metodos) {
+        MedicionFichero medicion;
+        medicion.buffer = buffer;
+
+        for(size_t i = 0; i < opciones.calentamiento; ++i) {
+            pasada(buffer);
+        }
+
+        std::vector<double> es, computo, total;
+        for(size_t i = 0; i < std::max<size_t>(opciones.iteraciones, 1); ++i) {
+            auto [recorrido, correcta] = pasada(buffer);
+            es.push_back(recorrido.segundos_es);
+            computo.push_back(recorrido.segundos_computo);
+            total.push_back(recorrido.segundos_es + recorrido.segundos_computo);
+            medicion.fallos_menores += recorrido.fallos_menores;
+            medicion.fallos_mayores += recorrido.fallos_mayores;
+            medicion.correcta = medicion.correcta && correcta;
+        }
+
+        medicion.fallos_menores /= total.size();
+        medicion.fallos_mayores /= total.size();
+        medicion.es = calcular_estadisticas(std::move(es));
+        medicion.computo = calcular_estadisticas(std::move(computo));
+        medicion.total = calcular_estadisticas(std::move(total));
+        mediciones.push_back(medicion);
+    }
+
+    return mediciones;
+}
+
+static void imprimir_mediciones(const std::vector<MedicionFichero>& mediciones, uint64_t bytes,
+                                const std::string& computo, std::ostream& salida) {
+    salida << std::left << std::setw(16) << "Método" << std::right << std::setw(14) << "E/S p50 (s)"
+           << std::setw(16) << (computo + " p50 (s)") << std::setw(16) << "Total p50 (s)" << std::setw(12) << "MB/s"
+           << std::setw(16) << "Fallos menores" << std::setw(16) << "Fallos mayores" << "\n";
+
+    for(const auto& m : mediciones) {
+        std::string metodo = m.buffer == 0 ? "mmap" : "read() " + formatear_bytes(m.buffer);
+
+        salida << std::left << std::setw(16) << metodo << std::right
+               << std::setw(14) << m.es.mediana << std::setw(16) << m.computo.mediana << std::setw(16) << m.total.mediana
+               << std::setw(12) << std::fixed << std::setprecision(2) << (m.total.mediana > 0 ? bytes / m.total.mediana / 1e6 : 0)
+               << std::setw(16) << std::setprecision(0) << m.fallos_menores << std::setw(16) << m.fallos_mayores
+               << std::defaultfloat << std::setprecision(6)
+               << (m.correcta ? "" : "  [!] Firma Errónea") << "\n";
+    }
+}
+
+static uint64_t tam_fichero(const std::string& fichero) {
+    struct stat info;
+    if(::stat(fichero.c_str(), &info) != 0) {
+        lanzar_errno("No se pudo consultar", fichero);
+    }
+    return static_cast<uint64_t>(info.st_size);
+}
+
+// ----- MODOS firmar-fichero Y verificar-fichero -----
+
+int ejecutar_firmar_fichero(const Argumentos& args) {
+    if(args.posicionales().size() != 2) {
+        std::cerr << "Uso: ./pqbench firmar-fichero <fichero> <set|familia|todos> [--buffers=4096,65536,1048576]"
+                     " [--frio] [--prehash] [--iteraciones=N] [--calentamiento=N]\n";
+        return 1;
+    }
+
+    const std::string& fichero = args.posicionales()[0];
+    Opciones opciones = leer_opciones(args);
+    std::vector<long> buffers = args.enteros("buffers", {4096, 65536, 1 << 20});
+    bool frio = args.activa("frio");
+
+    if(std::any_of(buffers.begin(), buffers.end(), [](long b) { return b < 1; })) {
+        std::cerr << "Opciones inválidas para el modo firmar-fichero.\n";
+        return 1;
+    }
+
+    std::vector<Conjunto> elegidos = seleccionar(args.posicionales()[1], args.activa("prehash"));
+    if(elegidos.empty()) {
+        std::cerr << "Set de parámetros inválido.\n";
+        return 1;
+    }
+
+    uint64_t bytes = tam_fichero(fichero);
+
+    int fallos = 0;
+    for(const auto& conjunto : elegidos) {
+        try {
+            auto esquema = crear_esquema(conjunto);
+            Botan::AutoSeeded_RNG rng;
+            auto clave = esquema->generar_clave(rng);
+            Botan::PK_Signer signer(*clave, rng, esquema->padding_firma());
+
+            FirmaFichero firma;
+            firma.conjunto = conjunto;
+            firma.clave_publica = clave->public_key_bits();
+
+            auto mediciones = medir_metodos(buffers, opciones, [&](size_t buffer) {
+                std::vector<uint8_t> signature;
+                auto recorrido = recorrer_fichero(fichero, buffer, frio,
+                    [&](const uint8_t* datos, size_t tam) { signer.update(datos, tam); },
+                    [&] { signature = signer.signature(rng); });
+
+                // Se guarda la firma hecha sobre la proyección
+                if(buffer == 0) {
+                    firma.firma = std::move(signature);
+                }
+                return std::make_pair(recorrido, true);
+            });
+
+            std::string salida = fichero + "." + conjunto.nombre + (conjunto.prehash ? "-prehash" : "") + ".firma";
+            firma.guardar(salida);
+
+            std::cout << "FIRMA DEL FICHERO " << fichero << " (" << formatear_bytes(bytes) << ") CON "
+                      << conjunto.nombre << (conjunto.prehash ? " (pre-hash)" : "") << "\n";
+            imprimir_mediciones(mediciones, bytes, "Firma", std::cout);
+            std::cout << "Firma separada (" << firma.firma.size() << " bytes) guardada en " << salida << "\n\n";
+        } catch(const std::exception& e) {
+            std::cerr << "Excepción en firmar-fichero(" << conjunto.nombre << "): " << e.what() << "\n";
+            ++fallos;
+        }
+    }
+
+    return fallos == 0 ? 0 : 1;
+}
+
+int ejecutar_verificar_fichero(const Argumentos& args) {
+    if(args.posicionales().size() != 2) {
+        std::cerr << "Uso: ./pqbench verificar-fichero <fichero> <firma> [--buffers=4096,65536,1048576]"
+                     " [--frio] [--iteraciones=N] [--calentamiento=N]\n";
+        return 1;
+    }
+
+    const std::string& fichero = args.posicionales()[0];
+    Opciones opciones = leer_opciones(args);
+    std::vector<long> buffers = args.enteros("buffers", {4096, 65536, 1 << 20});
+    bool frio = args.activa("frio");
+
+    if(std::any_of(buffers.begin(), buffers.end(), [](long b) { return b < 1; })) {
+        std::cerr << "Opciones inválidas para el modo verificar-fichero.\n";
+        return 1;
+    }
+
+    FirmaFichero firma = FirmaFichero::cargar(args.posicionales()[1]);
+    uint64_t bytes = tam_fichero(fichero);
+
+    auto esquema = crear_esquema(firma.conjunto);
+    auto pub_key = esquema->cargar_clave_publica(firma.clave_publica);
+    Botan::PK_Verifier verifier(*pub_key, esquema->padding_verificacion());
+
+    auto mediciones = medir_metodos(buffers, opciones, [&](size_t buffer) {
+        bool valida = false;
+        auto recorrido = recorrer_fichero(fichero, buffer, frio,
+            [&](const uint8_t* datos, size_t tam) { verifier.update(datos, tam); },
+            [&] { valida = verifier.check_signature(firma.firma.data(), firma.firma.size()); });
+        return std::make_pair(recorrido, valida);
+    });
+
+    std::cout << "VERIFICACIÓN DEL FICHERO " << fichero << " (" << formatear_bytes(bytes) << ") CON "
+              << firma.conjunto.nombre << (firma.conjunto.prehash ? " (pre-hash)" : "") << "\n";
+    imprimir_mediciones(mediciones, bytes, "Verif.", std::cout);
+
+    bool correcta = std::all_of(mediciones.begin(), mediciones.end(), [](const MedicionFichero& m) { return m.correcta; });
+    std::cout << (correcta ? "Firma Verificada." : "Firma Errónea.") << "\n";
+    return correcta ? 0 : 1;
+}
+
+} // namespace pqbench
@@ -0,0 +1,64 @@
+#ifndef PQBENCH_FICHERO_H
+#define PQBENCH_FICHERO_H
+
+#include "pqbench.h"
+
+/*
+Firma y verificación de ficheros en disco, como se firma un artefacto publicado.
+
+El fichero se lee de dos formas que se comparan entre sí:
+- mmap: se proyecta en memoria con madvise(MADV_SEQUENTIAL) y la proyección se pasa
+  tal cual a update(), sin copiarla a ningún buffer intermedio.
+- read(): se lee en bloques con un buffer de cada uno de los tamaños indicados.
+En las dos se separa el tiempo de E/S del de hash y firma (o verificación). Con mmap la
+lectura real ocurre en los fallos de página que provoca el hash, así que ese tiempo cae
+en la parte de cómputo; por eso se muestran también los fallos de página.
+
+La firma se guarda separada del fichero, junto con el set y la clave pública:
+  "PQBFIRM1", u8 prehash, u16 longitud + nombre del set,
+  u32 longitud + clave pública, u32 longitud + firma
+*/
+
+namespace pqbench {
+
+// Tiempos de una pasada sobre el fichero
+struct RecorridoFichero {
+    double segundos_es = 0;      // open/mmap/munmap o las llamadas a read()
+    double segundos_computo = 0; // update() y la firma o verificación final
+    long fallos_menores = 0;
+    long fallos_mayores = 0;
+};
+
+// Resultado de las pasadas con un método de lectura
+struct MedicionFichero {
+    size_t buffer = 0; // 0 = mmap
+    Estadisticas es;
+    Estadisticas computo;
+    Estadisticas total;
+    double fallos_menores = 0; // Media por pasada
+    double fallos_mayores = 0;
+    bool correcta = true;      // Todas las firmas verificadas (sólo en verificación)
+};
+
+// Firma separada de un fichero
+struct FirmaFichero {
+    Conjunto conjunto;
+    std::vector<uint8_t> clave_publica;
+    std::vector<uint8_t> firma;
+
+    void guardar(const std::string& fichero) const;
+    static FirmaFichero cargar(const std::string& fichero);
+};
+
+/*
+Puntos de entrada de los modos desde la línea de comandos:
+  ./pqbench firmar-fichero <fichero> <set|familia|todos> [--buffers=4096,65536,1048576] [--frio] [--prehash]
+  ./pqbench verificar-fichero <fichero> <firma> [--buffers=...] [--frio]
+Con --frio se expulsa el fichero de la caché de páginas antes de cada pasada.
+*/
+int ejecutar_firmar_fichero(const Argumentos& args);
+int ejecutar_verificar_fichero(const Argumentos& args);
+
+} // namespace pqbench
+
+#endif
@@ -0,0 +1,718 @@
+#include "pqbench.h"
+#include "cache_claves.h"
+#include "cpu.h"
+#include "keygen_hilos.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace pqbench {
+
+std::string nombre_familia(Familia familia) {
+    switch(familia) {
+        case Familia::ML_DSA: return "ML-DSA";
+        case Familia::SLH_DSA: return "SLH-DSA";
+        case Familia::XMSS: return "XMSS";
+    }
+    return "";
+}
+
+// Añade al registro los sets de parámetros que declara el adaptador de un esquema
+template<typename Parametros>
+static void registrar(std::vector<Conjunto>& registro) {
+    for(const auto& nombre : Adaptador<Parametros>::nombres()) {
+        registro.push_back({nombre, Adaptador<Parametros>::familia, false});
+    }
+}
+
+const std::vector<Conjunto>& conjuntos() {
+    static const std::vector<Conjunto> registro = [] {
+        std::vector<Conjunto> r;
+        registrar<Botan::DilithiumMode>(r);
+        registrar<Botan::Sphincs_Parameters>(r);
+        registrar<Botan::XMSS_Parameters>(r);
+        return r;
+    }();
+    return registro;
+}
+
+std::vector<Conjunto> seleccionar(const std::string& nombre, bool prehash) {
+    std::vector<Conjunto> elegidos;
+
+    for(auto conjunto : conjuntos()) {
+        if(nombre == "todos" || nombre == nombre_familia(conjunto.familia) || nombre == conjunto.nombre) {
+            conjunto.prehash = prehash && conjunto.familia == Familia::SLH_DSA;
+            elegidos.push_back(conjunto);
+        }
+    }
+
+    return elegidos;
+}
+
+Conjunto buscar_conjunto(const std::string& nombre, bool prehash) {
+    for(auto conjunto : conjuntos()) {
+        if(conjunto.nombre == nombre) {
+            conjunto.prehash = prehash && conjunto.familia == Familia::SLH_DSA;
+            return conjunto;
+        }
+    }
+    throw std::invalid_argument("Set de parámetros desconocido: " + nombre);
+}
+
+std::unique_ptr<Esquema> crear_esquema(const Conjunto& conjunto) {
+    switch(conjunto.familia) {
+        case Familia::ML_DSA: return std::make_unique<EsquemaAdaptado<Botan::DilithiumMode>>(conjunto);
+        case Familia::SLH_DSA: return std::make_unique<EsquemaAdaptado<Botan::Sphincs_Parameters>>(conjunto);
+        case Familia::XMSS: return std::make_unique<EsquemaAdaptado<Botan::XMSS_Parameters>>(conjunto);
+    }
+    throw std::invalid_argument("Familia de esquema desconocida");
+}
+
+void Operacion::resumir(double umbral_outliers) {
+    std::vector<double> tiempos;
+    for(const auto& m : muestras) {
+        tiempos.push_back(m.segundos);
+    }
+
+    auto conservar = filtrar_outliers_mad(tiempos, umbral_outliers);
+
+    std::vector<double> t;
+    std::vector<double> c;
+    for(size_t i = 0; i < muestras.size(); ++i) {
+        if(conservar[i]) {
+            t.push_back(muestras[i].segundos);
+            c.push_back(static_cast<double>(muestras[i].ciclos));
+        }
+    }
+
+    descartadas = muestras.size() - t.size();
+
+    // El uso del RNG se promedia sobre todas las muestras, también las atípicas
+    rng = LecturaRNG{};
+    for(const auto& m : muestras) {
+        rng.llamadas += m.rng.llamadas / muestras.size();
+        rng.bytes += m.rng.bytes / muestras.size();
+        rng.segundos += m.rng.segundos / muestras.size();
+    }
+    segundos = calcular_estadisticas(t);
+    ciclos = calcular_estadisticas(c);
+
+    if(!muestras.empty() && muestras[0].con_eventos) {
+        for(size_t evento = 0; evento < NUM_EVENTOS_HW; ++evento) {
+            std::vector<double> valores;
+            for(size_t i = 0; i < muestras.size(); ++i) {
+                if(conservar[i]) {
+                    valores.push_back(static_cast<double>(muestras[i].eventos[evento]));
+                }
+            }
+            eventos[evento] = calcular_estadisticas(valores);
+        }
+    }
+
+    // Para dimensionar la memoria interesa el peor caso de cada campo, no la mediana
+    if(!muestras.empty() && muestras[0].con_memoria) {
+        memoria = LecturaMemoria{};
+        for(size_t i = 0; i < muestras.size(); ++i) {
+            if(conservar[i]) {
+                const LecturaMemoria& m = muestras[i].memoria;
+                memoria.reservas = std::max(memoria.reservas, m.reservas);
+                memoria.bytes_reservados = std::max(memoria.bytes_reservados, m.bytes_reservados);
+                memoria.pico_monton = std::max(memoria.pico_monton, m.pico_monton);
+                memoria.pila = std::max(memoria.pila, m.pila);
+                memoria.pico_rss = std::max(memoria.pico_rss, m.pico_rss);
+            }
+        }
+    }
+}
+
+const Botan::secure_vector<uint8_t>& mensaje_fijo() {
+    static const Botan::secure_vector<uint8_t> msg{0x01, 0x02, 0x03, 0x04};
+    return msg;
+}
+
+Resultado evaluar(const Esquema& esquema, const Opciones& opciones) {
+    auto rng_medido = crear_rng_medido(opciones.fuente_rng, opciones.semilla_rng);
+    Botan::RandomNumberGenerator& rng = *rng_medido;
+
+    Resultado resultado;
+    resultado.conjunto = esquema.conjunto();
+    resultado.rng = rng.name() + (opciones.fuente_rng == FuenteRNG::AUTO ? "" : " (semilla " + std::to_string(opciones.semilla_rng) + ")");
+    resultado.firma_determinista = opciones.firma_determinista;
+    resultado.entorno = leer_entorno();
+
+    // ---------------------- GENERACIÓN DE CLAVES ----------------------
+    std::unique_ptr<Botan::Private_Key> priv_key;
+    std::unique_ptr<Botan::Public_Key> pub_key;
+    std::unique_ptr<Botan::PK_Signer> signer;
+
+    auto crear_firmador = [&] {
+        // Se crea el firmador con la clave privada
+        signer = std::make_unique<Botan::PK_Signer>(*priv_key, rng, esquema.padding_firma(opciones.firma_determinista));
+    };
+
+    /*
+    Con la caché de claves se intenta primero cargar la clave guardada. La carga se mide
+    como una fase propia y el keygen que se informa es el que se midió al generarla.
+    */
+    std::string ruta_cache;
+    if(!opciones.cache_claves.empty()) {
+        ruta_cache = ruta_clave_cacheada(opciones.cache_claves, esquema.conjunto(), opciones.semilla_claves);
+    }
+
+    if(!ruta_cache.empty() && !opciones.regenerar_claves) {
+        std::optional<ClaveCacheada> cacheada;
+        Operacion carga = muestrear(opciones, [&] {
+            cacheada = cargar_clave_cacheada(esquema, ruta_cache, opciones.semilla_claves);
+        });
+
+        if(cacheada) {
+            resultado.clave_en_cache = true;
+            resultado.carga_clave = std::move(carga);
+            resultado.keygen.segundos.mediana = cacheada->segundos_keygen;
+            resultado.keygen.ciclos.mediana = static_cast<double>(cacheada->ciclos_keygen);
+
+            priv_key = std::move(cacheada->clave);
+            pub_key = priv_key->public_key();
+            resultado.preparacion_firmador = muestrear(opciones, crear_firmador);
+        }
+    }
+
+    if(!priv_key) {
+        // Las claves de la caché salen de un RNG determinista, así que se pueden reproducir
+        auto fases_keygen = muestrear_fases(opciones,
+            [&] {
+                // Se crea la clave privada y se deriva la pública
+                if(ruta_cache.empty()) {
+                    priv_key = esquema.generar_clave(rng);
+                } else {
+                    priv_key = esquema.generar_clave(*rng_semilla(opciones.semilla_claves));
+                }
+                pub_key = priv_key->public_key();
+            },
+            crear_firmador);
+
+        resultado.keygen = fases_keygen[0];
+        resultado.preparacion_firmador = fases_keygen[1];
+
+        // Las claves se descartan: priv_key sigue siendo la del firmador
+        resultado.keygen.energia = medir_energia([&] { esquema.generar_clave(rng); }, opciones.energia_segundos, SIZE_MAX);
+    }
+
+    resultado.tam_clave_publica = pub_key->public_key_bits().size();
+    resultado.tam_clave_privada = esquema.tam_clave_privada(*priv_key);
+
+    // ---------------- GENERACIÓN DE FIRMA -----------------------
+    const Botan::secure_vector<uint8_t>& msg = mensaje_fijo();
+    std::vector<uint8_t> signature;
+
+    resultado.firma = muestrear(opciones, [&] {
+        signer->update(msg.data(), msg.size());
+        signature = signer->signature(rng);
+    });
+
+    resultado.tam_firma = signature.size();
+
+    /*
+    Con claves con estado cada repetición gasta una hoja: se limitan a 64, que en XMSS
+    ya superan con creces la resolución de RAPL, y a la mitad de las que quedan.
+    */
+    size_t max_firmas = SIZE_MAX;
+    if(auto restantes = priv_key->remaining_operations()) {
+        max_firmas = std::min<size_t>(64, static_cast<size_t>(*restantes / 2));
+    }
+    resultado.firma.energia = medir_energia([&] {
+        signer->update(msg.data(), msg.size());
+        signature = signer->signature(rng);
+    }, opciones.energia_segundos, max_firmas);
+
+    // ---------------- VERIFICACIÓN DE FIRMA -----------------------
+    // Se da por verificada sólo si todas las verificaciones son correctas
+    resultado.verificada = true;
+    std::unique_ptr<Botan::PK_Verifier> verifier;
+
+    auto verificar = [&] {
+        verifier->update(msg.data(), msg.size());
+        if(!verifier->check_signature(signature.data(), signature.size())) {
+            resultado.verificada = false;
+        }
+    };
+
+    auto fases_verificacion = muestrear_fases(opciones,
+        [&] {
+            // Se crea un verificador nuevo en cada repetición
+            verifier = std::make_unique<Botan::PK_Verifier>(*pub_key, esquema.padding_verificacion());
+        },
+        verificar);
+
+    resultado.preparacion_verificador = fases_verificacion[0];
+    resultado.verificacion = fases_verificacion[1];
+    resultado.verificacion.energia = medir_energia(verificar, opciones.energia_segundos, SIZE_MAX);
+
+    // Verificación en régimen permanente: siempre con el mismo verificador
+    if(opciones.reutilizar_verificador) {
+        resultado.verificacion_reutilizada = muestrear(opciones, verificar);
+    }
+
+    // Se guarda la clave con su estado actual (en XMSS, el índice ya avanzado por las firmas)
+    if(!ruta_cache.empty()) {
+        guardar_clave_cacheada(ruta_cache, esquema.conjunto(), opciones.semilla_claves, *priv_key,
+                               resultado.keygen.segundos.mediana, static_cast<uint64_t>(resultado.keygen.ciclos.mediana));
+    }
+
+    resultado.entorno_final = leer_entorno();
+    resultado.avisos_entorno = avisos_entorno(resultado.entorno, opciones.carga_maxima, &resultado.entorno_final);
+
+    return resultado;
+}
+
+// Imprime la mediana de ciclos convertida a ciclos de núcleo, si se conoce la relación
+static void imprimir_ciclos_nucleo(const Operacion& operacion, std::ostream& salida) {
+    if(contador().ratio_nucleo > 0) {
+        salida << "Ciclos de núcleo (estimados): "
+               << static_cast<uint64_t>(a_ciclos_nucleo(operacion.ciclos.mediana)) << " ciclos\n";
+    }
+}
+
+/*
+Imprime la mediana de cada contador hardware, un valor por línea con el prefijo "HW "
+para que benchmark.py pueda llevarlos al CSV. Los eventos no disponibles salen como N/A.
+*/
+static void imprimir_contadores_hw(const Operacion& operacion, std::ostream& salida) {
+    const ContadoresHW* hw = contadores_hw();
+    if(!hw || operacion.muestras.empty() || !operacion.muestras[0].con_eventos) {
+        return;
+    }
+
+    auto valor = [&](size_t evento) -> std::string {
+        if(!hw->disponible(evento)) {
+            return "N/A";
+        }
+        return std::to_string(static_cast<uint64_t>(operacion.eventos[evento].mediana));
+    };
+
+    salida << "HW instrucciones: " << valor(HW_INSTRUCCIONES) << "\n";
+
+    salida << "HW IPC: ";
+    if(hw->disponible(HW_INSTRUCCIONES) && hw->disponible(HW_CICLOS) && operacion.eventos[HW_CICLOS].mediana > 0) {
+        salida << operacion.eventos[HW_INSTRUCCIONES].mediana / operacion.eventos[HW_CICLOS].mediana << "\n";
+    } else {
+        salida << "N/A\n";
+    }
+
+    for(size_t evento : {HW_FALLOS_L1D, HW_FALLOS_LLC, HW_FALLOS_SALTO, HW_FALLOS_DTLB}) {
+        salida << "HW " << nombre_evento(evento) << ": " << valor(evento) << "\n";
+    }
+}
+
+/*
+Imprime la memoria de la fase, un valor en bytes por línea con el prefijo "MEM " para
+que benchmark.py pueda llevarlos al CSV.
+*/
+static void imprimir_memoria(const Operacion& operacion, std::ostream& salida) {
+    if(operacion.muestras.empty() || !operacion.muestras[0].con_memoria) {
+        return;
+    }
+
+    const LecturaMemoria& m = operacion.memoria;
+    salida << "MEM reservas: " << m.reservas << "\n"
+           << "MEM bytes reservados: " << m.bytes_reservados << " (" << formatear_bytes(m.bytes_reservados) << ")\n"
+           << "MEM pico del montón: " << m.pico_monton << " (" << formatear_bytes(m.pico_monton) << ")\n"
+           << "MEM pila: " << m.pila << " (" << formatear_bytes(m.pila) << ")\n"
+           << "MEM pico RSS: " << m.pico_rss << " (" << formatear_bytes(m.pico_rss) << ")\n";
+}
+
+// Imprime el uso del RNG de la fase, si lo ha usado
+static void imprimir_rng(const Operacion& operacion, std::ostream& salida) {
+    const LecturaRNG& r = operacion.rng;
+    if(r.llamadas == 0) {
+        return;
+    }
+
+    double total = operacion.segundos.media;
+    salida << "RNG llamadas: " << r.llamadas << " | bytes: " << r.bytes << " | tiempo: " << r.segundos << "s";
+    if(total > 0) {
+        salida << " (" << std::fixed << std::setprecision(1) << 100.0 * r.segundos / total << " % de la media)"
+               << std::defaultfloat << std::setprecision(6);
+    }
+    salida << "\n";
+}
+
+/*
+Imprime la energía de la operación con el prefijo "EN " para que benchmark.py la lleve
+al CSV. Si no se ha medido no imprime nada.
+*/
+static void imprimir_energia(const Operacion& operacion, std::ostream& salida) {
+    const EnergiaOperacion& e = operacion.energia;
+    if(e.repeticiones == 0) {
+        return;
+    }
+
+    salida << "EN julios por operación (paquete): " << e.julios_paquete << "\n"
+           << "EN julios por operación (núcleo): ";
+    if(contadores_energia()->disponible_nucleo()) {
+        salida << e.julios_nucleo << "\n";
+    } else {
+        salida << "N/A\n";
+    }
+    salida << "EN operaciones por julio (paquete): " << (e.julios_paquete > 0 ? 1 / e.julios_paquete : 0) << "\n"
+           << "Energía medida en " << e.repeticiones << " repeticiones (" << e.segundos << "s)\n";
+}
+
+// Imprime las estadísticas de una operación cuando hay más de una muestra
+static void imprimir_estadisticas(const Operacion& operacion, std::ostream& salida) {
+    if(operacion.muestras.size() < 2) {
+        return;
+    }
+
+    auto fila = [&](const char* nombre, const Estadisticas& e) {
+        salida << "  " << std::left << std::setw(8) << nombre << std::right
+               << " mín " << e.min << " | mediana " << e.mediana << " | media " << e.media
+               << " | desv " << e.desviacion << " | p90 " << e.p90 << " | p99 " << e.p99
+               << " | máx " << e.max << "\n";
+    };
+
+    salida << "Estadísticas: " << operacion.segundos.muestras << " muestras, "
+           << operacion.descartadas << " atípicas descartadas\n";
+    fila("Tiempo", operacion.segundos);
+    fila("Ciclos", operacion.ciclos);
+}
+
+/*
+Imprime la construcción del firmador o del verificador. Se usan etiquetas distintas
+a las de las operaciones para que benchmark.py no las confunda con ellas.
+*/
+static void imprimir_preparacion(const char* titulo, const Operacion& operacion, std::ostream& salida) {
+    salida << titulo << "\n"
+           << "Tiempo de preparación: " << operacion.segundos.mediana << "s\n"
+           << "Ciclos de preparación: " << static_cast<uint64_t>(operacion.ciclos.mediana) << " ciclos\n";
+    imprimir_ciclos_nucleo(operacion, salida);
+    imprimir_contadores_hw(operacion, salida);
+    imprimir_memoria(operacion, salida);
+    imprimir_rng(operacion, salida);
+    imprimir_estadisticas(operacion, salida);
+    salida << "\n\n";
+}
+
+void imprimir(const Resultado& resultado, std::ostream& salida) {
+    const Conjunto& conjunto = resultado.conjunto;
+
+    salida << "EVALUACIÓN DE RENDIMIENTO DEL ALGORITMO " << nombre_familia(conjunto.familia) << "\n"
+           << "SET DE PARÁMETROS UTILIZADOS: " << conjunto.nombre << "\n";
+    if(conjunto.familia == Familia::SLH_DSA) {
+        salida << "Pre-Hash: " << (conjunto.prehash ? "Sí" : "No") << "\n";
+    }
+    salida << "RNG: " << resultado.rng;
+    if(conjunto.familia != Familia::XMSS) {
+        salida << " | Firma: " << (resultado.firma_determinista ? "determinista" : "hedged");
+    }
+    salida << "\n";
+    salida << "\n";
+
+    // El tiempo y los ciclos de cada operación son la mediana de las muestras
+    salida << "RESULTADOS DE GENERACIÓN DE CLAVES\n"
+           << "Tiempo de ejecución: " << resultado.keygen.segundos.mediana << "s\n"
+           << "Ciclos de CPU: " << static_cast<uint64_t>(resultado.keygen.ciclos.mediana) << " ciclos\n";
+    imprimir_ciclos_nucleo(resultado.keygen, salida);
+    imprimir_contadores_hw(resultado.keygen, salida);
+    imprimir_memoria(resultado.keygen, salida);
+    imprimir_rng(resultado.keygen, salida);
+    imprimir_energia(resultado.keygen, salida);
+    imprimir_estadisticas(resultado.keygen, salida);
+    if(resultado.clave_en_cache) {
+        salida << "Clave cargada de la caché (keygen medido al generarla)\n";
+    }
+    salida << "Tamaño de la clave pública: " << resultado.tam_clave_publica << " bytes\n"
+           << "Tamaño de la clave privada: " << resultado.tam_clave_privada << " bytes\n\n";
+
+    if(resultado.clave_en_cache) {
+        salida << "RESULTADOS DE CARGA DE CLAVE DESDE CACHÉ\n"
+               << "Tiempo de carga: " << resultado.carga_clave.segundos.mediana << "s\n"
+               << "Ciclos de carga: " << static_cast<uint64_t>(resultado.carga_clave.ciclos.mediana) << " ciclos\n";
+        imprimir_ciclos_nucleo(resultado.carga_clave, salida);
+        imprimir_contadores_hw(resultado.carga_clave, salida);
+        imprimir_memoria(resultado.carga_clave, salida);
+        imprimir_rng(resultado.carga_clave, salida);
+        imprimir_estadisticas(resultado.carga_clave, salida);
+        salida << "\n\n";
+    }
+
+    imprimir_preparacion("RESULTADOS DE PREPARACIÓN DEL FIRMADOR", resultado.preparacion_firmador, salida);
+
+    salida << "RESULTADOS DE GENERACIÓN DE FIRMA\n"
+           << "Tiempo de ejecución: " << resultado.firma.segundos.mediana << "s\n"
+           << "Ciclos de CPU: " << static_cast<uint64_t>(resultado.firma.ciclos.mediana) << " ciclos\n";
+    imprimir_ciclos_nucleo(resultado.firma, salida);
+    imprimir_contadores_hw(resultado.firma, salida);
+    imprimir_memoria(resultado.firma, salida);
+    imprimir_rng(resultado.firma, salida);
+    imprimir_energia(resultado.firma, salida);
+    imprimir_estadisticas(resultado.firma, salida);
+    salida << "Tamaño de la firma: " << resultado.tam_firma << " bytes\n\n\n";
+
+    imprimir_preparacion("RESULTADOS DE PREPARACIÓN DEL VERIFICADOR", resultado.preparacion_verificador, salida);
+
+    salida << (resultado.verificada ? "Firma Verificada." : "Firma Errónea.") << "\n";
+    salida << "RESULTADOS DE VERIFICACIÓN DE FIRMA\n"
+           << "Tiempo de ejecución: " << resultado.verificacion.segundos.mediana << "s\n"
+           << "Ciclos de CPU: " << static_cast<uint64_t>(resultado.verificacion.ciclos.mediana) << " ciclos\n";
+    imprimir_ciclos_nucleo(resultado.verificacion, salida);
+    imprimir_contadores_hw(resultado.verificacion, salida);
+    imprimir_memoria(resultado.verificacion, salida);
+    imprimir_rng(resultado.verificacion, salida);
+    imprimir_energia(resultado.verificacion, salida);
+    imprimir_estadisticas(resultado.verificacion, salida);
+
+    if(!resultado.verificacion_reutilizada.muestras.empty()) {
+        salida << "\nRESULTADOS DE VERIFICACIÓN CON VERIFICADOR REUTILIZADO\n"
+               << "Tiempo por verificación: " << resultado.verificacion_reutilizada.segundos.mediana << "s\n"
+               << "Ciclos por verificación: " << static_cast<uint64_t>(resultado.verificacion_reutilizada.ciclos.mediana) << " ciclos\n";
+        imprimir_ciclos_nucleo(resultado.verificacion_reutilizada, salida);
+        imprimir_contadores_hw(resultado.verificacion_reutilizada, salida);
+        imprimir_memoria(resultado.verificacion_reutilizada, salida);
+        imprimir_rng(resultado.verificacion_reutilizada, salida);
+        imprimir_estadisticas(resultado.verificacion_reutilizada, salida);
+    }
+
+    // Huella del entorno en cada resultado, para poder comparar máquinas
+    salida << "\n";
+    imprimir_entorno(resultado.entorno, resultado.entorno_final.frecuencia_mhz, salida);
+    for(const auto& aviso : resultado.avisos_entorno) {
+        salida << "[!] Entorno ruidoso: " << aviso << "\n";
+    }
+
+    // El pico de getrusage no se puede reiniciar: es el de todo el proceso hasta ahora
+    if(contabilidad_memoria_activa()) {
+        MemoriaProceso proceso = memoria_proceso();
+        salida << "\nMEMORIA DEL PROCESO\n"
+               << "MEM pico RSS del proceso: " << proceso.max_rss << " (" << formatear_bytes(proceso.max_rss) << ")\n"
+               << "Memoria virtual máxima (VmPeak): " << formatear_bytes(proceso.vm_peak)
+               << " | RSS actual (VmRSS): " << formatear_bytes(proceso.vm_rss) << "\n";
+    }
+}
+
+std::string formatear_bytes(uint64_t bytes) {
+    static const char* unidades[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+
+    double valor = static_cast<double>(bytes);
+    size_t unidad = 0;
+    while(valor >= 1024 && unidad + 1 < std::size(unidades)) {
+        valor /= 1024;
+        ++unidad;
+    }
+
+    std::ostringstream texto;
+    texto << std::setprecision(valor == static_cast<uint64_t>(valor) ? 0 : 1) << std::fixed << valor << " " << unidades[unidad];
+    return texto.str();
+}
+
+std::string columna(const std::string& texto, size_t ancho) {
+    // Los bytes de continuación de UTF-8 son de la forma 10xxxxxx
+    size_t caracteres = std::count_if(texto.begin(), texto.end(), [](char c) { return (c & 0xC0) != 0x80; });
+    return std::string(ancho > caracteres ? ancho - caracteres : 0, ' ') + texto;
+}
+
+// ---------------------- LÍNEA DE COMANDOS ----------------------
+
+Argumentos::Argumentos(int argc, char* argv[], int desde) {
+    for(int i = desde; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if(arg.rfind("--", 0) != 0) {
+            m_posicionales.push_back(arg);
+            continue;
+        }
+
+        auto igual = arg.find('=');
+        if(igual == std::string::npos) {
+            m_opciones.emplace_back(arg.substr(2), "");
+        } else {
+            m_opciones.emplace_back(arg.substr(2, igual - 2), arg.substr(igual + 1));
+        }
+    }
+}
+
+bool Argumentos::activa(const std::string& nombre) const {
+    return std::any_of(m_opciones.begin(), m_opciones.end(),
+        [&](const auto& opcion) { return opcion.first == nombre; });
+}
+
+std::string Argumentos::texto(const std::string& nombre, const std::string& defecto) const {
+    // Si una opción aparece varias veces, prevalece la última
+    for(auto it = m_opciones.rbegin(); it != m_opciones.rend(); ++it) {
+        if(it->first == nombre) {
+            return it->second;
+        }
+    }
+    return defecto;
+}
+
+long Argumentos::entero(const std::string& nombre, long defecto) const {
+    std::string valor = texto(nombre, "");
+    if(valor.empty()) {
+        return defecto;
+    }
+
+    try {
+        size_t leidos = 0;
+        long numero = std::stol(valor, &leidos);
+        if(leidos == valor.size()) {
+            return numero;
+        }
+    } catch(const std::exception&) {}
+
+    throw std::invalid_argument("Valor inválido para --" + nombre + ": " + valor);
+}
+
+double Argumentos::real(const std::string& nombre, double defecto) const {
+    std::string valor = texto(nombre, "");
+    if(valor.empty()) {
+        return defecto;
+    }
+
+    try {
+        size_t leidos = 0;
+        double numero = std::stod(valor, &leidos);
+        if(leidos == valor.size()) {
+            return numero;
+        }
+    } catch(const std::exception&) {}
+
+    throw std::invalid_argument("Valor inválido para --" + nombre + ": " + valor);
+}
+
+std::vector<std::string> Argumentos::textos(const std::string& nombre, const std::vector<std::string>& defecto) const {
+    std::string valor = texto(nombre, "");
+    if(valor.empty()) {
+        return defecto;
+    }
+
+    std::vector<std::string> elementos;
+    size_t inicio = 0;
+    while(true) {
+        size_t coma = valor.find(',', inicio);
+        elementos.push_back(valor.substr(inicio, coma == std::string::npos ? std::string::npos : coma - inicio));
+        if(coma == std::string::npos) {
+            break;
+        }
+        inicio = coma + 1;
+    }
+
+    return elementos;
+}
+
+std::vector<long> Argumentos::enteros(const std::string& nombre, const std::vector<long>& defecto) const {
+    if(texto(nombre, "").empty()) {
+        return defecto;
+    }
+
+    std::vector<long> numeros;
+    for(const auto& elemento : textos(nombre, {})) {
+        try {
+            size_t leidos = 0;
+            numeros.push_back(std::stol(elemento, &leidos));
+            if(leidos == elemento.size()) {
+                continue;
+            }
+        } catch(const std::exception&) {}
+
+        throw std::invalid_argument("Valor inválido para --" + nombre + ": " + texto(nombre, ""));
+    }
+
+    return numeros;
+}
+
+Opciones leer_opciones(const Argumentos& args) {
+    Opciones opciones;
+
+    long iteraciones = args.entero("iteraciones", 1);
+    long calentamiento = args.entero("calentamiento", 0);
+    if(iteraciones < 1 || calentamiento < 0) {
+        throw std::invalid_argument("--iteraciones debe ser >= 1 y --calentamiento >= 0");
+    }
+
+    opciones.iteraciones = static_cast<size_t>(iteraciones);
+    opciones.calentamiento = static_cast<size_t>(calentamiento);
+
+    // --outliers sin valor utiliza el umbral habitual de 3.5 MAD
+    if(args.activa("outliers")) {
+        opciones.umbral_outliers = args.real("outliers", 3.5);
+    }
+
+    opciones.reutilizar_verificador = args.activa("reutilizar");
+    opciones.contadores_hw = args.activa("contadores");
+    opciones.memoria = args.activa("memoria");
+
+    if(args.activa("cache-claves")) {
+        // --cache-claves sin valor utiliza el directorio por defecto
+        std::string directorio = args.texto("cache-claves", "");
+        opciones.cache_claves = directorio.empty() ? ".pqbench-claves" : directorio;
+        opciones.regenerar_claves = args.activa("regenerar");
+
+        long semilla = args.entero("semilla", 0);
+        if(semilla < 0) {
+            throw std::invalid_argument("--semilla debe ser >= 0");
+        }
+        opciones.semilla_claves = static_cast<uint64_t>(semilla);
+    }
+
+    opciones.fuente_rng = leer_fuente_rng(args.texto("rng", "auto"));
+    long semilla_rng = args.entero("semilla-rng", 0);
+    if(semilla_rng < 0) {
+        throw std::invalid_argument("--semilla-rng debe ser >= 0");
+    }
+    opciones.semilla_rng = static_cast<uint64_t>(semilla_rng);
+    comprobar_fuente_rng(opciones.fuente_rng, opciones.semilla_rng);
+    opciones.firma_determinista = args.activa("determinista");
+
+    // El núcleo y la prioridad se fijan ya para que todo lo que se mida después los tenga
+    if(args.activa("nucleo")) {
+        long nucleo = args.entero("nucleo", -1);
+        if(nucleo < 0) {
+            throw std::invalid_argument("--nucleo debe ser >= 0");
+        }
+        opciones.nucleo = static_cast<int>(nucleo);
+        fijar_nucleo(opciones.nucleo);
+    }
+    if(args.activa("prioridad")) {
+        opciones.prioridad = args.texto("prioridad", "nice");
+        subir_prioridad(opciones.prioridad);
+    }
+
+    // --energia sin valor repite cada operación durante al menos 0.2 s
+    if(args.activa("energia")) {
+        opciones.energia = true;
+        opciones.energia_segundos = args.real("energia", 0.2);
+        if(opciones.energia_segundos <= 0) {
+            throw std::invalid_argument("--energia debe ser > 0");
+        }
+    }
+
+    opciones.json = args.activa("json");
+    opciones.carga_maxima = args.real("carga-maxima", 1.0);
+    opciones.estricto = args.activa("estricto");
+
+    // Como el pool de hilos, Botan consulta la CPU una sola vez por proceso
+    if(args.activa("desactivar-cpu")) {
+        opciones.desactivar_cpu = args.textos("desactivar-cpu", {});
+        desactivar_caracteristicas_cpu(opciones.desactivar_cpu);
+    }
+
+    /*
+    Botan decide el tamaño de su pool de hilos (que usa, p. ej., el keygen de XMSS) la
+    primera vez que lo necesita, así que hay que fijarlo antes de medir nada.
+    */
+    if(args.activa("hilos-botan")) {
+        long hilos = args.entero("hilos-botan", 0);
+        if(hilos < 1) {
+            throw std::invalid_argument("--hilos-botan debe ser >= 1");
+        }
+        opciones.hilos_botan = static_cast<size_t>(hilos);
+        fijar_hilos_botan(opciones.hilos_botan);
+    }
+
+    return opciones;
+}
+
+} // namespace pqbench
@@ -0,0 +1,272 @@
+#include "keygen_hilos.h"
+#include "binario.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace pqbench {
+
+void fijar_hilos_botan(size_t hilos) {
+    std::string valor = hilos <= 1 ? "none" : std::to_string(hilos);
+    ::setenv("BOTAN_THREAD_POOL_SIZE", valor.c_str(), 1);
+}
+
+static double segundos_cpu() {
+    struct rusage uso {};
+    ::getrusage(RUSAGE_SELF, &uso);
+    auto segundos = [](const timeval& t) { return t.tv_sec + t.tv_usec / 1e6; };
+    return segundos(uso.ru_utime) + segundos(uso.ru_stime);
+}
+
+// Hilos del proceso según /proc/self/status, o -1 si no se puede leer
+static long hilos_del_proceso() {
+    std::ifstream status("/proc/self/status");
+    std::string linea;
+    while(std::getline(status, linea)) {
+        if(linea.rfind("Threads:", 0) == 0) {
+            return std::strtol(linea.c_str() + 8, nullptr, 10);
+        }
+    }
+    return -1;
+}
+
+// Muestra que el hijo envía al padre por la tubería
+struct MuestraKeygen {
+    double segundos;
+    double segundos_cpu;
+    uint64_t ciclos;
+};
+
+// Código del proceso hijo: nunca vuelve
+[[noreturn]] static void hijo_keygen(const Esquema& esquema, size_t hilos, size_t iteraciones, int fd) {
+    int codigo = 0;
+    try {
+        fijar_hilos_botan(hilos);
+        Botan::AutoSeeded_RNG rng;
+
+        for(size_t i = 0; i < iteraciones; ++i) {
+            std::unique_ptr<Botan::Private_Key> clave;
+            double cpu_antes = segundos_cpu();
+            Medicion medicion = medir([&] { clave = esquema.generar_clave(rng); });
+            MuestraKeygen muestra{medicion.segundos, segundos_cpu() - cpu_antes, medicion.ciclos};
+
+            if(!escribir_todo(fd, &muestra, sizeof(muestra))) {
+                codigo = 1;
+                break;
+            }
+        }
+
+        long hilos_proceso = hilos_del_proceso();
+        if(!escribir_todo(fd, &hilos_proceso, sizeof(hilos_proceso))) {
+            codigo = 1;
+        }
+    } catch(const std::exception& e) {
+        std::cerr << "Excepción en keygen con " << hilos << " hilos: " << e.what() << "\n";
+        codigo = 1;
+    }
+
+    ::close(fd);
+    // _exit para no ejecutar en el hijo los destructores estáticos del padre
+    ::_exit(codigo);
+}
+
+EscaladoKeygen medir_keygen_con_hilos(const Esquema& esquema, size_t hilos, size_t iteraciones) {
+    int tuberia[2];
+    if(::pipe(tuberia) != 0) {
+        throw std::runtime_error(std::string("No se pudo crear la tubería: ") + std::strerror(errno));
+    }
+
+    std::cout.flush();
+    std::cerr.flush();
+
+    pid_t pid = ::fork();
+    if(pid < 0) {
+        ::close(tuberia[0]);
+        ::close(tuberia[1]);
+        throw std::runtime_error(std::string("No se pudo crear el proceso hijo: ") + std::strerror(errno));
+    }
+    if(pid == 0) {
+        ::close(tuberia[0]);
+        hijo_keygen(esquema, hilos, iteraciones, tuberia[1]);
+    }
+    ::close(tuberia[1]);
+
+    EscaladoKeygen resultado;
+    resultado.hilos = hilos;
+
+    std::vector<double> segundos, cpu, ciclos;
+    bool completo = true;
+    for(size_t i = 0; i < iteraciones && completo; ++i) {
+        MuestraKeygen muestra;
+        completo = leer_todo(tuberia[0], &muestra, sizeof(muestra));
+        if(completo) {
+            segundos.push_back(muestra.segundos);
+            cpu.push_back(muestra.segundos_cpu);
+            ciclos.push_back(static_cast<double>(muestra.ciclos));
+        }
+    }
+    completo = completo && leer_todo(tuberia[0], &resultado.hilos_proceso, sizeof(resultado.hilos_proceso));
+    ::close(tuberia[0]);
+
+    int estado = 0;
+    while(::waitpid(pid, &estado, 0) < 0 && errno == EINTR) {}
+
+    resultado.correcta = completo && WIFEXITED(estado) && WEXITSTATUS(estado) == 0;
+    resultado.segundos = calcular_estadisticas(std::move(segundos));
+    resultado.segundos_cpu = calcular_estadisticas(std::move(cpu));
+    resultado.ciclos = calcular_estadisticas(std::move(ciclos));
+    return resultado;
+}
+
+/*
+Referencia para la aceleración: la primera medición que ha terminado bien (normalmente
+la de 1 hilo). Si la primera ha fallado su mediana es 0 y no sirve. nullptr si no hay ninguna.
+*/
+static const EscaladoKeygen* medicion_base(const std::vector<EscaladoKeygen>& resultados) {
+    for(const auto& r : resultados) {
+        if(r.correcta && r.segundos.mediana > 0) {
+            return &r;
+        }
+    }
+    return nullptr;
+}
+
+static void imprimir_escalado(const std::vector<EscaladoKeygen>& resultados, std::ostream& salida) {
+    const EscaladoKeygen* base = medicion_base(resultados);
+
+    salida << std::setw(7) << "Hilos" << std::setw(14) << "Real p50 (s)" << std::setw(13) << "CPU p50 (s)"
+           << std::setw(10) << "CPU/real" << std::setw(16) << "Ciclos p50" << std::setw(13) << "Aceleración"
+           << std::setw(12) << "Eficiencia" << std::setw(15) << "Hilos proceso" << "\n";
+
+    for(const auto& r : resultados) {
+        if(!r.correcta) {
+            salida << std::setw(7) << r.hilos << "  [!] La medición ha fallado\n";
+            continue;
+        }
+
+        double real = r.segundos.mediana;
+        salida << std::setw(7) << r.hilos << std::setw(14) << real << std::setw(13) << r.segundos_cpu.mediana
+               << std::fixed << std::setprecision(2)
+               << std::setw(10) << (real > 0 ? r.segundos_cpu.mediana / real : 0)
+               << std::setprecision(0) << std::setw(16) << r.ciclos.mediana << std::setprecision(2);
+
+        if(base != nullptr && real > 0) {
+            double aceleracion = base->segundos.mediana / real;
+            salida << std::setw(13) << aceleracion
+                   << std::setw(11) << 100 * aceleracion * base->hilos / r.hilos << "%";
+        } else {
+            salida << std::setw(13) << "N/A" << std::setw(12) << "N/A";
+        }
+        salida << std::defaultfloat << std::setprecision(6) << std::setw(15) << r.hilos_proceso << "\n";
+    }
+
+    if(base != nullptr && base != &resultados.front()) {
+        salida << "La aceleración se calcula respecto a " << base->hilos << " hilos, la primera medición correcta.\n";
+    }
+}
+
+/*
+Conclusión del barrido: si Botan ha paralelizado y cuántos hilos conviene dar a la
+generación de claves (el menor número que consigue el 90 % de la mejor aceleración).
+*/
+static void imprimir_conclusion(const std::vector<EscaladoKeygen>& resultados, std::ostream& salida) {
+    const EscaladoKeygen* referencia = medicion_base(resultados);
+    if(referencia == nullptr) {
+        salida << "Ninguna medición ha terminado bien: no hay referencia para calcular la aceleración.\n";
+        return;
+    }
+
+    double base = referencia->segundos.mediana;
+    double mejor_ratio = 0;
+    double mejor_aceleracion = 0;
+
+    for(const auto& r : resultados) {
+        if(r.correcta && r.hilos > 1 && r.segundos.mediana > 0) {
+            mejor_ratio = std::max(mejor_ratio, r.segundos_cpu.mediana / r.segundos.mediana);
+            mejor_aceleracion = std::max(mejor_aceleracion, base / r.segundos.mediana);
+        }
+    }
+
+    // Un margen del 20 % para no confundir el ruido de medida con trabajo en paralelo
+    if(mejor_ratio < 1.2) {
+        salida << "Botan NO ha paralelizado la generación de claves: el tiempo de CPU no supera al real con más de un hilo.\n";
+        return;
+    }
+
+    salida << "Botan ha paralelizado la generación de claves (CPU/real hasta " << std::fixed << std::setprecision(2)
+           << mejor_ratio << ").\n";
+
+    for(const auto& r : resultados) {
+        if(r.correcta && r.segundos.mediana > 0 && base / r.segundos.mediana >= 0.9 * mejor_aceleracion) {
+            salida << "Hilos recomendados para aprovisionar claves: " << r.hilos << " (aceleración " << base / r.segundos.mediana
+                   << " de un máximo de " << mejor_aceleracion << ")\n";
+            break;
+        }
+    }
+    salida << std::defaultfloat << std::setprecision(6);
+}
+
+int ejecutar_keygen_hilos(const Argumentos& args) {
+    if(args.posicionales().size() != 1) {
+        std::cerr << "Uso: ./pqbench keygen-hilos <set XMSS|XMSS> [--hilos=1,2,...,nproc] [--iteraciones=N]\n";
+        return 1;
+    }
+
+    Opciones opciones = leer_opciones(args);
+    long nucleos = static_cast<long>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<long> por_defecto;
+    for(long h = 1; h <= nucleos; ++h) {
+        por_defecto.push_back(h);
+    }
+    std::vector<long> hilos = args.enteros("hilos", por_defecto);
+
+    if(hilos.empty() || std::any_of(hilos.begin(), hilos.end(), [](long h) { return h < 1; })) {
+        std::cerr << "--hilos debe ser una lista de números >= 1\n";
+        return 1;
+    }
+
+    std::vector<Conjunto> conjuntos = seleccionar(args.posicionales()[0], false);
+    if(conjuntos.empty() || std::any_of(conjuntos.begin(), conjuntos.end(),
+                                        [](const Conjunto& c) { return c.familia != Familia::XMSS; })) {
+        std::cerr << "El modo keygen-hilos sólo admite sets de XMSS.\n";
+        return 1;
+    }
+
+#if defined(BOTAN_HAS_THREAD_UTILS)
+    std::cout << "Botan compilado con utilidades de hilos (BOTAN_HAS_THREAD_UTILS): sí\n";
+#else
+    std::cout << "Botan compilado con utilidades de hilos (BOTAN_HAS_THREAD_UTILS): no, la generación será secuencial\n";
+#endif
+    std::cout << "Núcleos disponibles: " << nucleos << "\n\n";
+
+    int fallos = 0;
+    for(const auto& conjunto : conjuntos) {
+        auto esquema = crear_esquema(conjunto);
+
+        std::cout << "ESCALADO DE LA GENERACIÓN DE CLAVES DE " << conjunto.nombre << " | " << opciones.iteraciones
+                  << " muestras por número de hilos\n";
+
+        std::vector<EscaladoKeygen> resultados;
+        for(long h : hilos) {
+            resultados.push_back(medir_keygen_con_hilos(*esquema, static_cast<size_t>(h), opciones.iteraciones));
+            fallos += !resultados.back().correcta;
+        }
+
+        imprimir_escalado(resultados, std::cout);
+        imprimir_conclusion(resultados, std::cout);
+        std::cout << "\n";
+    }
+
+    return fallos == 0 ? 0 : 1;
+}
+
+} // namespace pqbench
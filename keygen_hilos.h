@@ -0,0 +1,50 @@
+#ifndef PQBENCH_KEYGEN_HILOS_H
+#define PQBENCH_KEYGEN_HILOS_H
+
+#include "pqbench.h"
+
+/*
+Escalado de la generación de claves XMSS con el número de hilos.
+
+Si Botan está compilado con las utilidades de hilos (BOTAN_HAS_THREAD_UTILS), XMSS reparte
+el cálculo del árbol entre los hilos del pool global de Botan. El tamaño de ese pool se
+decide una sola vez por proceso, al crearlo, a partir de la variable de entorno
+BOTAN_THREAD_POOL_SIZE ("none" = sin pool, todo en el hilo que llama). Por eso cada
+número de hilos se mide en un proceso hijo distinto, que fija la variable antes de que
+Botan cree el pool.
+
+En cada hijo se mide el tiempo real y el tiempo de CPU (usuario + sistema de todos los
+hilos del proceso) de la generación de claves. Si el tiempo de CPU no supera al real,
+Botan no ha repartido el trabajo entre varios núcleos.
+*/
+
+namespace pqbench {
+
+// Generaciones de claves medidas con un número de hilos
+struct EscaladoKeygen {
+    size_t hilos = 0;
+    Estadisticas segundos;     // Tiempo real
+    Estadisticas segundos_cpu; // Tiempo de CPU de todo el proceso
+    Estadisticas ciclos;
+    long hilos_proceso = 0;    // Hilos del proceso hijo al terminar (incluye los del pool)
+    bool correcta = false;
+};
+
+/*
+Fija el tamaño del pool de hilos de Botan para este proceso. Tiene que llamarse antes de
+cualquier operación que cree el pool; con 1 hilo no se crea pool.
+*/
+void fijar_hilos_botan(size_t hilos);
+
+// Mide `iteraciones` generaciones de claves en un proceso hijo con `hilos` hilos
+EscaladoKeygen medir_keygen_con_hilos(const Esquema& esquema, size_t hilos, size_t iteraciones);
+
+/*
+Punto de entrada del modo desde la línea de comandos:
+  ./pqbench keygen-hilos <set XMSS|XMSS> [--hilos=1,2,...,nproc] [--iteraciones=N]
+*/
+int ejecutar_keygen_hilos(const Argumentos& args);
+
+} // namespace pqbench
+
+#endif
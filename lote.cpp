@@ -0,0 +1,436 @@
+#include "lote.h"
+#include "binario.h"
+
+#include <atomic>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace pqbench {
+
+// ----- FORMATO DEL LOTE -----
+
+static const char MAGIA_LOTE[8] = {'P', 'Q', 'B', 'L', 'O', 'T', 'E', '1'};
+
+uint32_t ArenaLote::indice_conjunto(const Conjunto& conjunto) {
+    for(size_t i = 0; i < m_conjuntos.size(); ++i) {
+        if(m_conjuntos[i].nombre == conjunto.nombre && m_conjuntos[i].prehash == conjunto.prehash) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+
+    m_conjuntos.push_back(conjunto);
+    return static_cast<uint32_t>(m_conjuntos.size() - 1);
+}
+
+void ArenaLote::anadir(const Conjunto& conjunto, std::span<const uint8_t> clave, std::span<const uint8_t> mensaje,
+                       std::span<const uint8_t> firma, bool valida) {
+
+    Tupla tupla;
+    tupla.conjunto = indice_conjunto(conjunto);
+    tupla.valida = valida;
+
+    poner_entero(m_datos, tupla.conjunto, 4);
+    poner_entero(m_datos, valida ? 1 : 0, 1);
+
+    // Se anota dónde queda cada campo dentro del bloque, después de su longitud
+    auto campo = [&](std::span<const uint8_t> bytes, size_t& inicio, size_t& tam) {
+        poner_campo(m_datos, bytes);
+        inicio = m_datos.size() - bytes.size();
+        tam = bytes.size();
+    };
+
+    campo(clave, tupla.clave, tupla.tam_clave);
+    campo(mensaje, tupla.mensaje, tupla.tam_mensaje);
+    campo(firma, tupla.firma, tupla.tam_firma);
+
+    m_tuplas.push_back(tupla);
+}
+
+void ArenaLote::guardar(const std::string& fichero) const {
+    std::vector<uint8_t> contenido(MAGIA_LOTE, MAGIA_LOTE + sizeof(MAGIA_LOTE));
+
+    poner_entero(contenido, m_conjuntos.size(), 4);
+    for(const auto& conjunto : m_conjuntos) {
+        poner_entero(contenido, conjunto.prehash ? 1 : 0, 1);
+        poner_campo(contenido, std::span(reinterpret_cast<const uint8_t*>(conjunto.nombre.data()), conjunto.nombre.size()), 2);
+    }
+    poner_entero(contenido, m_tuplas.size(), 8);
+
+    contenido.insert(contenido.end(), m_datos.begin(), m_datos.end());
+    escribir_fichero(fichero, contenido);
+}
+
+ArenaLote ArenaLote::cargar(const std::string& fichero) {
+    std::vector<uint8_t> contenido = leer_fichero(fichero);
+    if(contenido.size() < sizeof(MAGIA_LOTE) || !std::equal(MAGIA_LOTE, MAGIA_LOTE + sizeof(MAGIA_LOTE), contenido.begin())) {
+        throw std::runtime_error("El fichero " + fichero + " no es un lote válido");
+    }
+
+    ArenaLote lote;
+    size_t pos = sizeof(MAGIA_LOTE);
+
+    size_t num_conjuntos = leer_entero(contenido, pos, 4);
+    for(size_t i = 0; i < num_conjuntos; ++i) {
+        bool prehash = leer_entero(contenido, pos, 1) != 0;
+        std::span<const uint8_t> nombre = leer_campo(contenido, pos, 2);
+        lote.m_conjuntos.push_back(buscar_conjunto(std::string(nombre.begin(), nombre.end()), prehash));
+    }
+
+    size_t num_tuplas = leer_entero(contenido, pos, 8);
+
+    // Los registros se quedan tal cual en memoria; sólo se construye el índice
+    contenido.erase(contenido.begin(), contenido.begin() + pos);
+    lote.m_datos = std::move(contenido);
+    std::span<const uint8_t> datos(lote.m_datos);
+
+    auto campo = [&](size_t& inicio, size_t& tam) {
+        std::span<const uint8_t> bytes = leer_campo(datos, pos);
+        inicio = bytes.data() - datos.data();
+        tam = bytes.size();
+    };
+
+    pos = 0;
+    lote.m_tuplas.reserve(num_tuplas);
+    for(size_t i = 0; i < num_tuplas; ++i) {
+        Tupla tupla;
+        tupla.conjunto = static_cast<uint32_t>(leer_entero(datos, pos, 4));
+        tupla.valida = leer_entero(datos, pos, 1) != 0;
+        if(tupla.conjunto >= lote.m_conjuntos.size()) {
+            throw std::runtime_error("Tupla con un set de parámetros inexistente en el lote");
+        }
+
+        campo(tupla.clave, tupla.tam_clave);
+        campo(tupla.mensaje, tupla.tam_mensaje);
+        campo(tupla.firma, tupla.tam_firma);
+        lote.m_tuplas.push_back(tupla);
+    }
+
+    if(pos != datos.size()) {
+        throw std::runtime_error("Datos sobrantes al final del lote");
+    }
+
+    return lote;
+}
+
+// ----- GENERADOR DE LOTES -----
+
+ArenaLote generar_lote(const std::vector<Conjunto>& mezcla, size_t claves, size_t firmas_por_clave,
+                       double invalidas, std::mt19937_64& aleatorio) {
+
+    struct Pendiente {
+        size_t clave;
+        std::vector<uint8_t> mensaje;
+        std::vector<uint8_t> firma;
+        bool valida;
+    };
+
+    Botan::AutoSeeded_RNG rng;
+    std::uniform_int_distribution<size_t> tam_mensaje(32, 1024);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::bernoulli_distribution alterar(invalidas);
+
+    std::vector<Conjunto> conjunto_clave;
+    std::vector<std::vector<uint8_t>> publicas;
+    std::vector<Pendiente> pendientes;
+
+    // Los firmantes se reparten entre los sets de la mezcla de forma cíclica
+    for(size_t k = 0; k < claves; ++k) {
+        const Conjunto& conjunto = mezcla[k % mezcla.size()];
+        auto esquema = crear_esquema(conjunto);
+        auto clave = esquema->generar_clave(rng);
+        Botan::PK_Signer signer(*clave, rng, esquema->padding_firma());
+
+        conjunto_clave.push_back(conjunto);
+        publicas.push_back(clave->public_key_bits());
+
+        for(size_t f = 0; f < firmas_por_clave; ++f) {
+            Pendiente p;
+            p.clave = k;
+            p.mensaje.resize(tam_mensaje(aleatorio));
+            for(auto& b : p.mensaje) {
+                b = static_cast<uint8_t>(byte(aleatorio));
+            }
+
+            p.firma = signer.sign_message(p.mensaje, rng);
+            p.valida = !alterar(aleatorio);
+            if(!p.valida) {
+                std::uniform_int_distribution<size_t> posicion(0, p.firma.size() - 1);
+                p.firma[posicion(aleatorio)] ^= static_cast<uint8_t>(1 + byte(aleatorio) % 255);
+            }
+
+            pendientes.push_back(std::move(p));
+        }
+    }
+
+    std::shuffle(pendientes.begin(), pendientes.end(), aleatorio);
+
+    ArenaLote lote;
+    for(const auto& p : pendientes) {
+        lote.anadir(conjunto_clave[p.clave], publicas[p.clave], p.mensaje, p.firma, p.valida);
+    }
+    return lote;
+}
+
+// ----- VERIFICACIÓN -----
+
+ResultadoLote verificar_lote(const ArenaLote& lote, size_t hilos) {
+    ResultadoLote resultado;
+    resultado.tuplas = lote.size();
+    resultado.hilos = hilos;
+
+    // Un esquema por set presente en el lote, compartido por todos los hilos
+    std::vector<std::unique_ptr<Esquema>> esquemas;
+    for(const auto& conjunto : lote.conjuntos()) {
+        esquemas.push_back(crear_esquema(conjunto));
+    }
+
+    /*
+    Agrupación por (set, clave pública). Las claves del mapa apuntan a los bytes de la
+    arena, así que no se copia ninguna clave.
+    */
+    auto inicio = std::chrono::steady_clock::now();
+
+    std::vector<std::vector<size_t>> grupos;
+    std::vector<std::unordered_map<std::string_view, size_t>> indice(lote.conjuntos().size());
+    for(size_t i = 0; i < lote.size(); ++i) {
+        std::span<const uint8_t> clave = lote.clave(i);
+        std::string_view bytes(reinterpret_cast<const char*>(clave.data()), clave.size());
+
+        auto [it, nuevo] = indice[lote.tupla(i).conjunto].try_emplace(bytes, grupos.size());
+        if(nuevo) {
+            grupos.emplace_back();
+        }
+        grupos[it->second].push_back(i);
+    }
+
+    /*
+    Reparto inicial: los grupos más grandes primero y por turnos, para que las colas
+    empiecen equilibradas. Cada hilo consume su cola por delante y, cuando se vacía,
+    roba por detrás de las de los demás.
+    */
+    struct Cola {
+        std::mutex mutex;
+        std::deque<size_t> grupos;
+    };
+    std::vector<Cola> colas(hilos);
+
+    std::vector<size_t> orden(grupos.size());
+    for(size_t g = 0; g < orden.size(); ++g) {
+        orden[g] = g;
+    }
+    std::stable_sort(orden.begin(), orden.end(),
+                     [&](size_t a, size_t b) { return grupos[a].size() > grupos[b].size(); });
+    for(size_t g = 0; g < orden.size(); ++g) {
+        colas[g % hilos].grupos.push_back(orden[g]);
+    }
+
+    auto agrupado = std::chrono::steady_clock::now();
+
+    std::vector<std::atomic<uint64_t>> mapa((lote.size() + 63) / 64);
+    std::atomic<size_t> robos{0};
+    std::atomic<size_t> errores{0};
+
+    auto siguiente = [&](size_t h, size_t& grupo) {
+        {
+            std::lock_guard<std::mutex> lock(colas[h].mutex);
+            if(!colas[h].grupos.empty()) {
+                grupo = colas[h].grupos.front();
+                colas[h].grupos.pop_front();
+                return true;
+            }
+        }
+
+        for(size_t d = 1; d < hilos; ++d) {
+            Cola& otra = colas[(h + d) % hilos];
+            std::lock_guard<std::mutex> lock(otra.mutex);
+            if(!otra.grupos.empty()) {
+                grupo = otra.grupos.back();
+                otra.grupos.pop_back();
+                robos++;
+                return true;
+            }
+        }
+
+        // No se generan grupos nuevos durante la verificación: si todo está vacío se ha terminado
+        return false;
+    };
+
+    std::vector<std::thread> trabajadores;
+    for(size_t h = 0; h < hilos; ++h) {
+        trabajadores.emplace_back([&, h] {
+            size_t grupo = 0;
+            while(siguiente(h, grupo)) {
+                const std::vector<size_t>& tuplas = grupos[grupo];
+                const Esquema& esquema = *esquemas[lote.tupla(tuplas[0]).conjunto];
+
+                // Una clave pública mal formada invalida su grupo, no el lote entero
+                try {
+                    auto pub_key = esquema.cargar_clave_publica(lote.clave(tuplas[0]));
+                    Botan::PK_Verifier verifier(*pub_key, esquema.padding_verificacion());
+
+                    for(size_t i : tuplas) {
+                        std::span<const uint8_t> msg = lote.mensaje(i);
+                        std::span<const uint8_t> firma = lote.firma(i);
+                        verifier.update(msg.data(), msg.size());
+                        if(verifier.check_signature(firma.data(), firma.size())) {
+                            mapa[i / 64].fetch_or(uint64_t(1) << (i % 64), std::memory_order_relaxed);
+                        }
+                    }
+                } catch(const std::exception&) {
+                    errores++;
+                }
+            }
+        });
+    }
+
+    for(auto& trabajador : trabajadores) {
+        trabajador.join();
+    }
+    auto fin = std::chrono::steady_clock::now();
+
+    resultado.grupos = grupos.size();
+    resultado.segundos_agrupar = std::chrono::duration<double>(agrupado - inicio).count();
+    resultado.segundos_verificar = std::chrono::duration<double>(fin - agrupado).count();
+    resultado.robos = robos.load();
+    resultado.errores = errores.load();
+
+    resultado.mapa.reserve(mapa.size());
+    for(const auto& palabra : mapa) {
+        resultado.mapa.push_back(palabra.load());
+    }
+
+    for(size_t i = 0; i < lote.size(); ++i) {
+        bool valida = (resultado.mapa[i / 64] >> (i % 64)) & 1;
+        resultado.validas += valida;
+        resultado.discrepancias += valida != lote.tupla(i).valida;
+    }
+
+    return resultado;
+}
+
+// ----- MODO lote -----
+
+static void describir_lote(const ArenaLote& lote, std::ostream& salida) {
+    size_t bytes = 0;
+    for(size_t i = 0; i < lote.size(); ++i) {
+        bytes += lote.clave(i).size() + lote.mensaje(i).size() + lote.firma(i).size();
+    }
+
+    salida << "Lote: " << lote.size() << " tuplas, " << bytes << " bytes | sets:";
+    for(const auto& conjunto : lote.conjuntos()) {
+        salida << " " << conjunto.nombre << (conjunto.prehash ? " (pre-hash)" : "");
+    }
+    salida << "\n";
+}
+
+static void imprimir_lote(const std::vector<ResultadoLote>& resultados, std::ostream& salida) {
+    salida << std::setw(6) << "Hilos" << std::setw(9) << "Grupos" << std::setw(14) << "Agrupar (s)"
+           << std::setw(16) << "Verificar (s)" << std::setw(14) << "verif/s" << std::setw(8) << "Robos"
+           << std::setw(9) << "Válidas" << std::setw(15) << "Discrepancias" << "\n";
+
+    for(const auto& r : resultados) {
+        double total = r.segundos_agrupar + r.segundos_verificar;
+        salida << std::setw(6) << r.hilos << std::setw(9) << r.grupos
+               << std::setw(14) << r.segundos_agrupar << std::setw(16) << r.segundos_verificar
+               << std::setw(14) << std::fixed << std::setprecision(1) << (total > 0 ? r.tuplas / total : 0)
+               << std::defaultfloat << std::setprecision(6)
+               << std::setw(8) << r.robos << std::setw(9) << r.validas << std::setw(15) << r.discrepancias << "\n";
+
+        if(r.errores > 0) {
+            salida << "       [!] " << r.errores << " claves públicas no se pudieron cargar\n";
+        }
+    }
+}
+
+// Verifica el lote con cada número de hilos pedido; devuelve el número de mediciones con discrepancias
+static int medir_lote(const ArenaLote& lote, const std::vector<long>& hilos) {
+    std::vector<ResultadoLote> resultados;
+    for(long h : hilos) {
+        resultados.push_back(verificar_lote(lote, h));
+    }
+    imprimir_lote(resultados, std::cout);
+
+    return static_cast<int>(std::count_if(resultados.begin(), resultados.end(),
+                                          [](const ResultadoLote& r) { return r.discrepancias > 0; }));
+}
+
+int ejecutar_lote(const Argumentos& args) {
+    const auto& pos = args.posicionales();
+    if(pos.empty() || (pos[0] == "generar" && pos.size() < 3) || (pos[0] == "verificar" && pos.size() != 2) ||
+       (pos[0] != "generar" && pos[0] != "verificar" && pos.size() != 1)) {
+        std::cerr << "Uso: ./pqbench lote <set|familia|todos> [--claves=N] [--firmas=N] [--invalidas=p] [--hilos=1,2,4]\n"
+                     "     ./pqbench lote generar <fichero> <set|familia|todos>... [--claves=N] [--firmas=N] [--invalidas=p]\n"
+                     "     ./pqbench lote verificar <fichero> [--hilos=1,2,4]\n";
+        return 1;
+    }
+
+    std::vector<long> hilos = args.enteros("hilos", {static_cast<long>(std::max(1u, std::thread::hardware_concurrency()))});
+    long claves = args.entero("claves", 16);
+    long firmas = args.entero("firmas", 64);
+    double invalidas = args.real("invalidas", 0.0);
+    std::mt19937_64 aleatorio(args.entero("semilla", std::random_device{}()));
+
+    if(claves < 1 || firmas < 1 || invalidas < 0 || invalidas > 1 ||
+       std::any_of(hilos.begin(), hilos.end(), [](long h) { return h < 1; })) {
+        std::cerr << "Opciones inválidas para el modo lote.\n";
+        return 1;
+    }
+
+    if(pos[0] == "verificar") {
+        auto inicio = std::chrono::steady_clock::now();
+        ArenaLote lote = ArenaLote::cargar(pos[1]);
+        auto fin = std::chrono::steady_clock::now();
+
+        describir_lote(lote, std::cout);
+        std::cout << "Tiempo de carga del lote: " << std::chrono::duration<double>(fin - inicio).count() << "s\n";
+        return medir_lote(lote, hilos) == 0 ? 0 : 1;
+    }
+
+    // Mezcla de sets: todos los indicados, sin repetir
+    std::vector<Conjunto> mezcla;
+    for(size_t i = pos[0] == "generar" ? 2 : 0; i < pos.size(); ++i) {
+        std::vector<Conjunto> elegidos = seleccionar(pos[i], args.activa("prehash"));
+        if(elegidos.empty()) {
+            std::cerr << "Set de parámetros inválido: " << pos[i] << "\n";
+            return 1;
+        }
+        for(const auto& conjunto : elegidos) {
+            if(std::none_of(mezcla.begin(), mezcla.end(), [&](const Conjunto& c) { return c.nombre == conjunto.nombre; })) {
+                mezcla.push_back(conjunto);
+            }
+        }
+    }
+
+    if(pos[0] == "generar") {
+        ArenaLote lote = generar_lote(mezcla, claves, firmas, invalidas, aleatorio);
+        lote.guardar(pos[1]);
+        describir_lote(lote, std::cout);
+        std::cout << "Guardado en " << pos[1] << "\n";
+        return 0;
+    }
+
+    // Sin fichero: un lote en memoria por cada set elegido
+    int fallos = 0;
+    for(const auto& conjunto : mezcla) {
+        try {
+            std::cout << "VERIFICACIÓN POR LOTES DE " << conjunto.nombre << (conjunto.prehash ? " (pre-hash)" : "")
+                      << " | " << claves << " claves x " << firmas << " firmas\n";
+
+            ArenaLote lote = generar_lote({conjunto}, claves, firmas, invalidas, aleatorio);
+            fallos += medir_lote(lote, hilos);
+            std::cout << "\n";
+        } catch(const std::exception& e) {
+            std::cerr << "Excepción en lote(" << conjunto.nombre << "): " << e.what() << "\n";
+            ++fallos;
+        }
+    }
+
+    return fallos == 0 ? 0 : 1;
+}
+
+} // namespace pqbench
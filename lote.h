@@ -0,0 +1,96 @@
+#ifndef PQBENCH_LOTE_H
+#define PQBENCH_LOTE_H
+
+#include "pqbench.h"
+
+#include <random>
+
+/*
+Verificación por lotes de tuplas (mensaje, firma, clave pública).
+
+Las tuplas se guardan seguidas en un único bloque de memoria (ArenaLote), que es
+directamente el contenido del fichero de lote, así que cargar un lote no copia cada
+tupla por separado. Antes de verificar, las tuplas se agrupan por clave pública para
+construir un único PK_Verifier por firmante, y los grupos se reparten entre hilos con
+robo de trabajo. El resultado es un mapa de bits con una posición por tupla.
+*/
+
+namespace pqbench {
+
+class ArenaLote {
+public:
+    // Posición de una tupla dentro del bloque de datos
+    struct Tupla {
+        uint32_t conjunto;  // Índice en conjuntos()
+        bool valida;        // Resultado esperado (el generador puede introducir firmas erróneas)
+        size_t clave, tam_clave;
+        size_t mensaje, tam_mensaje;
+        size_t firma, tam_firma;
+    };
+
+    // Añade una tupla copiándola al final del bloque
+    void anadir(const Conjunto& conjunto, std::span<const uint8_t> clave, std::span<const uint8_t> mensaje,
+                std::span<const uint8_t> firma, bool valida);
+
+    size_t size() const { return m_tuplas.size(); }
+    const Tupla& tupla(size_t i) const { return m_tuplas[i]; }
+    const std::vector<Conjunto>& conjuntos() const { return m_conjuntos; }
+
+    std::span<const uint8_t> clave(size_t i) const { return {m_datos.data() + m_tuplas[i].clave, m_tuplas[i].tam_clave}; }
+    std::span<const uint8_t> mensaje(size_t i) const { return {m_datos.data() + m_tuplas[i].mensaje, m_tuplas[i].tam_mensaje}; }
+    std::span<const uint8_t> firma(size_t i) const { return {m_datos.data() + m_tuplas[i].firma, m_tuplas[i].tam_firma}; }
+
+    /*
+    Formato del fichero (enteros en little-endian):
+      "PQBLOTE1"
+      u32 número de sets; por cada uno: u8 prehash, u16 longitud, nombre
+      u64 número de tuplas; por cada una:
+        u32 set, u8 válida, u32 longitud + clave pública, u32 longitud + mensaje, u32 longitud + firma
+    */
+    void guardar(const std::string& fichero) const;
+    static ArenaLote cargar(const std::string& fichero);
+
+private:
+    uint32_t indice_conjunto(const Conjunto& conjunto);
+
+    std::vector<Conjunto> m_conjuntos;
+    std::vector<uint8_t> m_datos; // Registros de las tuplas tal y como van en el fichero
+    std::vector<Tupla> m_tuplas;
+};
+
+/*
+Genera un lote realista: `claves` firmantes repartidos entre los sets de la mezcla,
+`firmas_por_clave` mensajes aleatorios (de 32 a 1024 bytes) firmados por cada uno y
+una fracción `invalidas` de firmas alteradas. Las tuplas se desordenan, como en una
+cola que recibe firmas de muchos firmantes a la vez.
+*/
+ArenaLote generar_lote(const std::vector<Conjunto>& mezcla, size_t claves, size_t firmas_por_clave,
+                       double invalidas, std::mt19937_64& aleatorio);
+
+struct ResultadoLote {
+    size_t tuplas = 0;
+    size_t grupos = 0;               // Claves públicas distintas = verificadores construidos
+    size_t hilos = 0;
+    double segundos_agrupar = 0;
+    double segundos_verificar = 0;   // Incluye cargar cada clave y construir su verificador
+    size_t validas = 0;
+    size_t discrepancias = 0;        // Tuplas cuyo resultado no coincide con el esperado
+    size_t robos = 0;                // Grupos que un hilo ha tomado de la cola de otro
+    size_t errores = 0;              // Grupos cuya clave pública no se pudo cargar
+    std::vector<uint64_t> mapa;      // Bit i a 1 si la tupla i es válida
+};
+
+// Verifica todas las tuplas del lote con `hilos` hilos
+ResultadoLote verificar_lote(const ArenaLote& lote, size_t hilos);
+
+/*
+Punto de entrada del modo desde la línea de comandos:
+  ./pqbench lote <set|familia|todos> [--claves=N] [--firmas=N] [--invalidas=p] [--hilos=N]
+  ./pqbench lote generar <fichero> <set|familia|todos>... [--claves=N] [--firmas=N] [--invalidas=p]
+  ./pqbench lote verificar <fichero> [--hilos=N]
+*/
+int ejecutar_lote(const Argumentos& args);
+
+} // namespace pqbench
+
+#endif
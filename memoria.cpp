@@ -0,0 +1,405 @@
+#include "memoria.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+#include <thread>
+
+#include <malloc.h>
+#include <pthread.h>
+#include <sys/resource.h>
+
+// Funciones internas de glibc a las que llaman las versiones sustituidas
+extern "C" {
+void* __libc_malloc(size_t bytes);
+void* __libc_calloc(size_t elementos, size_t bytes);
+void* __libc_realloc(void* puntero, size_t bytes);
+void* __libc_memalign(size_t alineacion, size_t bytes);
+void __libc_free(void* puntero);
+}
+
+namespace pqbench {
+
+// ----- CONTADORES DEL MONTÓN -----
+
+static std::atomic<bool> g_activa{false};
+static std::atomic<uint64_t> g_reservas{0};
+static std::atomic<uint64_t> g_bytes_reservados{0};
+static std::atomic<int64_t> g_vivos{0}; // Puede ser negativo: se liberan bloques reservados antes de activar
+static std::atomic<int64_t> g_pico{0};
+
+// ----- REGISTRO DE BLOQUES -----
+
+/*
+Tabla de direcciones abierta con sondeo lineal y borrado por desplazamiento hacia atrás.
+Es estática porque se usa desde malloc y free, donde no se puede reservar memoria.
+*/
+enum EstadoRegistro : int { REGISTRO_INACTIVO, REGISTRO_GRABANDO, REGISTRO_SIGUIENDO };
+
+struct Bloque {
+    void* puntero;
+    size_t bytes;
+};
+
+static const size_t TAM_REGISTRO = 1 << 16;
+static Bloque g_bloques[TAM_REGISTRO];
+static size_t g_num_bloques = 0;
+static size_t g_bloques_perdidos = 0;
+static std::atomic<int> g_registro{REGISTRO_INACTIVO};
+static std::atomic_flag g_cerrojo_registro = ATOMIC_FLAG_INIT;
+
+static void bloquear_registro() {
+    while(g_cerrojo_registro.test_and_set(std::memory_order_acquire)) {}
+}
+
+static void desbloquear_registro() {
+    g_cerrojo_registro.clear(std::memory_order_release);
+}
+
+static size_t posicion_bloque(void* puntero) {
+    // Los bloques están alineados a 16 bytes: los 4 bits bajos no distinguen nada
+    return (reinterpret_cast<uintptr_t>(puntero) >> 4) * 0x9E3779B97F4A7C15ull >> 48 & (TAM_REGISTRO - 1);
+}
+
+static void registrar_bloque(void* puntero) {
+    if(!puntero || g_registro.load(std::memory_order_relaxed) != REGISTRO_GRABANDO) {
+        return;
+    }
+
+    bloquear_registro();
+    // Se deja siempre un hueco libre para que las búsquedas terminen
+    if(g_num_bloques + 1 >= TAM_REGISTRO) {
+        ++g_bloques_perdidos;
+    } else {
+        size_t i = posicion_bloque(puntero);
+        while(g_bloques[i].puntero && g_bloques[i].puntero != puntero) {
+            i = (i + 1) & (TAM_REGISTRO - 1);
+        }
+        g_num_bloques += !g_bloques[i].puntero;
+        g_bloques[i] = {puntero, malloc_usable_size(puntero)};
+    }
+    desbloquear_registro();
+}
+
+static void olvidar_bloque(void* puntero) {
+    if(!puntero || g_registro.load(std::memory_order_relaxed) == REGISTRO_INACTIVO) {
+        return;
+    }
+
+    bloquear_registro();
+    size_t i = posicion_bloque(puntero);
+    while(g_bloques[i].puntero && g_bloques[i].puntero != puntero) {
+        i = (i + 1) & (TAM_REGISTRO - 1);
+    }
+
+    if(g_bloques[i].puntero) {
+        // Se adelantan los bloques siguientes del mismo grupo que ya no estarían accesibles
+        size_t hueco = i;
+        for(size_t j = (i + 1) & (TAM_REGISTRO - 1); g_bloques[j].puntero; j = (j + 1) & (TAM_REGISTRO - 1)) {
+            size_t ideal = posicion_bloque(g_bloques[j].puntero);
+            if(((j - ideal) & (TAM_REGISTRO - 1)) >= ((j - hueco) & (TAM_REGISTRO - 1))) {
+                g_bloques[hueco] = g_bloques[j];
+                hueco = j;
+            }
+        }
+        g_bloques[hueco] = {nullptr, 0};
+        --g_num_bloques;
+    }
+    desbloquear_registro();
+}
+
+static void anotar_reserva(void* puntero) {
+    registrar_bloque(puntero);
+    if(!puntero || !g_activa.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    size_t bytes = malloc_usable_size(puntero);
+    g_reservas.fetch_add(1, std::memory_order_relaxed);
+    g_bytes_reservados.fetch_add(bytes, std::memory_order_relaxed);
+
+    int64_t vivos = g_vivos.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) + static_cast<int64_t>(bytes);
+    int64_t pico = g_pico.load(std::memory_order_relaxed);
+    while(vivos > pico && !g_pico.compare_exchange_weak(pico, vivos, std::memory_order_relaxed)) {}
+}
+
+static void anotar_liberacion(void* puntero) {
+    olvidar_bloque(puntero);
+    if(!puntero || !g_activa.load(std::memory_order_relaxed)) {
+        return;
+    }
+    g_vivos.fetch_sub(static_cast<int64_t>(malloc_usable_size(puntero)), std::memory_order_relaxed);
+}
+
+static void* reservar_alineado(size_t alineacion, size_t bytes) {
+    void* puntero = __libc_memalign(alineacion, bytes);
+    anotar_reserva(puntero);
+    return puntero;
+}
+
+// ----- PILA -----
+
+static const size_t TAM_PILA_RELLENA = 512 * 1024;
+static const size_t MARGEN_PILA = 1024;       // Por debajo del marco de rellenar_pila(), que sigue en uso
+static const size_t GUARDA_PILA = 64 * 1024;  // Se deja sin tocar junto al límite inferior de la pila
+static const uint8_t PATRON_PILA = 0xA5;
+
+static std::thread::id g_hilo;
+static bool g_reinicio_rss = false;
+static const volatile uint8_t* g_pila_inicio = nullptr; // Dirección más baja de la zona rellena
+static size_t g_pila_rellena = 0;
+static int64_t g_vivos_inicio = 0;
+
+/*
+Rellena con el patrón hasta TAM_PILA_RELLENA bytes de pila por debajo del marco actual,
+sin pasar del límite inferior de la pila del hilo (pthread_getattr_np). La fase se ejecuta
+después desde el nivel del que llama, así que la zona que use es la que va a sobrescribir.
+*/
+[[gnu::noinline]] static void rellenar_pila() {
+    g_pila_inicio = nullptr;
+    g_pila_rellena = 0;
+
+    pthread_attr_t atributos;
+    if(::pthread_getattr_np(::pthread_self(), &atributos) != 0) {
+        return;
+    }
+    void* base = nullptr;
+    size_t tam = 0;
+    bool leida = ::pthread_attr_getstack(&atributos, &base, &tam) == 0;
+    ::pthread_attr_destroy(&atributos);
+
+    uintptr_t actual = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+    uintptr_t limite = reinterpret_cast<uintptr_t>(base) + GUARDA_PILA;
+    if(!leida || actual < limite + MARGEN_PILA) {
+        return;
+    }
+
+    uintptr_t superior = actual - MARGEN_PILA;
+    uintptr_t inferior = std::max(limite, superior - std::min<uintptr_t>(superior, TAM_PILA_RELLENA));
+    volatile uint8_t* zona = reinterpret_cast<volatile uint8_t*>(inferior);
+    for(size_t i = 0; i < superior - inferior; ++i) {
+        zona[i] = PATRON_PILA;
+    }
+
+    g_pila_inicio = zona;
+    g_pila_rellena = superior - inferior;
+}
+
+static uint64_t pila_usada() {
+    // La pila crece hacia abajo: se busca el primer byte alterado desde la parte más baja
+    size_t intactos = 0;
+    while(intactos < g_pila_rellena && g_pila_inicio[intactos] == PATRON_PILA) {
+        ++intactos;
+    }
+    return g_pila_rellena - intactos;
+}
+
+// ----- PROCESO -----
+
+// Valor en bytes de un campo "Nombre:   N kB" de /proc/self/status
+static uint64_t campo_status(const std::string& texto, const char* campo) {
+    size_t pos = texto.find(campo);
+    if(pos == std::string::npos) {
+        return 0;
+    }
+    return std::strtoull(texto.c_str() + pos + std::strlen(campo), nullptr, 10) * 1024;
+}
+
+MemoriaProceso memoria_proceso() {
+    MemoriaProceso memoria;
+
+    struct rusage uso {};
+    if(::getrusage(RUSAGE_SELF, &uso) == 0) {
+        memoria.max_rss = static_cast<uint64_t>(uso.ru_maxrss) * 1024;
+    }
+
+    std::ifstream status("/proc/self/status");
+    std::string texto((std::istreambuf_iterator<char>(status)), std::istreambuf_iterator<char>());
+    memoria.vm_hwm = campo_status(texto, "VmHWM:");
+    memoria.vm_peak = campo_status(texto, "VmPeak:");
+    memoria.vm_rss = campo_status(texto, "VmRSS:");
+    return memoria;
+}
+
+// Reinicia VmHWM al RSS actual (Linux >= 4.0)
+static bool reiniciar_pico_rss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.flush();
+    return static_cast<bool>(clear_refs);
+}
+
+// ----- FASES -----
+
+bool activar_contabilidad_memoria() {
+    g_hilo = std::this_thread::get_id();
+    g_reinicio_rss = reiniciar_pico_rss();
+    g_activa = true;
+    return g_reinicio_rss;
+}
+
+bool contabilidad_memoria_activa() {
+    return g_activa.load(std::memory_order_relaxed) && std::this_thread::get_id() == g_hilo;
+}
+
+void empezar_fase_memoria() {
+    if(g_reinicio_rss) {
+        reiniciar_pico_rss();
+    }
+    rellenar_pila();
+
+    g_reservas = 0;
+    g_bytes_reservados = 0;
+    g_vivos_inicio = g_vivos.load();
+    g_pico = g_vivos_inicio;
+}
+
+LecturaMemoria terminar_fase_memoria() {
+    LecturaMemoria lectura;
+    lectura.pila = pila_usada();
+    lectura.reservas = g_reservas.load();
+    lectura.bytes_reservados = g_bytes_reservados.load();
+    lectura.pico_monton = static_cast<uint64_t>(std::max<int64_t>(g_pico.load() - g_vivos_inicio, 0));
+    lectura.pico_rss = memoria_proceso().vm_hwm;
+    return lectura;
+}
+
+void empezar_registro_bloques() {
+    terminar_registro_bloques();
+    g_registro = REGISTRO_GRABANDO;
+}
+
+void cerrar_registro_bloques() {
+    g_registro = REGISTRO_SIGUIENDO;
+}
+
+void terminar_registro_bloques() {
+    g_registro = REGISTRO_INACTIVO;
+    bloquear_registro();
+    std::memset(g_bloques, 0, sizeof(g_bloques));
+    g_num_bloques = 0;
+    g_bloques_perdidos = 0;
+    desbloquear_registro();
+}
+
+RegistroBloques recorrer_bloques_registrados(void (*f)(const void* puntero, size_t bytes)) {
+    RegistroBloques registro;
+    bloquear_registro();
+    for(const auto& bloque : g_bloques) {
+        if(bloque.puntero) {
+            f(bloque.puntero, bloque.bytes);
+            ++registro.bloques;
+            registro.bytes += bloque.bytes;
+        }
+    }
+    registro.perdidos = g_bloques_perdidos;
+    desbloquear_registro();
+    return registro;
+}
+
+} // namespace pqbench
+
+// ----- FUNCIONES SUSTITUIDAS -----
+
+extern "C" {
+
+void* malloc(size_t bytes) {
+    void* puntero = __libc_malloc(bytes);
+    pqbench::anotar_reserva(puntero);
+    return puntero;
+}
+
+void* calloc(size_t elementos, size_t bytes) {
+    void* puntero = __libc_calloc(elementos, bytes);
+    pqbench::anotar_reserva(puntero);
+    return puntero;
+}
+
+void* realloc(void* anterior, size_t bytes) {
+    // Se anota antes de llamar: después el bloque anterior ya puede no existir
+    size_t bytes_anteriores = anterior ? malloc_usable_size(anterior) : 0;
+    void* puntero = __libc_realloc(anterior, bytes);
+
+    if(puntero || bytes == 0) {
+        pqbench::olvidar_bloque(anterior);
+        if(anterior && pqbench::g_activa.load(std::memory_order_relaxed)) {
+            pqbench::g_vivos.fetch_sub(static_cast<int64_t>(bytes_anteriores), std::memory_order_relaxed);
+        }
+        pqbench::anotar_reserva(puntero);
+    }
+    return puntero;
+}
+
+void free(void* puntero) {
+    pqbench::anotar_liberacion(puntero);
+    __libc_free(puntero);
+}
+
+void* memalign(size_t alineacion, size_t bytes) {
+    return pqbench::reservar_alineado(alineacion, bytes);
+}
+
+void* aligned_alloc(size_t alineacion, size_t bytes) {
+    return pqbench::reservar_alineado(alineacion, bytes);
+}
+
+int posix_memalign(void** resultado, size_t alineacion, size_t bytes) {
+    if(alineacion < sizeof(void*) || (alineacion & (alineacion - 1)) != 0) {
+        return EINVAL;
+    }
+    void* puntero = pqbench::reservar_alineado(alineacion, bytes);
+    if(!puntero) {
+        return ENOMEM;
+    }
+    *resultado = puntero;
+    return 0;
+}
+
+}
+
+static void* reservar_new(size_t bytes) {
+    void* puntero = malloc(bytes ? bytes : 1);
+    if(!puntero) {
+        throw std::bad_alloc();
+    }
+    return puntero;
+}
+
+static void* reservar_new_alineado(size_t bytes, std::align_val_t alineacion) {
+    void* puntero = pqbench::reservar_alineado(static_cast<size_t>(alineacion), bytes ? bytes : 1);
+    if(!puntero) {
+        throw std::bad_alloc();
+    }
+    return puntero;
+}
+
+void* operator new(size_t bytes) { return reservar_new(bytes); }
+void* operator new[](size_t bytes) { return reservar_new(bytes); }
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept { return malloc(bytes ? bytes : 1); }
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept { return malloc(bytes ? bytes : 1); }
+void* operator new(size_t bytes, std::align_val_t alineacion) { return reservar_new_alineado(bytes, alineacion); }
+void* operator new[](size_t bytes, std::align_val_t alineacion) { return reservar_new_alineado(bytes, alineacion); }
+void* operator new(size_t bytes, std::align_val_t alineacion, const std::nothrow_t&) noexcept {
+    return pqbench::reservar_alineado(static_cast<size_t>(alineacion), bytes ? bytes : 1);
+}
+void* operator new[](size_t bytes, std::align_val_t alineacion, const std::nothrow_t&) noexcept {
+    return pqbench::reservar_alineado(static_cast<size_t>(alineacion), bytes ? bytes : 1);
+}
+
+void operator delete(void* puntero) noexcept { free(puntero); }
+void operator delete[](void* puntero) noexcept { free(puntero); }
+void operator delete(void* puntero, size_t) noexcept { free(puntero); }
+void operator delete[](void* puntero, size_t) noexcept { free(puntero); }
+void operator delete(void* puntero, const std::nothrow_t&) noexcept { free(puntero); }
+void operator delete[](void* puntero, const std::nothrow_t&) noexcept { free(puntero); }
+void operator delete(void* puntero, std::align_val_t) noexcept { free(puntero); }
+void operator delete[](void* puntero, std::align_val_t) noexcept { free(puntero); }
+void operator delete(void* puntero, size_t, std::align_val_t) noexcept { free(puntero); }
+void operator delete[](void* puntero, size_t, std::align_val_t) noexcept { free(puntero); }
+void operator delete(void* puntero, std::align_val_t, const std::nothrow_t&) noexcept { free(puntero); }
+void operator delete[](void* puntero, std::align_val_t, const std::nothrow_t&) noexcept { free(puntero); }
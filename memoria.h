@@ -0,0 +1,83 @@
+#ifndef PQBENCH_MEMORIA_H
+#define PQBENCH_MEMORIA_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+Contabilidad de memoria de cada fase medida.
+
+pqbench sustituye operator new/delete y malloc/calloc/realloc/free (y las variantes
+alineadas) por versiones que llaman a las de glibc y, si la contabilidad está activa,
+anotan cada reserva y liberación con el tamaño real del bloque (malloc_usable_size). Así
+se cuentan también las reservas de Botan, incluidas las de sus hilos (p. ej. el keygen
+de XMSS en paralelo). Mientras no está activa el coste es una comprobación por llamada.
+
+Para cada fase se obtiene:
+- Número de reservas y bytes reservados en total.
+- Pico del montón: máximo de bytes vivos por encima de los que había al empezar.
+- Pila: profundidad máxima de la pila del hilo que mide. Antes de la fase se rellena con
+  un patrón hasta 512 KiB de pila por debajo del marco actual, sin salir de los límites
+  de la pila del hilo, y al terminar se busca hasta dónde se ha sobrescrito.
+- Pico de RSS del proceso (VmHWM de /proc/self/status). Si el núcleo lo permite, el pico
+  se reinicia antes de cada fase escribiendo 5 en /proc/self/clear_refs; si no, es el
+  pico acumulado del proceso.
+*/
+
+namespace pqbench {
+
+struct LecturaMemoria {
+    uint64_t reservas = 0;
+    uint64_t bytes_reservados = 0;
+    uint64_t pico_monton = 0;
+    uint64_t pila = 0;
+    uint64_t pico_rss = 0; // Bytes
+};
+
+// Memoria del proceso completo
+struct MemoriaProceso {
+    uint64_t max_rss = 0;  // ru_maxrss de getrusage
+    uint64_t vm_hwm = 0;   // Pico de RSS según /proc/self/status
+    uint64_t vm_peak = 0;  // Pico de memoria virtual
+    uint64_t vm_rss = 0;   // RSS actual
+};
+
+/*
+Activa la contabilidad para las mediciones posteriores de medir() hechas desde el hilo
+que llama. Devuelve false si no se puede reiniciar el pico de RSS entre fases.
+*/
+bool activar_contabilidad_memoria();
+
+// Si la contabilidad está activa y se llama desde el hilo que la activó
+bool contabilidad_memoria_activa();
+
+// Delimitan una fase: empezar rellena la pila y toma la referencia del montón
+void empezar_fase_memoria();
+LecturaMemoria terminar_fase_memoria();
+
+MemoriaProceso memoria_proceso();
+
+/*
+Registro de los bloques del montón que reservan unos objetos (p. ej. una clave y su
+firmador), para poder recorrerlos después, por ejemplo para expulsarlos de la caché con
+clflush. Mientras se graba se anotan todas las reservas del proceso; al cerrarlo ya no
+se anotan las nuevas, pero se siguen quitando las que se liberan, así que al recorrerlo
+sólo quedan bloques vivos. No incluye la memoria que Botan reserve fuera de malloc (p. ej.
+su pool de memoria bloqueada con mlock).
+*/
+struct RegistroBloques {
+    size_t bloques = 0;
+    uint64_t bytes = 0;
+    size_t perdidos = 0; // Reservas que no cabían en la tabla
+};
+
+void empezar_registro_bloques();
+void cerrar_registro_bloques();
+void terminar_registro_bloques();
+
+// Llama a f con cada bloque vivo del registro. f no puede reservar ni liberar memoria.
+RegistroBloques recorrer_bloques_registrados(void (*f)(const void* puntero, size_t bytes));
+
+} // namespace pqbench
+
+#endif
@@ -0,0 +1,173 @@
+#include "perf.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace pqbench {
+
+const char* nombre_evento(size_t evento) {
+    switch(evento) {
+        case HW_CICLOS: return "ciclos";
+        case HW_INSTRUCCIONES: return "instrucciones";
+        case HW_FALLOS_L1D: return "fallos L1d";
+        case HW_FALLOS_LLC: return "fallos LLC";
+        case HW_FALLOS_SALTO: return "fallos de predicción de saltos";
+        case HW_FALLOS_DTLB: return "fallos dTLB";
+    }
+    return "";
+}
+
+#ifdef __linux__
+
+// Configuración de perf_event_attr para cada evento
+static void configurar(size_t evento, perf_event_attr& attr) {
+    auto cache = [](uint64_t cache, uint64_t operacion, uint64_t resultado) {
+        return cache | (operacion << 8) | (resultado << 16);
+    };
+
+    switch(evento) {
+        case HW_CICLOS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case HW_INSTRUCCIONES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case HW_FALLOS_L1D:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+        case HW_FALLOS_LLC:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+        case HW_FALLOS_SALTO:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case HW_FALLOS_DTLB:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+    }
+}
+
+static std::string perf_event_paranoid() {
+    std::ifstream fichero("/proc/sys/kernel/perf_event_paranoid");
+    std::string valor;
+    fichero >> valor;
+    return valor.empty() ? "?" : valor;
+}
+
+ContadoresHW::ContadoresHW() {
+    m_fd.fill(-1);
+
+    for(size_t evento = 0; evento < NUM_EVENTOS_HW; ++evento) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        configurar(evento, attr);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        // pid = 0, cpu = -1: el hilo actual en cualquier CPU
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if(fd < 0) {
+            if(m_motivo.empty()) {
+                m_motivo = std::string(nombre_evento(evento)) + ": " + std::strerror(errno) +
+                           " (perf_event_paranoid = " + perf_event_paranoid() + ")";
+            }
+            continue;
+        }
+
+        m_fd[evento] = fd;
+    }
+}
+
+ContadoresHW::~ContadoresHW() {
+    for(int fd : m_fd) {
+        if(fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+LecturaHW ContadoresHW::leer() const {
+    LecturaHW lectura{};
+
+    for(size_t evento = 0; evento < NUM_EVENTOS_HW; ++evento) {
+        if(m_fd[evento] < 0) {
+            continue;
+        }
+
+        // valor, tiempo habilitado, tiempo contando
+        uint64_t datos[3] = {0, 0, 0};
+        if(read(m_fd[evento], datos, sizeof(datos)) != sizeof(datos)) {
+            continue;
+        }
+
+        if(datos[2] > 0 && datos[2] < datos[1]) {
+            lectura[evento] = static_cast<uint64_t>(static_cast<double>(datos[0]) * datos[1] / datos[2]);
+        } else {
+            lectura[evento] = datos[0];
+        }
+    }
+
+    return lectura;
+}
+
+#else
+
+ContadoresHW::ContadoresHW() : m_motivo("perf_event_open sólo está disponible en Linux") {
+    m_fd.fill(-1);
+}
+
+ContadoresHW::~ContadoresHW() {}
+
+LecturaHW ContadoresHW::leer() const {
+    return {};
+}
+
+#endif
+
+bool ContadoresHW::disponible() const {
+    for(int fd : m_fd) {
+        if(fd >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Los eventos sólo cuentan el hilo que los abrió, así que sólo se usan desde ese hilo
+static std::unique_ptr<ContadoresHW> activos;
+static std::thread::id hilo_activos;
+
+const ContadoresHW& activar_contadores_hw() {
+    if(!activos) {
+        activos = std::make_unique<ContadoresHW>();
+        hilo_activos = std::this_thread::get_id();
+    }
+    return *activos;
+}
+
+const ContadoresHW* contadores_hw() {
+    if(!activos || !activos->disponible() || std::this_thread::get_id() != hilo_activos) {
+        return nullptr;
+    }
+    return activos.get();
+}
+
+} // namespace pqbench
@@ -0,0 +1,69 @@
+#ifndef PQBENCH_PERF_H
+#define PQBENCH_PERF_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+Contadores hardware de la CPU mediante perf_event_open (sólo Linux).
+
+Se cuentan únicamente los eventos en modo usuario del hilo que mide, lo que permite
+usarlos con perf_event_paranoid <= 2 sin privilegios. Si el núcleo no permite abrir
+algún evento (paranoid alto, máquina virtual sin PMU, etc.) ese evento se marca como
+no disponible y el resto de la medición continúa igual.
+*/
+
+namespace pqbench {
+
+// Eventos que se registran en cada fase
+enum EventoHW : size_t {
+    HW_CICLOS,
+    HW_INSTRUCCIONES,
+    HW_FALLOS_L1D,
+    HW_FALLOS_LLC,
+    HW_FALLOS_SALTO,
+    HW_FALLOS_DTLB,
+    NUM_EVENTOS_HW
+};
+
+using LecturaHW = std::array<uint64_t, NUM_EVENTOS_HW>;
+
+const char* nombre_evento(size_t evento);
+
+class ContadoresHW {
+public:
+    ContadoresHW();
+    ~ContadoresHW();
+
+    ContadoresHW(const ContadoresHW&) = delete;
+    ContadoresHW& operator=(const ContadoresHW&) = delete;
+
+    // Si se ha podido abrir al menos un evento
+    bool disponible() const;
+    bool disponible(size_t evento) const { return m_fd[evento] >= 0; }
+
+    // Motivo por el que no se ha podido abrir algún evento (vacío si se abrieron todos)
+    const std::string& motivo() const { return m_motivo; }
+
+    // Valor acumulado de cada evento, escalado si el núcleo ha tenido que multiplexarlo
+    LecturaHW leer() const;
+
+private:
+    std::array<int, NUM_EVENTOS_HW> m_fd;
+    std::string m_motivo;
+};
+
+/*
+Activa los contadores para todas las mediciones posteriores de medir() hechas desde
+el hilo que llama. Devuelve los contadores abiertos para consultar su disponibilidad.
+*/
+const ContadoresHW& activar_contadores_hw();
+
+// Contadores activos, o nullptr si no se han activado o se llama desde otro hilo
+const ContadoresHW* contadores_hw();
+
+} // namespace pqbench
+
+#endif
@@ -0,0 +1,205 @@
+#include "perfil_xmss.h"
+#include "cache_claves.h"
+
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace pqbench {
+
+PerfilXMSS perfilar_xmss(const Esquema& esquema, Botan::Private_Key& clave, size_t firmas) {
+    const EsquemaXMSS& xmss = esquema_xmss(esquema);
+    const auto& privada = dynamic_cast<const Botan::XMSS_PrivateKey&>(clave);
+
+    Botan::AutoSeeded_RNG rng;
+    Botan::PK_Signer signer(clave, rng, esquema.padding_firma());
+    const Botan::secure_vector<uint8_t>& msg = mensaje_fijo();
+
+    PerfilXMSS perfil;
+    perfil.conjunto = esquema.conjunto();
+    perfil.hojas_totales = xmss.parametros().total_number_of_signatures();
+    perfil.primera_hoja = EsquemaXMSS::A::hoja_actual(xmss.parametros(), privada);
+    perfil.firmas.reserve(firmas);
+
+    // Cada firma consume la siguiente hoja de la clave
+    std::vector<uint8_t> signature;
+    for(size_t i = 0; i < firmas; ++i) {
+        perfil.firmas.push_back(medir([&] {
+            signer.update(msg.data(), msg.size());
+            signature = signer.signature(rng);
+        }));
+    }
+
+    perfil.restantes = privada.remaining_signatures();
+
+    if(!signature.empty()) {
+        auto pub_key = clave.public_key();
+        Botan::PK_Verifier verifier(*pub_key, esquema.padding_verificacion());
+        verifier.update(msg.data(), msg.size());
+        perfil.verificada = verifier.check_signature(signature.data(), signature.size());
+    }
+
+    return perfil;
+}
+
+static void imprimir_perfil(const PerfilXMSS& perfil, size_t tramos, std::ostream& salida) {
+    size_t firmas = perfil.firmas.size();
+
+    salida << "PERFIL DE FIRMA POR HOJA DE " << perfil.conjunto.nombre << "\n"
+           << "Hojas firmadas: " << perfil.primera_hoja << " - " << perfil.primera_hoja + firmas - 1
+           << " (" << firmas << " firmas)\n"
+           << "Firmas restantes: " << perfil.restantes << " de " << perfil.hojas_totales << "\n";
+
+    std::vector<double> segundos, ciclos;
+    size_t peor = 0;
+    for(size_t i = 0; i < firmas; ++i) {
+        segundos.push_back(perfil.firmas[i].segundos);
+        ciclos.push_back(static_cast<double>(perfil.firmas[i].ciclos));
+        if(perfil.firmas[i].segundos > perfil.firmas[peor].segundos) {
+            peor = i;
+        }
+    }
+
+    Estadisticas t = calcular_estadisticas(segundos);
+    Estadisticas c = calcular_estadisticas(ciclos);
+    std::sort(segundos.begin(), segundos.end());
+
+    salida << "Latencia por firma: mín " << t.min << "s | mediana " << t.mediana << "s | media " << t.media
+           << "s | p90 " << t.p90 << "s | p99 " << t.p99 << "s | p99.9 " << percentil(segundos, 99.9)
+           << "s | máx " << t.max << "s\n"
+           << "Peor caso: hoja " << perfil.primera_hoja + peor << " (" << t.max << "s, "
+           << perfil.firmas[peor].ciclos << " ciclos)\n"
+           << "Ciclos por firma: mediana " << static_cast<uint64_t>(c.mediana) << " | p99 "
+           << static_cast<uint64_t>(c.p99) << " | máx " << static_cast<uint64_t>(c.max) << "\n";
+
+    // Latencia por tramos consecutivos de hojas, para ver si depende del índice
+    tramos = std::clamp<size_t>(tramos, 1, firmas);
+    std::vector<Estadisticas> por_tramo;
+    double mayor_media = 0;
+    for(size_t k = 0; k < tramos; ++k) {
+        size_t inicio = k * firmas / tramos, fin = (k + 1) * firmas / tramos;
+        std::vector<double> tramo;
+        for(size_t i = inicio; i < fin; ++i) {
+            tramo.push_back(perfil.firmas[i].segundos);
+        }
+        por_tramo.push_back(calcular_estadisticas(std::move(tramo)));
+        mayor_media = std::max(mayor_media, por_tramo.back().media);
+    }
+
+    salida << std::setw(22) << "Hojas" << std::setw(14) << "Media (s)" << std::setw(14) << "p99 (s)"
+           << std::setw(14) << "Máx (s)" << "  Media relativa\n";
+    for(size_t k = 0; k < tramos; ++k) {
+        size_t inicio = perfil.primera_hoja + k * firmas / tramos;
+        size_t fin = perfil.primera_hoja + (k + 1) * firmas / tramos - 1;
+        const Estadisticas& e = por_tramo[k];
+
+        salida << std::setw(22) << (std::to_string(inicio) + " - " + std::to_string(fin))
+               << std::setw(14) << e.media << std::setw(14) << e.p99 << std::setw(14) << e.max << "  "
+               << std::string(mayor_media > 0 ? static_cast<size_t>(e.media / mayor_media * 40) : 0, '#') << "\n";
+    }
+
+    salida << (perfil.verificada ? "Firma Verificada." : "Firma Errónea.") << "\n";
+}
+
+static void escribir_csv(const PerfilXMSS& perfil, const std::string& fichero) {
+    std::ofstream salida(fichero);
+    salida << "hoja,segundos,ciclos\n";
+    for(size_t i = 0; i < perfil.firmas.size(); ++i) {
+        salida << perfil.primera_hoja + i << "," << perfil.firmas[i].segundos << "," << perfil.firmas[i].ciclos << "\n";
+    }
+
+    if(!salida) {
+        throw std::runtime_error("No se pudo escribir " + fichero);
+    }
+}
+
+int ejecutar_perfil_xmss(const Argumentos& args) {
+    if(args.posicionales().size() != 1) {
+        std::cerr << "Uso: ./pqbench perfil-xmss <set XMSS|XMSS> [--desde=hoja] [--firmas=N|todas] [--tramos=32]"
+                     " [--csv=fichero] [--cache-claves[=d]] [--semilla=N]\n";
+        return 1;
+    }
+
+    Opciones opciones = leer_opciones(args);
+    long desde = args.entero("desde", -1);
+    long tramos = args.entero("tramos", 32);
+    std::string firmas_pedidas = args.texto("firmas", "");
+    std::string csv = args.texto("csv", "");
+
+    if(tramos < 1 || (firmas_pedidas != "" && firmas_pedidas != "todas" && args.entero("firmas", 0) < 1)) {
+        std::cerr << "Opciones inválidas para el modo perfil-xmss.\n";
+        return 1;
+    }
+
+    std::vector<Conjunto> elegidos = seleccionar(args.posicionales()[0], false);
+    elegidos.erase(std::remove_if(elegidos.begin(), elegidos.end(),
+                                  [](const Conjunto& c) { return c.familia != Familia::XMSS; }), elegidos.end());
+    if(elegidos.empty()) {
+        std::cerr << "Set de parámetros inválido: el modo perfil-xmss sólo admite sets de XMSS.\n";
+        return 1;
+    }
+
+    int fallos = 0;
+    for(const auto& conjunto : elegidos) {
+        try {
+            auto esquema = crear_esquema(conjunto);
+            const EsquemaXMSS& xmss = esquema_xmss(*esquema);
+
+            // La clave sale de la caché si se pide, porque en alturas 16 y 20 generarla es muy lento
+            ClaveObtenida obtenida = obtener_clave(*esquema, opciones);
+            std::unique_ptr<Botan::Private_Key> clave = std::move(obtenida.clave);
+            if(obtenida.de_cache) {
+                std::cout << "Clave cargada de la caché: " << obtenida.ruta << "\n";
+            } else {
+                std::cout << "Clave generada en " << obtenida.keygen.segundos << "s\n";
+            }
+
+            if(desde >= 0) {
+                clave = EsquemaXMSS::A::saltar_a_hoja(xmss.parametros(), dynamic_cast<const Botan::XMSS_PrivateKey&>(*clave), desde);
+            }
+
+            /*
+            Por defecto se recorren todas las hojas que quedan en altura 10 y 1024 firmas en
+            alturas mayores (2^20 firmas pueden llevar días).
+            */
+            size_t restantes = dynamic_cast<const Botan::XMSS_PrivateKey&>(*clave).remaining_signatures();
+            size_t firmas = xmss.parametros().tree_height() <= 10 ? restantes : std::min<size_t>(1024, restantes);
+            if(firmas_pedidas == "todas") {
+                firmas = restantes;
+            } else if(!firmas_pedidas.empty()) {
+                firmas = std::min<size_t>(args.entero("firmas", 0), restantes);
+            }
+
+            if(firmas == 0) {
+                std::cerr << "La clave de " << conjunto.nombre << " no tiene hojas libres (usa --desde o --regenerar).\n";
+                ++fallos;
+                continue;
+            }
+
+            PerfilXMSS perfil = perfilar_xmss(*esquema, *clave, firmas);
+            imprimir_perfil(perfil, tramos, std::cout);
+            std::cout << "\n";
+
+            if(!csv.empty()) {
+                escribir_csv(perfil, elegidos.size() == 1 ? csv : conjunto.nombre + "-" + csv);
+            }
+
+            // La clave vuelve a la caché con las hojas ya consumidas
+            if(!obtenida.ruta.empty()) {
+                guardar_clave_cacheada(obtenida.ruta, conjunto, opciones.semilla_claves, *clave,
+                                       obtenida.keygen.segundos, obtenida.keygen.ciclos);
+            }
+
+            if(!perfil.verificada) {
+                ++fallos;
+            }
+        } catch(const std::exception& e) {
+            std::cerr << "Excepción en perfil-xmss(" << conjunto.nombre << "): " << e.what() << "\n";
+            ++fallos;
+        }
+    }
+
+    return fallos == 0 ? 0 : 1;
+}
+
+} // namespace pqbench
@@ -0,0 +1,39 @@
+#ifndef PQBENCH_PERFIL_XMSS_H
+#define PQBENCH_PERFIL_XMSS_H
+
+#include "pqbench.h"
+
+/*
+Perfil de latencia de firma de XMSS a lo largo de la vida de la clave.
+
+La evaluación normal sólo mide la primera firma de una clave recién generada. Un firmador
+real emite miles de firmas con la misma clave, y el coste de cada una puede depender de
+la hoja que se usa (según cómo se recalcule el camino de autenticación). Aquí se firma de
+forma consecutiva con una única XMSS_PrivateKey y se anota la latencia de cada hoja.
+*/
+
+namespace pqbench {
+
+// Latencia de cada firma, en el orden de las hojas
+struct PerfilXMSS {
+    Conjunto conjunto;
+    size_t primera_hoja = 0;
+    size_t hojas_totales = 0;
+    size_t restantes = 0;           // Firmas que le quedan a la clave al terminar
+    std::vector<Medicion> firmas;   // firmas[i] corresponde a la hoja primera_hoja + i
+    bool verificada = false;        // Se verifica la última firma
+};
+
+// Firma `firmas` mensajes seguidos con la clave, empezando en la hoja en la que esté
+PerfilXMSS perfilar_xmss(const Esquema& esquema, Botan::Private_Key& clave, size_t firmas);
+
+/*
+Punto de entrada del modo desde la línea de comandos:
+  ./pqbench perfil-xmss <set XMSS|XMSS> [--desde=hoja] [--firmas=N|todas] [--tramos=32] [--csv=fichero]
+                        [--cache-claves[=d]] [--semilla=N]
+*/
+int ejecutar_perfil_xmss(const Argumentos& args);
+
+} // namespace pqbench
+
+#endif
@@ -0,0 +1,288 @@
+#include "pool_claves.h"
+
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+#include <time.h>
+#include <unistd.h>
+
+namespace pqbench {
+
+std::unique_ptr<ClavePreparada> preparar_clave(const Esquema& esquema) {
+    auto preparada = std::make_unique<ClavePreparada>();
+    preparada->rng = std::make_unique<Botan::AutoSeeded_RNG>();
+    preparada->clave = esquema.generar_clave(*preparada->rng);
+    preparada->signer = std::make_unique<Botan::PK_Signer>(*preparada->clave, *preparada->rng, esquema.padding_firma());
+    return preparada;
+}
+
+static uint64_t nanosegundos_cpu_hilo() {
+    timespec t{};
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return static_cast<uint64_t>(t.tv_sec) * 1000000000u + static_cast<uint64_t>(t.tv_nsec);
+}
+
+// ----- POOL -----
+
+PoolClaves::PoolClaves(const Esquema& esquema, size_t marca_maxima, size_t hilos_relleno) :
+    m_esquema(esquema),
+    m_marca_maxima(std::max<size_t>(marca_maxima, 1)),
+    m_cola(m_marca_maxima) {
+
+    for(size_t h = 0; h < std::max<size_t>(hilos_relleno, 1); ++h) {
+        m_hilos.emplace_back([this] { rellenar(); });
+    }
+}
+
+PoolClaves::~PoolClaves() {
+    m_parar = true;
+    m_avisos++;
+    m_avisos.notify_all();
+    for(auto& hilo : m_hilos) {
+        hilo.join();
+    }
+
+    ClavePreparada* sobrante = nullptr;
+    while(m_cola.sacar(sobrante)) {
+        delete sobrante;
+    }
+}
+
+void PoolClaves::rellenar() {
+    try {
+        while(!m_parar.load()) {
+            /*
+            Se reserva el hueco antes de generar para que varios hilos de relleno no pasen
+            de la marca. Si el pool está lleno se espera a que alguien saque una clave.
+            */
+            uint64_t aviso = m_avisos.load();
+            size_t ocupadas = m_ocupadas.load();
+            if(ocupadas >= m_marca_maxima) {
+                m_avisos.wait(aviso);
+                continue;
+            }
+            if(!m_ocupadas.compare_exchange_weak(ocupadas, ocupadas + 1)) {
+                continue;
+            }
+
+            uint64_t cpu_antes = nanosegundos_cpu_hilo();
+            std::unique_ptr<ClavePreparada> preparada;
+            try {
+                preparada = preparar_clave(m_esquema);
+            } catch(...) {
+                // Se libera el hueco reservado para que no cuente como una clave que va a llegar
+                m_ocupadas--;
+                throw;
+            }
+            m_nanosegundos_cpu += nanosegundos_cpu_hilo() - cpu_antes;
+
+            // Con m_ocupadas <= marca siempre hay sitio en la cola
+            m_cola.meter(preparada.release());
+            m_disponibles++;
+            m_generadas++;
+            m_relleno++;
+            m_relleno.notify_all();
+        }
+    } catch(const std::exception& e) {
+        std::cerr << "Excepción en un hilo de relleno del pool: " << e.what() << "\n";
+        m_fallo_relleno = true;
+        m_relleno++;
+        m_relleno.notify_all();
+    }
+}
+
+std::unique_ptr<ClavePreparada> PoolClaves::adquirir() {
+    ClavePreparada* preparada = nullptr;
+    if(m_cola.sacar(preparada)) {
+        m_disponibles--;
+        m_ocupadas--;
+        m_entregadas++;
+        m_avisos++;
+        m_avisos.notify_one();
+        return std::unique_ptr<ClavePreparada>(preparada);
+    }
+
+    m_inaniciones++;
+    m_entregadas++;
+    return preparar_clave(m_esquema);
+}
+
+void PoolClaves::esperar_lleno() const {
+    for(;;) {
+        uint64_t relleno = m_relleno.load();
+        if(m_fallo_relleno.load()) {
+            throw std::runtime_error("Un hilo de relleno no ha podido preparar una clave: el pool no se llenará");
+        }
+        if(m_disponibles.load() >= m_marca_maxima) {
+            return;
+        }
+        m_relleno.wait(relleno);
+    }
+}
+
+EstadoPool PoolClaves::estado() const {
+    EstadoPool estado;
+    estado.generadas = m_generadas.load();
+    estado.entregadas = m_entregadas.load();
+    estado.inaniciones = m_inaniciones.load();
+    estado.segundos_cpu_relleno = m_nanosegundos_cpu.load() / 1e9;
+    return estado;
+}
+
+// ----- MODO pool-claves -----
+
+// Memoria residente del proceso en bytes, según /proc/self/statm
+static uint64_t memoria_residente() {
+    std::ifstream statm("/proc/self/statm");
+    uint64_t total = 0, residentes = 0;
+    statm >> total >> residentes;
+    return residentes * static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+}
+
+// Resultado de servir peticiones a una tasa fija durante un tiempo
+struct ResultadoPool {
+    double tasa = 0;          // Peticiones por segundo solicitadas
+    double tasa_lograda = 0;
+    Estadisticas adquisicion; // Latencia de adquirir()
+    EstadoPool estado;        // Sólo lo que ha pasado durante la carga
+    double segundos = 0;
+};
+
+/*
+Carga en bucle abierto: la petición i se lanza en el instante i / tasa aunque la anterior
+haya terminado tarde, como llegan las peticiones de clientes independientes. Cada petición
+adquiere una clave y firma el mensaje fijo con ella.
+*/
+static ResultadoPool servir_peticiones(PoolClaves& pool, double tasa, double duracion) {
+    const Botan::secure_vector<uint8_t>& msg = mensaje_fijo();
+
+    ResultadoPool resultado;
+    resultado.tasa = tasa;
+    EstadoPool antes = pool.estado();
+
+    std::vector<double> latencias;
+    auto inicio = std::chrono::steady_clock::now();
+    auto periodo = std::chrono::duration<double>(1.0 / tasa);
+    auto fin = inicio + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(duracion));
+
+    for(size_t i = 0;; ++i) {
+        auto llegada = inicio + std::chrono::duration_cast<std::chrono::steady_clock::duration>(periodo * i);
+        if(llegada >= fin) {
+            break;
+        }
+        std::this_thread::sleep_until(llegada);
+
+        std::unique_ptr<ClavePreparada> preparada;
+        latencias.push_back(medir([&] { preparada = pool.adquirir(); }).segundos);
+        preparada->signer->sign_message(msg, *preparada->rng);
+    }
+
+    resultado.segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    resultado.tasa_lograda = latencias.size() / resultado.segundos;
+    resultado.adquisicion = calcular_estadisticas(std::move(latencias));
+
+    EstadoPool despues = pool.estado();
+    resultado.estado.generadas = despues.generadas - antes.generadas;
+    resultado.estado.entregadas = despues.entregadas - antes.entregadas;
+    resultado.estado.inaniciones = despues.inaniciones - antes.inaniciones;
+    resultado.estado.segundos_cpu_relleno = despues.segundos_cpu_relleno - antes.segundos_cpu_relleno;
+    return resultado;
+}
+
+static void imprimir_pool(const std::vector<ResultadoPool>& resultados, double keygen, std::ostream& salida) {
+    salida << std::setw(10) << "Tasa" << std::setw(10) << "Lograda" << std::setw(14) << "Adq. p50 (s)"
+           << std::setw(14) << "Adq. p99 (s)" << std::setw(14) << "Adq. máx (s)" << std::setw(14) << "Oculto p50"
+           << std::setw(13) << "Inaniciones" << std::setw(16) << "CPU relleno (s)" << std::setw(11) << "% núcleo" << "\n";
+
+    for(const auto& r : resultados) {
+        double inanicion = r.estado.entregadas > 0 ? 100.0 * r.estado.inaniciones / r.estado.entregadas : 0;
+
+        salida << std::setw(10) << r.tasa << std::setw(10) << std::fixed << std::setprecision(1) << r.tasa_lograda
+               << std::defaultfloat << std::setprecision(6)
+               << std::setw(14) << r.adquisicion.mediana << std::setw(14) << r.adquisicion.p99 << std::setw(14) << r.adquisicion.max
+               << std::setw(13) << std::fixed << std::setprecision(1) << 100 * (1 - r.adquisicion.mediana / keygen) << "%"
+               << std::setw(6) << r.estado.inaniciones << " (" << std::setw(4) << inanicion << "%)"
+               << std::setw(16) << std::setprecision(3) << r.estado.segundos_cpu_relleno
+               << std::setw(10) << std::setprecision(1) << 100 * r.estado.segundos_cpu_relleno / r.segundos << "%"
+               << std::defaultfloat << std::setprecision(6) << "\n";
+    }
+}
+
+int ejecutar_pool_claves(const Argumentos& args) {
+    if(args.posicionales().size() != 1) {
+        std::cerr << "Uso: ./pqbench pool-claves <set|familia|todos> [--tasas=10,100,1000] [--duracion=2] [--marca=64]"
+                     " [--hilos-relleno=1] [--prehash]\n";
+        return 1;
+    }
+
+    std::vector<long> tasas = args.enteros("tasas", {10, 100, 1000});
+    double duracion = args.real("duracion", 2.0);
+    long marca = args.entero("marca", 64);
+    long hilos_relleno = args.entero("hilos-relleno", 1);
+
+    if(duracion <= 0 || marca < 1 || hilos_relleno < 1 || std::any_of(tasas.begin(), tasas.end(), [](long t) { return t < 1; })) {
+        std::cerr << "Opciones inválidas para el modo pool-claves.\n";
+        return 1;
+    }
+
+    std::vector<Conjunto> elegidos = seleccionar(args.posicionales()[0], args.activa("prehash"));
+    if(elegidos.empty()) {
+        std::cerr << "Set de parámetros inválido.\n";
+        return 1;
+    }
+
+    int fallos = 0;
+    for(const auto& conjunto : elegidos) {
+        // Una clave de XMSS no es efímera: su keygen no se puede esconder por petición
+        if(conjunto.familia == Familia::XMSS) {
+            std::cout << "Se omite " << conjunto.nombre << ": el pool es para claves efímeras de ML-DSA y SLH-DSA.\n\n";
+            continue;
+        }
+
+        try {
+            auto esquema = crear_esquema(conjunto);
+
+            // Lo que cuesta una petición sin pool: keygen y firmador en frío
+            std::vector<double> frio;
+            for(int i = 0; i < 5; ++i) {
+                frio.push_back(medir([&] { preparar_clave(*esquema); }).segundos);
+            }
+            double keygen = calcular_estadisticas(std::move(frio)).mediana;
+            size_t bytes_clave = preparar_clave(*esquema)->clave->private_key_bits().size();
+
+            std::cout << "POOL DE CLAVES DE " << conjunto.nombre << (conjunto.prehash ? " (pre-hash)" : "")
+                      << " | marca máxima " << marca << " | " << hilos_relleno << " hilos de relleno | "
+                      << duracion << " s por tasa\n"
+                      << "Keygen + firmador en frío (p50): " << keygen << " s\n";
+
+            std::vector<ResultadoPool> resultados;
+            for(long tasa : tasas) {
+                // Un pool nuevo por tasa, lleno antes de empezar, para que las tasas no se afecten entre sí
+                uint64_t memoria_antes = memoria_residente();
+                PoolClaves pool(*esquema, marca, hilos_relleno);
+                pool.esperar_lleno();
+                uint64_t memoria_lleno = memoria_residente();
+
+                if(resultados.empty()) {
+                    uint64_t memoria = memoria_lleno > memoria_antes ? memoria_lleno - memoria_antes : 0;
+                    std::cout << "Memoria del pool lleno: " << formatear_bytes(memoria) << " (~"
+                              << formatear_bytes(memoria / marca) << " por clave; clave privada serializada: "
+                              << formatear_bytes(bytes_clave) << ")\n";
+                }
+
+                resultados.push_back(servir_peticiones(pool, tasa, duracion));
+            }
+
+            imprimir_pool(resultados, keygen, std::cout);
+            std::cout << "\n";
+        } catch(const std::exception& e) {
+            std::cerr << "Excepción en pool-claves(" << conjunto.nombre << "): " << e.what() << "\n";
+            ++fallos;
+        }
+    }
+
+    return fallos == 0 ? 0 : 1;
+}
+
+} // namespace pqbench
@@ -0,0 +1,168 @@
+#ifndef PQBENCH_POOL_CLAVES_H
+#define PQBENCH_POOL_CLAVES_H
+
+#include "pqbench.h"
+
+#include <atomic>
+#include <thread>
+
+/*
+Pool de claves efímeras generadas en segundo plano.
+
+Cuando cada petición usa una clave de ML-DSA o SLH-DSA nueva, el keygen está en el camino
+de la petición. El pool la saca de ahí: unos hilos de relleno generan claves (con su
+PK_Signer ya construido) hasta una marca máxima, y quien atiende la petición sólo tiene
+que sacar una de una cola sin bloqueos. Si la cola está vacía se produce una inanición:
+la clave se genera en primer plano y la petición paga el keygen completo.
+*/
+
+namespace pqbench {
+
+/*
+Cola acotada de varios productores y varios consumidores sin bloqueos (algoritmo de
+D. Vyukov). Cada celda lleva un número de secuencia que indica si está libre para el
+productor o lista para el consumidor de esa vuelta, así que meter y sacar sólo necesitan
+un compare_exchange sobre la posición.
+*/
+template<typename T>
+class ColaSinBloqueo {
+public:
+    // La capacidad se redondea a la siguiente potencia de dos
+    explicit ColaSinBloqueo(size_t capacidad) {
+        size_t tam = 1;
+        while(tam < capacidad) {
+            tam <<= 1;
+        }
+        m_mascara = tam - 1;
+        m_celdas = std::vector<Celda>(tam);
+        for(size_t i = 0; i < tam; ++i) {
+            m_celdas[i].secuencia.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool meter(T valor) {
+        size_t pos = m_cola.load(std::memory_order_relaxed);
+        for(;;) {
+            Celda& celda = m_celdas[pos & m_mascara];
+            size_t secuencia = celda.secuencia.load(std::memory_order_acquire);
+            intptr_t diferencia = static_cast<intptr_t>(secuencia) - static_cast<intptr_t>(pos);
+
+            if(diferencia == 0) {
+                if(m_cola.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    celda.valor = std::move(valor);
+                    celda.secuencia.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if(diferencia < 0) {
+                return false; // Llena
+            } else {
+                pos = m_cola.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool sacar(T& valor) {
+        size_t pos = m_cabeza.load(std::memory_order_relaxed);
+        for(;;) {
+            Celda& celda = m_celdas[pos & m_mascara];
+            size_t secuencia = celda.secuencia.load(std::memory_order_acquire);
+            intptr_t diferencia = static_cast<intptr_t>(secuencia) - static_cast<intptr_t>(pos + 1);
+
+            if(diferencia == 0) {
+                if(m_cabeza.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    valor = std::move(celda.valor);
+                    celda.secuencia.store(pos + m_mascara + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if(diferencia < 0) {
+                return false; // Vacía
+            } else {
+                pos = m_cabeza.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t capacidad() const { return m_mascara + 1; }
+
+private:
+    struct Celda {
+        std::atomic<size_t> secuencia{0};
+        T valor{};
+    };
+
+    std::vector<Celda> m_celdas;
+    size_t m_mascara = 0;
+    // En líneas de caché distintas para que productores y consumidores no se estorben
+    alignas(64) std::atomic<size_t> m_cola{0};
+    alignas(64) std::atomic<size_t> m_cabeza{0};
+};
+
+// Clave lista para firmar: la clave, su RNG y su PK_Signer ya construido
+struct ClavePreparada {
+    std::unique_ptr<Botan::Private_Key> clave;
+    std::unique_ptr<Botan::AutoSeeded_RNG> rng;
+    std::unique_ptr<Botan::PK_Signer> signer;
+};
+
+// Genera una clave y construye su firmador, como haría una petición sin pool
+std::unique_ptr<ClavePreparada> preparar_clave(const Esquema& esquema);
+
+// Contadores del pool desde que se creó
+struct EstadoPool {
+    uint64_t generadas = 0;        // Claves generadas por los hilos de relleno
+    uint64_t entregadas = 0;       // Claves sacadas del pool
+    uint64_t inaniciones = 0;      // Peticiones que encontraron el pool vacío
+    double segundos_cpu_relleno = 0; // Tiempo de CPU de los hilos de relleno
+};
+
+class PoolClaves {
+public:
+    PoolClaves(const Esquema& esquema, size_t marca_maxima, size_t hilos_relleno);
+    ~PoolClaves();
+
+    PoolClaves(const PoolClaves&) = delete;
+    PoolClaves& operator=(const PoolClaves&) = delete;
+
+    /*
+    Devuelve una clave preparada. Nunca bloquea esperando a los hilos de relleno: si el
+    pool está vacío, la genera en el hilo que llama y lo cuenta como inanición.
+    */
+    std::unique_ptr<ClavePreparada> adquirir();
+
+    // Espera hasta que el pool llega a la marca máxima; lanza una excepción si falla un hilo de relleno
+    void esperar_lleno() const;
+
+    size_t disponibles() const { return m_disponibles.load(); }
+    EstadoPool estado() const;
+
+private:
+    void rellenar();
+
+    const Esquema& m_esquema;
+    size_t m_marca_maxima;
+    ColaSinBloqueo<ClavePreparada*> m_cola;
+    std::atomic<size_t> m_disponibles{0};
+    std::atomic<size_t> m_ocupadas{0}; // Claves en la cola más las que se están generando
+    std::atomic<uint64_t> m_avisos{0}; // Cambia con cada clave entregada para despertar a los hilos de relleno
+    std::atomic<uint64_t> m_relleno{0}; // Cambia con cada clave generada o fallo de relleno para despertar a esperar_lleno()
+    std::atomic<bool> m_fallo_relleno{false};
+    std::atomic<bool> m_parar{false};
+
+    std::atomic<uint64_t> m_generadas{0};
+    std::atomic<uint64_t> m_entregadas{0};
+    std::atomic<uint64_t> m_inaniciones{0};
+    std::atomic<uint64_t> m_nanosegundos_cpu{0};
+
+    std::vector<std::thread> m_hilos;
+};
+
+/*
+Punto de entrada del modo desde la línea de comandos:
+  ./pqbench pool-claves <set|familia|todos> [--tasas=10,100,1000] [--duracion=2] [--marca=64]
+                        [--hilos-relleno=1] [--prehash]
+*/
+int ejecutar_pool_claves(const Argumentos& args);
+
+} // namespace pqbench
+
+#endif
@@ -0,0 +1,235 @@
+#include "pqbench.h"
+#include "barrido.h"
+#include "cache_fria.h"
+#include "cache_verificadores.h"
+#include "comparar.h"
+#include "coste_rng.h"
+#include "cpu.h"
+#include "estado_xmss.h"
+#include "fichero.h"
+#include "keygen_hilos.h"
+#include "lote.h"
+#include "perfil_xmss.h"
+#include "pool_claves.h"
+#include "resultado_json.h"
+#include "serializacion.h"
+#include "servicio.h"
+#include "throughput.h"
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace pqbench;
+
+// Pide por consola el set de parámetros a evaluar
+static std::vector<Conjunto> modo_interactivo() {
+    const auto& sets = conjuntos();
+
+    std::cout << "\nElige uno de los sets de parámetros:\n";
+    for(size_t i = 0; i < sets.size(); ++i) {
+        std::cout << "  " << i << ") " << sets[i].nombre << "\n";
+    }
+    std::cout << "> ";
+    int choice = 0;
+    std::cin >> choice;
+
+    if(choice < 0 || static_cast<size_t>(choice) >= sets.size()) {
+        std::cerr << "Opción inválida\n";
+        return {};
+    }
+
+    Conjunto elegido = sets[choice];
+
+    // El pre-hash sólo está disponible en SLH-DSA
+    if(elegido.familia == Familia::SLH_DSA) {
+        std::cout << "¿Deseas usar prehash?\n  0) No\n  1) Sí\n> ";
+        int opt = 0;
+        std::cin >> opt;
+        elegido.prehash = (opt == 1);
+    }
+
+    return {elegido};
+}
+
+// Modos de ejecución adicionales: ./pqbench <modo> ...
+struct Modo {
+    const char* nombre;
+    const char* descripcion;
+    int (*ejecutar)(const Argumentos& args);
+};
+
+static const std::vector<Modo> modos = {
+    {"throughput", "Firmas/verificaciones por segundo con 1..N hilos", ejecutar_throughput},
+    {"lote", "Verificación por lotes agrupada por clave pública", ejecutar_lote},
+    {"barrido", "Firma y verificación por bloques de mensajes de 1 B a 2^N B", ejecutar_barrido},
+    {"firmar-fichero", "Firma un fichero con mmap y con read() y guarda la firma separada", ejecutar_firmar_fichero},
+    {"verificar-fichero", "Verifica la firma separada de un fichero con mmap y con read()", ejecutar_verificar_fichero},
+    {"perfil-xmss", "Latencia de cada firma XMSS a lo largo de las hojas de una clave", ejecutar_perfil_xmss},
+    {"estado-xmss", "Firma XMSS con el índice persistido y reservas de K hojas por fsync", ejecutar_estado_xmss},
+    {"keygen-hilos", "Escalado de la generación de claves XMSS con el número de hilos de Botan", ejecutar_keygen_hilos},
+    {"pool-claves", "Claves efímeras generadas en segundo plano y latencia de adquirirlas", ejecutar_pool_claves},
+    {"servidor", "Servicio de firma y verificación sobre un socket Unix", ejecutar_servidor},
+    {"cliente", "Generador de carga para el servicio de firma", ejecutar_cliente},
+    {"cache-verificadores", "Caché CLOCK de verificadores con firmantes de popularidad Zipf", ejecutar_cache_verificadores},
+    {"serializacion", "Arranque en frío: codificar y cargar claves en crudo, DER y PEM", ejecutar_serializacion},
+    {"rng", "Coste del RNG en keygen y firma: fuentes de RNG y firma hedged frente a determinista", ejecutar_coste_rng},
+    {"cpu", "Características de la CPU que usa Botan y ablación de AVX2, SHA-NI, etc.", ejecutar_cpu},
+    {"cache-fria", "Latencia con las cachés frías (buffer mayor que la LLC y clflush) frente a calientes", ejecutar_cache_fria},
+    {"comparar", "Regresiones de rendimiento frente a unos resultados de referencia (*-Resultados.csv)", ejecutar_comparar},
+};
+
+static void uso() {
+    std::cerr << "Uso:\n"
+              << "  Modo interactivo: ./pqbench\n"
+              << "  Modo automático:  ./pqbench <set_de_parametros|ML-DSA|SLH-DSA|XMSS|todos> [--prehash]\n"
+              << "  Listar sets:      ./pqbench --listar\n"
+              << "Opciones de medición:\n"
+              << "  --iteraciones=N     Muestras medidas de cada operación (por defecto 1)\n"
+              << "  --calentamiento=N   Ejecuciones previas sin medir (por defecto 0)\n"
+              << "  --outliers[=k]      Descarta atípicos a más de k MAD de la mediana (k = 3.5)\n"
+              << "  --reutilizar        Mide también la verificación con un verificador ya construido\n"
+              << "  --contadores        Registra contadores hardware por fase (perf_event_open)\n"
+              << "  --energia[=s]       Energía por operación con RAPL, repitiendo cada una s segundos (0.2)\n"
+              << "  --nucleo=N          Fija el proceso al núcleo N (sched_setaffinity)\n"
+              << "  --prioridad=nice|fifo  Sube la prioridad del proceso (necesita CAP_SYS_NICE)\n"
+              << "  --estricto          Falla si la máquina está cargada o la frecuencia no es estable\n"
+              << "  --json              Un objeto JSON por set en stdout; el resto de la salida va a stderr\n"
+              << "Otros modos: ./pqbench <modo> ...\n";
+    for(const auto& modo : modos) {
+        std::cerr << "  " << std::left << std::setw(20) << modo.nombre << std::right << modo.descripcion << "\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    /*
+    DOS POSIBLES USOS DEL PROGRAMA:
+    [1] -> Pasando el set de parámetros (o una familia, o "todos") como argumento:
+            ./pqbench NOMBRE_SET [--prehash]
+            Ejemplos:
+            ./pqbench ML-DSA-4x4
+            ./pqbench SLH-DSA-SHA2-128s --prehash
+            ./pqbench todos
+
+    [2] -> Modo interactivo si no se pasa ningún argumento:
+            ./pqbench
+    */
+
+    // Si el primer argumento es un modo, el resto de argumentos son suyos
+    if(argc >= 2) {
+        for(const auto& modo : modos) {
+            if(argv[1] == std::string(modo.nombre)) {
+                try {
+                    imprimir_contador(std::cout);
+                    return modo.ejecutar(Argumentos(argc, argv, 2));
+                } catch(const std::exception& e) {
+                    std::cerr << e.what() << "\n";
+                    return 1;
+                }
+            }
+        }
+    }
+
+    std::vector<Conjunto> elegidos;
+    Opciones opciones;
+
+    try {
+        Argumentos args(argc, argv);
+
+        if(args.activa("listar")) {
+            for(const auto& conjunto : conjuntos()) {
+                std::cout << conjunto.nombre << "\n";
+            }
+            return 0;
+        }
+
+        opciones = leer_opciones(args);
+
+        if(argc == 1) {
+            elegidos = modo_interactivo();
+            if(elegidos.empty()) {
+                return 1;
+            }
+        } else if(args.posicionales().size() == 1) {
+            elegidos = seleccionar(args.posicionales()[0], args.activa("prehash"));
+            if(elegidos.empty()) {
+                std::cerr << "Set de parámetros inválido.\n";
+                return 1;
+            }
+        } else {
+            std::cerr << "Uso incorrecto.\n";
+            uso();
+            return 1;
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        uso();
+        return 1;
+    }
+
+    // Con --json stdout sólo lleva las líneas JSON; la información de contexto va a stderr
+    std::ostream& informe = opciones.json ? std::cerr : std::cout;
+
+    // Se calibra el contador de ciclos antes de la primera medición
+    imprimir_contador(informe);
+    imprimir_caracteristicas_cpu(informe);
+
+    if(opciones.contadores_hw) {
+        const ContadoresHW& hw = activar_contadores_hw();
+        if(!hw.motivo().empty()) {
+            std::cerr << "[!] Contadores hardware no disponibles: " << hw.motivo() << "\n";
+        }
+    }
+
+    if(opciones.energia) {
+        const ContadoresEnergia& energia = activar_energia();
+        if(!energia.disponible()) {
+            std::cerr << "[!] Energía no disponible: " << energia.motivo() << "\n";
+        } else {
+            informe << "Potencia del paquete en reposo: " << potencia_reposo() << " W\n\n";
+        }
+    }
+
+    if(opciones.memoria && !activar_contabilidad_memoria()) {
+        std::cerr << "[!] No se puede reiniciar el pico de RSS entre fases: se muestra el pico acumulado del proceso\n";
+    }
+
+    // Con --estricto no se empieza a medir en una máquina ruidosa
+    auto avisos = avisos_entorno(leer_entorno(), opciones.carga_maxima);
+    for(const auto& aviso : avisos) {
+        std::cerr << "[!] Entorno ruidoso: " << aviso << "\n";
+    }
+    if(opciones.estricto && !avisos.empty()) {
+        std::cerr << "Se cancela la evaluación (--estricto).\n";
+        return 1;
+    }
+
+    // Se evalúan todos los sets elegidos en el mismo proceso
+    int fallos = 0;
+    for(size_t i = 0; i < elegidos.size(); ++i) {
+        if(i > 0 && !opciones.json) {
+            std::cout << "\n\n";
+        }
+
+        try {
+            auto esquema = crear_esquema(elegidos[i]);
+            Resultado resultado = evaluar(*esquema, opciones);
+            if(opciones.json) {
+                imprimir_json(resultado, std::cout);
+            } else {
+                imprimir(resultado, std::cout);
+            }
+
+            if(!resultado.verificada || (opciones.estricto && !resultado.avisos_entorno.empty())) {
+                ++fallos;
+            }
+        } catch(const std::exception& e) {
+            std::cerr << "Excepción en evaluar(" << elegidos[i].nombre << "): " << e.what() << "\n";
+            ++fallos;
+        }
+    }
+
+    return fallos == 0 ? 0 : 1;
+}
@@ -0,0 +1,429 @@
+#ifndef PQBENCH_H
+#define PQBENCH_H
+
+#include <botan/auto_rng.h>
+#include <botan/pubkey.h>
+#include <botan/dilithium.h>
+#include <botan/slh_dsa.h>
+#include <botan/sp_parameters.h>
+#include <botan/xmss.h>
+#include "aleatoriedad.h"
+#include "ciclos.h"
+#include "energia.h"
+#include "entorno.h"
+#include "estadisticas.h"
+#include "memoria.h"
+#include "perf.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+/*
+Arnés común de evaluación de rendimiento de los esquemas de firma post-cuánticos.
+
+Todos los esquemas (ML-DSA, SLH-DSA y XMSS) se miden con la misma metodología: el
+código específico de cada esquema se limita a un Adaptador (definido en ml-dsa.cpp,
+slh-dsa.cpp y xmss.cpp) y el resto del proceso (medición, firmador, verificador,
+impresión de resultados) es compartido.
+*/
+
+namespace pqbench {
+
+// ---------------------- CONJUNTOS DE PARÁMETROS ----------------------
+
+// Familias de esquemas evaluados
+enum class Familia { ML_DSA, SLH_DSA, XMSS };
+
+std::string nombre_familia(Familia familia);
+
+// Conjunto de parámetros a evaluar
+struct Conjunto {
+    std::string nombre;     // Nombre base del set, p. ej. "SLH-DSA-SHA2-128s"
+    Familia familia;
+    bool prehash = false;   // Sólo tiene efecto en SLH-DSA
+};
+
+// Los 27 sets de parámetros disponibles (3 ML-DSA, 12 SLH-DSA y 12 XMSS)
+const std::vector<Conjunto>& conjuntos();
+
+/*
+Devuelve los sets que corresponden a un nombre pasado por línea de comandos:
+- "todos": todos los sets
+- "ML-DSA", "SLH-DSA" o "XMSS": todos los sets de esa familia
+- El nombre de un set concreto
+Si el nombre no corresponde a nada, devuelve un vector vacío.
+*/
+std::vector<Conjunto> seleccionar(const std::string& nombre, bool prehash);
+
+// Set con exactamente ese nombre (p. ej. leído de un fichero); lanza una excepción si no existe
+Conjunto buscar_conjunto(const std::string& nombre, bool prehash);
+
+// ---------------------- MEDICIONES ----------------------
+
+// Tiempo de ejecución y ciclos de CPU de una operación
+struct Medicion {
+    double segundos = 0;
+    uint64_t ciclos = 0; // Ciclos de referencia (TSC) sin la sobrecarga del contador
+    bool con_eventos = false;
+    LecturaHW eventos{}; // Contadores hardware, si están activos
+    bool con_memoria = false;
+    LecturaMemoria memoria{}; // Contabilidad de memoria, si está activa
+    LecturaRNG rng{};         // Llamadas al RNG hechas por el hilo que mide
+};
+
+/*
+Mide el tiempo y los ciclos que tarda en ejecutarse f. Si los contadores hardware están
+activos, se leen fuera de la ventana del TSC para no sumar su coste a los ciclos. Con la
+contabilidad de memoria activa, el relleno de la pila y las lecturas de /proc también
+quedan fuera, pero el coste de anotar cada reserva sí entra en el tiempo medido. El
+tiempo pasado dentro del RNG se obtiene del acumulado de RNGMedido y forma parte del total.
+*/
+template<typename F>
+Medicion medir(F&& f) {
+    const ContadoresHW* hw = contadores_hw();
+    bool memoria = contabilidad_memoria_activa();
+    if(memoria) {
+        empezar_fase_memoria();
+    }
+
+    LecturaHW eventos_antes{};
+    if(hw) {
+        eventos_antes = hw->leer();
+    }
+
+    LecturaRNG rng_antes = lectura_rng();
+    auto inicio = std::chrono::steady_clock::now();
+    auto ciclos_antes = ciclos_inicio();
+
+    f();
+
+    auto ciclos_despues = ciclos_fin();
+    auto fin = std::chrono::steady_clock::now();
+
+    Medicion medicion{std::chrono::duration<double>(fin - inicio).count(), restar_sobrecarga(ciclos_despues - ciclos_antes)};
+    medicion.rng = lectura_rng() - rng_antes;
+
+    if(hw) {
+        LecturaHW eventos_despues = hw->leer();
+        medicion.con_eventos = true;
+        for(size_t i = 0; i < NUM_EVENTOS_HW; ++i) {
+            medicion.eventos[i] = eventos_despues[i] - eventos_antes[i];
+        }
+    }
+
+    if(memoria) {
+        medicion.con_memoria = true;
+        medicion.memoria = terminar_fase_memoria();
+    }
+
+    return medicion;
+}
+
+// Opciones de medición comunes a todas las evaluaciones
+struct Opciones {
+    size_t iteraciones = 1;     // Muestras medidas de cada operación
+    size_t calentamiento = 0;   // Ejecuciones previas de cada operación que no se miden
+    double umbral_outliers = 0; // Umbral MAD para descartar valores atípicos (0 = no se descartan)
+    bool reutilizar_verificador = false; // Mide también la verificación con un PK_Verifier ya construido
+    bool contadores_hw = false;          // Registra los contadores hardware con perf_event_open
+    std::string cache_claves;            // Directorio de la caché de claves ("" = sin caché)
+    bool regenerar_claves = false;       // Regenera la clave aunque esté en la caché
+    uint64_t semilla_claves = 0;         // Semilla de las claves de la caché
+    bool memoria = false;                // Contabiliza las reservas, el pico del montón, la pila y el RSS de cada fase
+    size_t hilos_botan = 0;              // Tamaño del pool de hilos de Botan (0 = el que decida Botan)
+    FuenteRNG fuente_rng = FuenteRNG::AUTO; // RNG de keygen y firma
+    uint64_t semilla_rng = 0;            // Semilla de las fuentes sembradas
+    bool firma_determinista = false;     // Firma determinista en vez de hedged (ML-DSA y SLH-DSA)
+    std::vector<std::string> desactivar_cpu; // Características de la CPU ocultas a Botan (BOTAN_CLEAR_CPUID)
+    int nucleo = -1;                     // Núcleo al que se fija el proceso (-1 = sin fijar)
+    std::string prioridad;               // "nice" o "fifo" ("" = sin cambiar)
+    double carga_maxima = 1.0;           // Carga media a partir de la cual la máquina se considera ruidosa
+    bool estricto = false;               // Los avisos de ruido del entorno hacen fallar la ejecución
+    bool energia = false;                // Mide la energía de cada operación con RAPL
+    double energia_segundos = 0.2;       // Tiempo mínimo de repetición de cada operación para medir su energía
+    bool json = false;                   // Resultados en JSON lines por stdout y el resto de la salida por stderr
+};
+
+// Muestras de una operación y sus estadísticas
+struct Operacion {
+    std::vector<Medicion> muestras;
+    size_t descartadas = 0;
+    Estadisticas segundos;
+    Estadisticas ciclos;
+    std::array<Estadisticas, NUM_EVENTOS_HW> eventos; // Sólo si las muestras tienen contadores hardware
+    LecturaMemoria memoria;                           // Máximo de cada campo entre las muestras (sólo con --memoria)
+    LecturaRNG rng;                                   // Media por muestra del uso del RNG
+    EnergiaOperacion energia;                         // Medida aparte repitiendo la operación (sólo con --energia)
+
+    /*
+    Calcula las estadísticas de tiempo y ciclos. Los atípicos se detectan sobre el
+    tiempo y se descarta la muestra completa (tiempo y ciclos) para que ambas
+    estadísticas salgan de las mismas ejecuciones.
+    */
+    void resumir(double umbral_outliers);
+};
+
+/*
+Repite en orden las fases indicadas: opciones.calentamiento veces sin medir y después
+opciones.iteraciones veces midiendo cada fase por separado. Sirve para medir
+operaciones que dependen de la anterior (p. ej. preparar el verificador y verificar)
+sin mezclar sus tiempos.
+*/
+template<typename... Fases>
+std::array<Operacion, sizeof...(Fases)> muestrear_fases(const Opciones& opciones, Fases&&... fases) {
+    for(size_t i = 0; i < opciones.calentamiento; ++i) {
+        (fases(), ...);
+    }
+
+    std::array<Operacion, sizeof...(Fases)> operaciones;
+    for(size_t i = 0; i < std::max<size_t>(opciones.iteraciones, 1); ++i) {
+        size_t fase = 0;
+        ((operaciones[fase++].muestras.push_back(medir(fases))), ...);
+    }
+
+    for(auto& operacion : operaciones) {
+        operacion.resumir(opciones.umbral_outliers);
+    }
+    return operaciones;
+}
+
+// Caso de una única fase
+template<typename F>
+Operacion muestrear(const Opciones& opciones, F&& f) {
+    return muestrear_fases(opciones, std::forward<F>(f))[0];
+}
+
+// ---------------------- ADAPTADORES DE ESQUEMA ----------------------
+
+/*
+Cada esquema se describe con una especialización de Adaptador sobre su tipo de
+parámetros de Botan. Las funciones de cada especialización se definen en el
+fichero del esquema correspondiente.
+*/
+template<typename Parametros>
+struct Adaptador;
+
+template<>
+struct Adaptador<Botan::DilithiumMode> {
+    using ClavePrivada = Botan::Dilithium_PrivateKey;
+    using ClavePublica = Botan::Dilithium_PublicKey;
+    static constexpr Familia familia = Familia::ML_DSA;
+    static constexpr const char* padding_firma = "Randomized"; // Versión hedged
+    static constexpr const char* padding_determinista = "Deterministic";
+
+    static std::vector<std::string> nombres();
+    static Botan::DilithiumMode parametros(const Conjunto& conjunto);
+    static std::unique_ptr<ClavePrivada> generar(const Botan::DilithiumMode& parametros, Botan::RandomNumberGenerator& rng);
+    static std::unique_ptr<ClavePublica> cargar_publica(const Botan::DilithiumMode& parametros, std::span<const uint8_t> bits);
+    static std::unique_ptr<ClavePrivada> cargar_privada(const Botan::DilithiumMode& parametros, std::span<const uint8_t> bits);
+    static size_t tam_clave_privada(const ClavePrivada& clave);
+};
+
+template<>
+struct Adaptador<Botan::Sphincs_Parameters> {
+    using ClavePrivada = Botan::SLH_DSA_PrivateKey;
+    using ClavePublica = Botan::SLH_DSA_PublicKey;
+    static constexpr Familia familia = Familia::SLH_DSA;
+    static constexpr const char* padding_firma = "Randomized"; // Versión hedged
+    static constexpr const char* padding_determinista = "Deterministic";
+
+    static std::vector<std::string> nombres();
+    static Botan::Sphincs_Parameters parametros(const Conjunto& conjunto);
+    static std::unique_ptr<ClavePrivada> generar(const Botan::Sphincs_Parameters& parametros, Botan::RandomNumberGenerator& rng);
+    static std::unique_ptr<ClavePublica> cargar_publica(const Botan::Sphincs_Parameters& parametros, std::span<const uint8_t> bits);
+    static std::unique_ptr<ClavePrivada> cargar_privada(const Botan::Sphincs_Parameters& parametros, std::span<const uint8_t> bits);
+    static size_t tam_clave_privada(const ClavePrivada& clave);
+};
+
+template<>
+struct Adaptador<Botan::XMSS_Parameters> {
+    using ClavePrivada = Botan::XMSS_PrivateKey;
+    using ClavePublica = Botan::XMSS_PublicKey;
+    static constexpr Familia familia = Familia::XMSS;
+    static constexpr const char* padding_firma = "";
+    static constexpr const char* padding_determinista = ""; // La firma XMSS no usa el RNG
+
+    static std::vector<std::string> nombres();
+    static Botan::XMSS_Parameters parametros(const Conjunto& conjunto);
+    static std::unique_ptr<ClavePrivada> generar(const Botan::XMSS_Parameters& parametros, Botan::RandomNumberGenerator& rng);
+    static std::unique_ptr<ClavePublica> cargar_publica(const Botan::XMSS_Parameters& parametros, std::span<const uint8_t> bits);
+    static std::unique_ptr<ClavePrivada> cargar_privada(const Botan::XMSS_Parameters& parametros, std::span<const uint8_t> bits);
+    static size_t tam_clave_privada(const ClavePrivada& clave);
+
+    // Índice de la siguiente hoja sin usar
+    static size_t hoja_actual(const Botan::XMSS_Parameters& parametros, const ClavePrivada& clave);
+    // Copia de la clave que continúa firmando desde la hoja indicada, que no puede ser anterior a la actual
+    static std::unique_ptr<ClavePrivada> saltar_a_hoja(const Botan::XMSS_Parameters& parametros, const ClavePrivada& clave, size_t hoja);
+};
+
+// Interfaz común con la que trabaja el arnés, independiente del esquema
+class Esquema {
+public:
+    explicit Esquema(Conjunto conjunto) : m_conjunto(std::move(conjunto)) {}
+    virtual ~Esquema() = default;
+
+    const Conjunto& conjunto() const { return m_conjunto; }
+
+    virtual std::unique_ptr<Botan::Private_Key> generar_clave(Botan::RandomNumberGenerator& rng) const = 0;
+
+    // Reconstruye la clave pública a partir de public_key_bits()
+    virtual std::unique_ptr<Botan::Public_Key> cargar_clave_publica(std::span<const uint8_t> bits) const = 0;
+
+    // Reconstruye la clave privada a partir de private_key_bits(), con su estado si lo tiene
+    virtual std::unique_ptr<Botan::Private_Key> cargar_clave_privada(std::span<const uint8_t> bits) const = 0;
+
+    virtual size_t tam_clave_privada(const Botan::Private_Key& clave) const = 0;
+    virtual std::string padding_firma() const = 0;
+    virtual std::string padding_firma_determinista() const = 0;
+
+    std::string padding_firma(bool determinista) const {
+        return determinista ? padding_firma_determinista() : padding_firma();
+    }
+
+    // El verificador se construye igual para todos los esquemas
+    std::string padding_verificacion() const { return ""; }
+
+private:
+    Conjunto m_conjunto;
+};
+
+// Implementación de Esquema a partir del Adaptador de cada tipo de parámetros
+template<typename Parametros>
+class EsquemaAdaptado final : public Esquema {
+public:
+    using A = Adaptador<Parametros>;
+
+    explicit EsquemaAdaptado(const Conjunto& conjunto) :
+        Esquema(conjunto), m_parametros(A::parametros(conjunto)) {}
+
+    std::unique_ptr<Botan::Private_Key> generar_clave(Botan::RandomNumberGenerator& rng) const override {
+        return A::generar(m_parametros, rng);
+    }
+
+    std::unique_ptr<Botan::Public_Key> cargar_clave_publica(std::span<const uint8_t> bits) const override {
+        return A::cargar_publica(m_parametros, bits);
+    }
+
+    std::unique_ptr<Botan::Private_Key> cargar_clave_privada(std::span<const uint8_t> bits) const override {
+        return A::cargar_privada(m_parametros, bits);
+    }
+
+    size_t tam_clave_privada(const Botan::Private_Key& clave) const override {
+        return A::tam_clave_privada(dynamic_cast<const typename A::ClavePrivada&>(clave));
+    }
+
+    using Esquema::padding_firma;
+    std::string padding_firma() const override { return A::padding_firma; }
+    std::string padding_firma_determinista() const override { return A::padding_determinista; }
+
+    const Parametros& parametros() const { return m_parametros; }
+
+private:
+    Parametros m_parametros;
+};
+
+// Construye el esquema correspondiente al set de parámetros
+std::unique_ptr<Esquema> crear_esquema(const Conjunto& conjunto);
+
+// Acceso a las operaciones propias de XMSS (índice de hoja); lanza una excepción si el esquema no es XMSS
+using EsquemaXMSS = EsquemaAdaptado<Botan::XMSS_Parameters>;
+const EsquemaXMSS& esquema_xmss(const Esquema& esquema);
+
+// ---------------------- EVALUACIÓN ----------------------
+
+// Mismo mensaje de 4 bytes para los 3 algoritmos que evaluamos
+const Botan::secure_vector<uint8_t>& mensaje_fijo();
+
+// Resultados de la evaluación de un set de parámetros
+struct Resultado {
+    Conjunto conjunto;
+    std::string rng;                    // Nombre del RNG utilizado
+    bool firma_determinista = false;
+    Operacion keygen;                   // Clave privada y derivación de la pública
+    Operacion carga_clave;              // Carga de la clave desde la caché (sólo si estaba en ella)
+    bool clave_en_cache = false;        // keygen es el medido al generar la clave en caché
+    Operacion preparacion_firmador;     // Construcción del PK_Signer
+    Operacion firma;
+    Operacion preparacion_verificador;  // Construcción del PK_Verifier
+    Operacion verificacion;             // Primera verificación con un PK_Verifier recién construido
+    Operacion verificacion_reutilizada; // Verificación con un PK_Verifier ya usado (sólo con reutilizar_verificador)
+    size_t tam_clave_publica = 0;
+    size_t tam_clave_privada = 0;
+    size_t tam_firma = 0;
+    bool verificada = false;
+    EntornoEjecucion entorno;           // Al empezar la evaluación
+    EntornoEjecucion entorno_final;     // Al terminarla
+    std::vector<std::string> avisos_entorno;
+};
+
+/*
+Evalúa el tiempo de ejecución y ciclos de CPU consumidos en los tres procesos
+principales de un esquema de firma:
+- Generación de claves
+- Firma de un mensaje
+- Verificación de firma
+
+La construcción del firmador y del verificador se mide aparte, ya que en producción
+se hace una única vez y se reutiliza para muchas firmas. Cada operación se repite
+según las opciones; la firma y la verificación se hacen con la última clave generada.
+*/
+Resultado evaluar(const Esquema& esquema, const Opciones& opciones);
+
+// Imprime los resultados en el formato que lee benchmark.py
+void imprimir(const Resultado& resultado, std::ostream& salida);
+
+// Tamaño en bytes en la unidad binaria más cómoda de leer: 512 B, 64 KiB, 1.5 GiB
+std::string formatear_bytes(uint64_t bytes);
+
+// Texto alineado a la derecha en `ancho` columnas, contando cada carácter UTF-8 como una
+std::string columna(const std::string& texto, size_t ancho);
+
+// ---------------------- LÍNEA DE COMANDOS ----------------------
+
+/*
+Argumentos de línea de comandos. Las opciones tienen la forma --nombre (activa)
+o --nombre=valor; el resto de argumentos se guardan como posicionales.
+*/
+class Argumentos {
+public:
+    Argumentos(int argc, char* argv[], int desde = 1);
+
+    const std::vector<std::string>& posicionales() const { return m_posicionales; }
+
+    bool activa(const std::string& nombre) const;
+    std::string texto(const std::string& nombre, const std::string& defecto) const;
+    long entero(const std::string& nombre, long defecto) const;
+    double real(const std::string& nombre, double defecto) const;
+
+    // Listas separadas por comas, p. ej. --hilos=1,2,4,8
+    std::vector<std::string> textos(const std::string& nombre, const std::vector<std::string>& defecto) const;
+    std::vector<long> enteros(const std::string& nombre, const std::vector<long>& defecto) const;
+
+private:
+    std::vector<std::string> m_posicionales;
+    std::vector<std::pair<std::string, std::string>> m_opciones;
+};
+
+/*
+Lee las opciones de medición:
+  --iteraciones=N     Muestras de cada operación
+  --calentamiento=N   Ejecuciones previas sin medir
+  --outliers[=k]      Descarta atípicos con umbral k (3.5 si no se indica)
+  --reutilizar        Mide también la verificación con un verificador ya construido
+  --contadores        Registra instrucciones, IPC y fallos de caché, salto y TLB (perf_event_open)
+  --cache-claves[=d]  Guarda y reutiliza las claves en el directorio d (.pqbench-claves)
+  --regenerar         Regenera las claves de la caché
+  --semilla=N         Semilla de las claves de la caché (0 por defecto)
+  --json              Un objeto JSON por set en stdout (ver resultado_json.h)
+*/
+Opciones leer_opciones(const Argumentos& args);
+
+} // namespace pqbench
+
+#endif
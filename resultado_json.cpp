@@ -0,0 +1,249 @@
+#include "resultado_json.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+namespace pqbench {
+
+std::string cadena_json(const std::string& texto) {
+    std::string cadena = "\"";
+    for(char c : texto) {
+        switch(c) {
+            case '"': cadena += "\\\""; break;
+            case '\\': cadena += "\\\\"; break;
+            case '\n': cadena += "\\n"; break;
+            case '\t': cadena += "\\t"; break;
+            default:
+                // El resto de caracteres de control van como \u00XX; UTF-8 se deja tal cual
+                if(static_cast<unsigned char>(c) < 0x20) {
+                    char escape[8];
+                    std::snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned char>(c));
+                    cadena += escape;
+                } else {
+                    cadena += c;
+                }
+        }
+    }
+    return cadena + "\"";
+}
+
+ObjetoJSON& ObjetoJSON::crudo(const std::string& clave, const std::string& valor) {
+    if(!m_campos.empty()) {
+        m_campos += ",";
+    }
+    m_campos += cadena_json(clave) + ":" + valor;
+    return *this;
+}
+
+ObjetoJSON& ObjetoJSON::numero(const std::string& clave, double valor) {
+    if(!std::isfinite(valor)) {
+        return nulo(clave);
+    }
+
+    // Con max_digits10 el valor se lee de vuelta sin perder precisión
+    std::ostringstream texto;
+    texto << std::setprecision(std::numeric_limits<double>::max_digits10) << valor;
+    return crudo(clave, texto.str());
+}
+
+ObjetoJSON& ObjetoJSON::entero(const std::string& clave, uint64_t valor) {
+    return crudo(clave, std::to_string(valor));
+}
+
+ObjetoJSON& ObjetoJSON::logico(const std::string& clave, bool valor) {
+    return crudo(clave, valor ? "true" : "false");
+}
+
+ObjetoJSON& ObjetoJSON::texto(const std::string& clave, const std::string& valor) {
+    return crudo(clave, cadena_json(valor));
+}
+
+ObjetoJSON& ObjetoJSON::objeto(const std::string& clave, const ObjetoJSON& valor) {
+    return crudo(clave, valor.str());
+}
+
+ObjetoJSON& ObjetoJSON::textos(const std::string& clave, const std::vector<std::string>& valores) {
+    std::string lista = "[";
+    for(size_t i = 0; i < valores.size(); ++i) {
+        lista += (i > 0 ? "," : "") + cadena_json(valores[i]);
+    }
+    return crudo(clave, lista + "]");
+}
+
+ObjetoJSON& ObjetoJSON::nulo(const std::string& clave) {
+    return crudo(clave, "null");
+}
+
+static ObjetoJSON estadisticas_json(const Estadisticas& e) {
+    ObjetoJSON objeto;
+    objeto.numero("min", e.min)
+          .numero("mediana", e.mediana)
+          .numero("media", e.media)
+          .numero("desviacion", e.desviacion)
+          .numero("p90", e.p90)
+          .numero("p99", e.p99)
+          .numero("max", e.max);
+    return objeto;
+}
+
+// Misma información que imprime imprimir() para cada fase, con las mismas condiciones
+static ObjetoJSON operacion_json(const Operacion& operacion) {
+    ObjetoJSON objeto;
+    objeto.entero("muestras", operacion.muestras.size())
+          .entero("descartadas", operacion.descartadas)
+          .objeto("segundos", estadisticas_json(operacion.segundos))
+          .objeto("ciclos", estadisticas_json(operacion.ciclos));
+
+    if(contador().ratio_nucleo > 0) {
+        objeto.numero("ciclos_nucleo", a_ciclos_nucleo(operacion.ciclos.mediana));
+    } else {
+        objeto.nulo("ciclos_nucleo");
+    }
+
+    const ContadoresHW* hw = contadores_hw();
+    if(hw && !operacion.muestras.empty() && operacion.muestras[0].con_eventos) {
+        // Las claves son las mismas que los sufijos de las columnas del CSV de benchmark.py
+        static const std::pair<size_t, const char*> claves[] = {
+            {HW_INSTRUCCIONES, "instrucciones"}, {HW_FALLOS_L1D, "fallos_L1d"}, {HW_FALLOS_LLC, "fallos_LLC"},
+            {HW_FALLOS_SALTO, "fallos_salto"}, {HW_FALLOS_DTLB, "fallos_dTLB"}};
+
+        ObjetoJSON eventos;
+        for(const auto& [evento, clave] : claves) {
+            if(hw->disponible(evento)) {
+                eventos.numero(clave, operacion.eventos[evento].mediana);
+            } else {
+                eventos.nulo(clave);
+            }
+        }
+        if(hw->disponible(HW_INSTRUCCIONES) && hw->disponible(HW_CICLOS) && operacion.eventos[HW_CICLOS].mediana > 0) {
+            eventos.numero("IPC", operacion.eventos[HW_INSTRUCCIONES].mediana / operacion.eventos[HW_CICLOS].mediana);
+        } else {
+            eventos.nulo("IPC");
+        }
+        objeto.objeto("hw", eventos);
+    }
+
+    if(!operacion.muestras.empty() && operacion.muestras[0].con_memoria) {
+        const LecturaMemoria& m = operacion.memoria;
+        objeto.objeto("memoria", ObjetoJSON()
+            .entero("reservas", m.reservas)
+            .entero("bytes_reservados", m.bytes_reservados)
+            .entero("pico_monton", m.pico_monton)
+            .entero("pila", m.pila)
+            .entero("pico_rss", m.pico_rss));
+    }
+
+    if(operacion.rng.llamadas > 0) {
+        objeto.objeto("rng", ObjetoJSON()
+            .numero("llamadas", operacion.rng.llamadas)
+            .numero("bytes", operacion.rng.bytes)
+            .numero("segundos", operacion.rng.segundos));
+    }
+
+    const EnergiaOperacion& e = operacion.energia;
+    if(e.repeticiones > 0) {
+        ObjetoJSON energia;
+        energia.entero("repeticiones", e.repeticiones)
+               .numero("segundos", e.segundos)
+               .numero("julios", e.julios_paquete);
+        if(contadores_energia()->disponible_nucleo()) {
+            energia.numero("julios_nucleo", e.julios_nucleo);
+        } else {
+            energia.nulo("julios_nucleo");
+        }
+        if(e.julios_paquete > 0) {
+            energia.numero("ops_por_julio", 1 / e.julios_paquete);
+        } else {
+            energia.nulo("ops_por_julio");
+        }
+        objeto.objeto("energia", energia);
+    }
+
+    return objeto;
+}
+
+static ObjetoJSON entorno_json(const EntornoEjecucion& entorno, double frecuencia_final_mhz) {
+    ObjetoJSON objeto;
+    objeto.texto("maquina", entorno.maquina)
+          .numero("nucleo", entorno.nucleo)
+          .logico("fijado", entorno.fijado)
+          .texto("prioridad", entorno.prioridad)
+          .texto("gobernador", entorno.gobernador)
+          .texto("turbo", entorno.turbo)
+          .texto("smt", entorno.smt)
+          .texto("hermanos_smt", entorno.hermanos);
+
+    auto mhz = [&](const char* clave, double valor) {
+        if(valor > 0) {
+            objeto.numero(clave, valor);
+        } else {
+            objeto.nulo(clave);
+        }
+    };
+    mhz("frecuencia_inicial_mhz", entorno.frecuencia_mhz);
+    mhz("frecuencia_final_mhz", frecuencia_final_mhz);
+
+    if(entorno.carga >= 0) {
+        objeto.numero("carga", entorno.carga);
+    } else {
+        objeto.nulo("carga");
+    }
+    return objeto;
+}
+
+void imprimir_json(const Resultado& resultado, std::ostream& salida) {
+    const Conjunto& conjunto = resultado.conjunto;
+
+    ObjetoJSON objeto;
+    objeto.entero("version_esquema", VERSION_ESQUEMA_JSON)
+          .texto("parametro", conjunto.nombre)
+          .texto("familia", nombre_familia(conjunto.familia));
+    if(conjunto.familia == Familia::SLH_DSA) {
+        objeto.logico("prehash", conjunto.prehash);
+    } else {
+        objeto.nulo("prehash");
+    }
+    objeto.texto("rng", resultado.rng)
+          .logico("firma_determinista", resultado.firma_determinista)
+          .logico("verificada", resultado.verificada)
+          .logico("clave_en_cache", resultado.clave_en_cache)
+          .entero("tam_clave_publica", resultado.tam_clave_publica)
+          .entero("tam_clave_privada", resultado.tam_clave_privada)
+          .entero("tam_firma", resultado.tam_firma);
+
+    ObjetoJSON operaciones;
+    operaciones.objeto("keygen", operacion_json(resultado.keygen));
+    if(resultado.clave_en_cache) {
+        operaciones.objeto("carga_clave", operacion_json(resultado.carga_clave));
+    } else {
+        operaciones.nulo("carga_clave");
+    }
+    operaciones.objeto("preparacion_firmador", operacion_json(resultado.preparacion_firmador))
+               .objeto("firma", operacion_json(resultado.firma))
+               .objeto("preparacion_verificador", operacion_json(resultado.preparacion_verificador))
+               .objeto("verificacion", operacion_json(resultado.verificacion));
+    if(!resultado.verificacion_reutilizada.muestras.empty()) {
+        operaciones.objeto("verificacion_reutilizada", operacion_json(resultado.verificacion_reutilizada));
+    } else {
+        operaciones.nulo("verificacion_reutilizada");
+    }
+    objeto.objeto("operaciones", operaciones);
+
+    objeto.objeto("entorno", entorno_json(resultado.entorno, resultado.entorno_final.frecuencia_mhz))
+          .textos("avisos_entorno", resultado.avisos_entorno);
+
+    if(contabilidad_memoria_activa()) {
+        objeto.entero("pico_rss_proceso", memoria_proceso().max_rss);
+    } else {
+        objeto.nulo("pico_rss_proceso");
+    }
+
+    // Una sola escritura y flush: así una línea nunca se queda a medias si el proceso muere después
+    salida << objeto.str() << std::endl;
+}
+
+} // namespace pqbench
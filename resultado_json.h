@@ -0,0 +1,62 @@
+#ifndef PQBENCH_RESULTADO_JSON_H
+#define PQBENCH_RESULTADO_JSON_H
+
+#include "pqbench.h"
+
+/*
+Resultados en JSON lines para que benchmark.py no tenga que leer el texto de imprimir().
+
+Con --json cada set evaluado se escribe en stdout como un único objeto JSON en una línea,
+y todo lo demás (contador de ciclos, características de la CPU, avisos) va a stderr. Cada
+objeto lleva "version_esquema"; si se cambia el significado o el nombre de un campo hay
+que subir VERSION_ESQUEMA_JSON, mientras que añadir campos nuevos no la cambia.
+
+Esquema (versión 1):
+  version_esquema, parametro, familia, prehash (null fuera de SLH-DSA), rng,
+  firma_determinista, verificada, clave_en_cache, tam_clave_publica, tam_clave_privada,
+  tam_firma,
+  operaciones: {keygen, carga_clave, preparacion_firmador, firma,
+                preparacion_verificador, verificacion, verificacion_reutilizada}
+    cada una con muestras, descartadas, segundos y ciclos (min, mediana, media,
+    desviacion, p90, p99, max) y ciclos_nucleo, y según las opciones hw, memoria, rng
+    (llamadas, bytes y segundos: medias por muestra, no enteras) y energia. Las que no
+    se han medido son null.
+  entorno: {maquina, nucleo, fijado, prioridad, gobernador, turbo, smt, hermanos_smt,
+            frecuencia_inicial_mhz, frecuencia_final_mhz, carga}
+  avisos_entorno: [texto...]
+  pico_rss_proceso (null sin --memoria)
+Los valores desconocidos son null.
+*/
+
+namespace pqbench {
+
+constexpr int VERSION_ESQUEMA_JSON = 1;
+
+// Objeto JSON que se va construyendo campo a campo, en el orden en que se añaden
+class ObjetoJSON {
+public:
+    ObjetoJSON& numero(const std::string& clave, double valor);      // null si no es finito
+    ObjetoJSON& entero(const std::string& clave, uint64_t valor);
+    ObjetoJSON& logico(const std::string& clave, bool valor);
+    ObjetoJSON& texto(const std::string& clave, const std::string& valor);
+    ObjetoJSON& objeto(const std::string& clave, const ObjetoJSON& valor);
+    ObjetoJSON& textos(const std::string& clave, const std::vector<std::string>& valores);
+    ObjetoJSON& nulo(const std::string& clave);
+
+    std::string str() const { return "{" + m_campos + "}"; }
+
+private:
+    ObjetoJSON& crudo(const std::string& clave, const std::string& valor);
+
+    std::string m_campos;
+};
+
+// Cadena JSON entre comillas, escapando comillas, barras y caracteres de control
+std::string cadena_json(const std::string& texto);
+
+// Escribe el resultado como una línea JSON terminada en '\n'
+void imprimir_json(const Resultado& resultado, std::ostream& salida);
+
+} // namespace pqbench
+
+#endif
@@ -0,0 +1,189 @@
+#include "serializacion.h"
+#include "cache_claves.h"
+
+#include <iomanip>
+#include <stdexcept>
+
+#include <botan/pkcs8.h>
+#include <botan/x509_key.h>
+
+namespace pqbench {
+
+std::string nombre_formato(FormatoClave formato) {
+    switch(formato) {
+        case FormatoClave::CRUDO: return "crudo";
+        case FormatoClave::DER: return "DER";
+        case FormatoClave::PEM: return "PEM";
+    }
+    return "";
+}
+
+ClavesCodificadas codificar_claves(const Botan::Private_Key& clave, FormatoClave formato) {
+    ClavesCodificadas codificadas;
+    auto pub_key = clave.public_key();
+
+    switch(formato) {
+        case FormatoClave::CRUDO:
+            codificadas.privada = clave.private_key_bits();
+            codificadas.publica = pub_key->public_key_bits();
+            break;
+        case FormatoClave::DER:
+            codificadas.privada = Botan::PKCS8::BER_encode(clave);
+            codificadas.publica = Botan::X509::BER_encode(*pub_key);
+            break;
+        case FormatoClave::PEM: {
+            std::string privada = Botan::PKCS8::PEM_encode(clave);
+            std::string publica = Botan::X509::PEM_encode(*pub_key);
+            codificadas.privada.assign(privada.begin(), privada.end());
+            codificadas.publica.assign(publica.begin(), publica.end());
+            break;
+        }
+    }
+
+    return codificadas;
+}
+
+std::unique_ptr<Botan::Private_Key> cargar_privada(const Esquema& esquema, FormatoClave formato, std::span<const uint8_t> datos) {
+    // DER y PEM llevan el identificador del algoritmo, así que los carga el mismo cargador
+    if(formato == FormatoClave::CRUDO) {
+        return esquema.cargar_clave_privada(datos);
+    }
+    return Botan::PKCS8::load_key(datos);
+}
+
+std::unique_ptr<Botan::Public_Key> cargar_publica(const Esquema& esquema, FormatoClave formato, std::span<const uint8_t> datos) {
+    if(formato == FormatoClave::CRUDO) {
+        return esquema.cargar_clave_publica(datos);
+    }
+    return Botan::X509::load_key(datos);
+}
+
+ResultadoSerializacion medir_serializacion(const Esquema& esquema, const Botan::Private_Key& clave,
+                                           FormatoClave formato, const Opciones& opciones) {
+    Botan::AutoSeeded_RNG rng;
+    const Botan::secure_vector<uint8_t>& msg = mensaje_fijo();
+
+    ResultadoSerializacion resultado;
+    resultado.formato = formato;
+
+    ClavesCodificadas codificadas;
+    resultado.codificacion = muestrear(opciones, [&] { codificadas = codificar_claves(clave, formato); });
+    resultado.tam_privada = codificadas.privada.size();
+    resultado.tam_publica = codificadas.publica.size();
+
+    /*
+    El arranque de un firmador: cargar la clave privada, construir el firmador y firmar
+    por primera vez. En XMSS cada repetición parte de la misma clave codificada, pero dentro
+    del proceso Botan comparte el índice de hojas entre todas las copias de la clave, así
+    que cada firma usa la siguiente hoja. Entre ejecuciones sólo no se repiten si la clave
+    vuelve a la caché con el índice avanzado, como hace ejecutar_serializacion().
+    */
+    std::unique_ptr<Botan::Private_Key> priv_key;
+    std::unique_ptr<Botan::PK_Signer> signer;
+    std::vector<uint8_t> signature;
+
+    std::unique_ptr<Botan::Public_Key> pub_key;
+    std::unique_ptr<Botan::PK_Verifier> verifier;
+
+    try {
+        auto firmador = muestrear_fases(opciones,
+            [&] { priv_key = cargar_privada(esquema, formato, codificadas.privada); },
+            [&] { signer = std::make_unique<Botan::PK_Signer>(*priv_key, rng, esquema.padding_firma()); },
+            [&] {
+                signer->update(msg.data(), msg.size());
+                signature = signer->signature(rng);
+            });
+        resultado.carga_privada = firmador[0];
+        resultado.preparacion_firmador = firmador[1];
+        resultado.primera_firma = firmador[2];
+
+        auto verificador = muestrear_fases(opciones,
+            [&] { pub_key = cargar_publica(esquema, formato, codificadas.publica); },
+            [&] { verifier = std::make_unique<Botan::PK_Verifier>(*pub_key, esquema.padding_verificacion()); });
+        resultado.carga_publica = verificador[0];
+        resultado.preparacion_verificador = verificador[1];
+
+        verifier->update(msg.data(), msg.size());
+        resultado.correcta = verifier->check_signature(signature.data(), signature.size());
+    } catch(const std::exception& e) {
+        resultado.error = e.what();
+    }
+
+    return resultado;
+}
+
+static void imprimir_serializacion(const std::vector<ResultadoSerializacion>& resultados, std::ostream& salida) {
+    salida << columna("Formato", 8) << columna("Privada", 12) << columna("Pública", 12)
+           << columna("Codificar", 13) << columna("Cargar priv.", 13) << columna("Firmador", 13)
+           << columna("1ª firma", 13) << columna("Arranque", 13) << columna("Cargar púb.", 13)
+           << columna("Verificador", 13) << "\n";
+
+    for(const auto& r : resultados) {
+        salida << std::setw(8) << nombre_formato(r.formato) << std::setw(12) << formatear_bytes(r.tam_privada)
+               << std::setw(12) << formatear_bytes(r.tam_publica) << std::setw(13) << r.codificacion.segundos.mediana;
+
+        if(!r.error.empty()) {
+            salida << "  [!] No se ha podido cargar: " << r.error << "\n";
+            continue;
+        }
+
+        double arranque = r.carga_privada.segundos.mediana + r.preparacion_firmador.segundos.mediana +
+                          r.primera_firma.segundos.mediana;
+        salida << std::setw(13) << r.carga_privada.segundos.mediana << std::setw(13) << r.preparacion_firmador.segundos.mediana
+               << std::setw(13) << r.primera_firma.segundos.mediana << std::setw(13) << arranque
+               << std::setw(13) << r.carga_publica.segundos.mediana << std::setw(13) << r.preparacion_verificador.segundos.mediana
+               << (r.correcta ? "" : "  [!] Firma Errónea") << "\n";
+    }
+}
+
+int ejecutar_serializacion(const Argumentos& args) {
+    if(args.posicionales().size() != 1) {
+        std::cerr << "Uso: ./pqbench serializacion <set|familia|todos> [--prehash] [--iteraciones=N] [--calentamiento=N]"
+                     " [--outliers[=k]] [--cache-claves[=d]] [--semilla=N]\n";
+        return 1;
+    }
+
+    Opciones opciones = leer_opciones(args);
+    std::vector<Conjunto> elegidos = seleccionar(args.posicionales()[0], args.activa("prehash"));
+    if(elegidos.empty()) {
+        std::cerr << "Set de parámetros inválido.\n";
+        return 1;
+    }
+
+    int fallos = 0;
+    for(const auto& conjunto : elegidos) {
+        try {
+            auto esquema = crear_esquema(conjunto);
+            ClaveObtenida obtenida = obtener_clave(*esquema, opciones);
+
+            std::cout << "ARRANQUE EN FRÍO DE " << conjunto.nombre << (conjunto.prehash ? " (pre-hash)" : "")
+                      << " | tiempos en segundos (mediana) | Arranque = cargar privada + firmador + 1ª firma\n";
+
+            std::vector<ResultadoSerializacion> resultados;
+            for(FormatoClave formato : {FormatoClave::CRUDO, FormatoClave::DER, FormatoClave::PEM}) {
+                resultados.push_back(medir_serializacion(*esquema, *obtenida.clave, formato, opciones));
+                // Que Botan no admita un formato no es un fallo de la firma, sólo se informa
+                fallos += resultados.back().error.empty() && !resultados.back().correcta;
+            }
+
+            imprimir_serializacion(resultados, std::cout);
+            std::cout << "\n";
+
+            /*
+            Las copias cargadas en cada formato comparten el índice de XMSS con esta clave, que
+            vuelve a la caché con las hojas que han gastado
+            */
+            if(!obtenida.ruta.empty()) {
+                guardar_clave_cacheada(obtenida.ruta, conjunto, opciones.semilla_claves, *obtenida.clave,
+                                       obtenida.keygen.segundos, obtenida.keygen.ciclos);
+            }
+        } catch(const std::exception& e) {
+            std::cerr << "Excepción en serializacion(" << conjunto.nombre << "): " << e.what() << "\n";
+            ++fallos;
+        }
+    }
+
+    return fallos == 0 ? 0 : 1;
+}
+
+} // namespace pqbench
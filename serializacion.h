@@ -0,0 +1,63 @@
+#ifndef PQBENCH_SERIALIZACION_H
+#define PQBENCH_SERIALIZACION_H
+
+#include "pqbench.h"
+
+/*
+Arranque en frío de un firmador: serialización y carga de las claves.
+
+Un firmador que arranca carga su clave de disco y sólo después firma. Aquí se codifica
+la clave en tres formatos, se vuelve a cargar con los constructores y cargadores de
+Botan y se construyen el firmador y el verificador, midiendo cada paso:
+- Crudo: private_key_bits() y public_key_bits(), cargados con el constructor de la
+  clave de cada esquema. En ML-DSA la clave privada es la semilla de 32 bytes, así que
+  cargarla incluye expandirla; en XMSS se carga la clave privada completa.
+- DER: PKCS#8 para la privada y X.509 (SubjectPublicKeyInfo) para la pública, cargadas
+  con PKCS8::load_key y X509::load_key.
+- PEM: lo mismo en Base64 con cabeceras, por los mismos cargadores.
+Las claves se cargan desde memoria: la lectura del disco se mide en la caché de claves.
+*/
+
+namespace pqbench {
+
+enum class FormatoClave { CRUDO, DER, PEM };
+
+std::string nombre_formato(FormatoClave formato);
+
+struct ClavesCodificadas {
+    Botan::secure_vector<uint8_t> privada;
+    std::vector<uint8_t> publica;
+};
+
+ClavesCodificadas codificar_claves(const Botan::Private_Key& clave, FormatoClave formato);
+std::unique_ptr<Botan::Private_Key> cargar_privada(const Esquema& esquema, FormatoClave formato, std::span<const uint8_t> datos);
+std::unique_ptr<Botan::Public_Key> cargar_publica(const Esquema& esquema, FormatoClave formato, std::span<const uint8_t> datos);
+
+// Pasos del arranque con un formato
+struct ResultadoSerializacion {
+    FormatoClave formato = FormatoClave::CRUDO;
+    size_t tam_privada = 0;
+    size_t tam_publica = 0;
+    Operacion codificacion;            // Clave privada y pública
+    Operacion carga_privada;
+    Operacion preparacion_firmador;
+    Operacion primera_firma;           // Con el firmador recién construido
+    Operacion carga_publica;
+    Operacion preparacion_verificador;
+    bool correcta = false;             // La firma de la clave cargada verifica con la pública cargada
+    std::string error;                 // Si Botan no admite el formato para este esquema
+};
+
+ResultadoSerializacion medir_serializacion(const Esquema& esquema, const Botan::Private_Key& clave,
+                                           FormatoClave formato, const Opciones& opciones);
+
+/*
+Punto de entrada del modo desde la línea de comandos:
+  ./pqbench serializacion <set|familia|todos> [--prehash] [--iteraciones=N] [--calentamiento=N]
+                          [--outliers[=k]] [--cache-claves[=d]] [--semilla=N]
+*/
+int ejecutar_serializacion(const Argumentos& args);
+
+} // namespace pqbench
+
+#endif
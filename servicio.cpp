@@ -0,0 +1,725 @@
+#include "servicio.h"
+#include "binario.h"
+#include "cache_claves.h"
+
+#include <condition_variable>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <list>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace pqbench {
+
+// ----- TRAMAS -----
+
+bool enviar_trama(int fd, std::span<const uint8_t> trama) {
+    std::vector<uint8_t> datos;
+    datos.reserve(4 + trama.size());
+    poner_entero(datos, trama.size(), 4);
+    datos.insert(datos.end(), trama.begin(), trama.end());
+    return escribir_todo(fd, datos.data(), datos.size());
+}
+
+bool recibir_trama(int fd, std::vector<uint8_t>& trama) {
+    uint8_t cabecera[4];
+    if(!leer_todo(fd, cabecera, sizeof(cabecera))) {
+        return false;
+    }
+
+    size_t pos = 0;
+    uint64_t longitud = leer_entero(cabecera, pos, 4);
+    if(longitud > TAM_MAXIMO_TRAMA) {
+        return false;
+    }
+
+    trama.resize(longitud);
+    return leer_todo(fd, trama.data(), trama.size());
+}
+
+static sockaddr_un direccion_socket(const std::string& ruta) {
+    sockaddr_un direccion{};
+    direccion.sun_family = AF_UNIX;
+    if(ruta.size() >= sizeof(direccion.sun_path)) {
+        throw std::invalid_argument("La ruta del socket es demasiado larga: " + ruta);
+    }
+    std::memcpy(direccion.sun_path, ruta.c_str(), ruta.size() + 1);
+    return direccion;
+}
+
+static std::vector<uint8_t> respuesta(uint32_t id, EstadoRespuesta estado) {
+    std::vector<uint8_t> datos;
+    poner_entero(datos, id, 4);
+    poner_entero(datos, static_cast<uint8_t>(estado), 1);
+    return datos;
+}
+
+static std::vector<uint8_t> respuesta_error(uint32_t id, const std::string& texto) {
+    std::vector<uint8_t> datos = respuesta(id, EstadoRespuesta::ERROR);
+    poner_campo(datos, std::span(reinterpret_cast<const uint8_t*>(texto.data()), texto.size()));
+    return datos;
+}
+
+// ----- SERVIDOR -----
+
+namespace {
+
+struct Conexion {
+    int fd;
+    std::mutex escritura; // Varios trabajadores pueden responder a la vez por la misma conexión
+
+    explicit Conexion(int fd) : fd(fd) {}
+    ~Conexion() { ::close(fd); }
+
+    void responder(std::span<const uint8_t> datos) {
+        std::lock_guard<std::mutex> lock(escritura);
+        enviar_trama(fd, datos);
+    }
+};
+
+struct Peticion {
+    std::shared_ptr<Conexion> conexion;
+    TipoPeticion tipo = TipoPeticion::LISTAR;
+    uint32_t id = 0;
+    std::vector<uint8_t> mensaje;
+    std::vector<uint8_t> firma;
+};
+
+// Una clave del servidor con su cola de peticiones pendientes
+struct ClaveServicio {
+    Conjunto conjunto;
+    std::unique_ptr<Esquema> esquema;
+    ClaveObtenida obtenida;
+    std::vector<uint8_t> clave_publica;
+    std::unique_ptr<Botan::Public_Key> pub_key;
+    Botan::AutoSeeded_RNG rng;
+    std::unique_ptr<Botan::PK_Signer> signer;
+    std::unique_ptr<Botan::PK_Verifier> verifier;
+
+    std::mutex mutex;
+    std::deque<Peticion> pendientes;
+    bool programada = false; // Está en la cola de claves listas o la atiende un trabajador
+};
+
+volatile std::sig_atomic_t g_terminar = 0;
+
+extern "C" void pedir_terminar(int) {
+    g_terminar = 1;
+}
+
+class Servidor {
+public:
+    Servidor(std::vector<std::unique_ptr<ClaveServicio>> claves, size_t tam_lote) :
+        m_claves(std::move(claves)), m_tam_lote(std::max<size_t>(tam_lote, 1)) {}
+
+    void atender(int escucha, size_t hilos);
+
+    uint64_t peticiones() const { return m_peticiones.load(); }
+    uint64_t lotes() const { return m_lotes.load(); }
+    uint64_t lote_maximo() const { return m_lote_maximo.load(); }
+    const std::vector<std::unique_ptr<ClaveServicio>>& claves() const { return m_claves; }
+
+private:
+    void leer_conexion(std::shared_ptr<Conexion> conexion);
+    void encolar(ClaveServicio& clave, Peticion peticion);
+    void trabajar();
+    std::vector<uint8_t> procesar(ClaveServicio& clave, const Peticion& peticion);
+    std::vector<uint8_t> listar(uint32_t id) const;
+
+    std::vector<std::unique_ptr<ClaveServicio>> m_claves;
+    size_t m_tam_lote;
+
+    std::mutex m_mutex;
+    std::condition_variable m_hay_trabajo;
+    std::deque<ClaveServicio*> m_listas; // Claves con peticiones pendientes
+    bool m_parar = false;
+
+    std::atomic<uint64_t> m_peticiones{0};
+    std::atomic<uint64_t> m_lotes{0};
+    std::atomic<uint64_t> m_lote_maximo{0};
+};
+
+std::vector<uint8_t> Servidor::listar(uint32_t id) const {
+    std::vector<uint8_t> datos = respuesta(id, EstadoRespuesta::CORRECTA);
+    poner_entero(datos, m_claves.size(), 2);
+    for(const auto& clave : m_claves) {
+        const std::string& nombre = clave->conjunto.nombre;
+        poner_campo(datos, std::span(reinterpret_cast<const uint8_t*>(nombre.data()), nombre.size()), 2);
+        poner_entero(datos, clave->conjunto.prehash, 1);
+        poner_campo(datos, clave->clave_publica);
+    }
+    return datos;
+}
+
+void Servidor::leer_conexion(std::shared_ptr<Conexion> conexion) {
+    std::vector<uint8_t> trama;
+    while(recibir_trama(conexion->fd, trama)) {
+        Peticion peticion;
+        peticion.conexion = conexion;
+        uint16_t indice = 0;
+
+        try {
+            size_t pos = 0;
+            peticion.tipo = static_cast<TipoPeticion>(leer_entero(trama, pos, 1));
+            peticion.id = static_cast<uint32_t>(leer_entero(trama, pos, 4));
+            indice = static_cast<uint16_t>(leer_entero(trama, pos, 2));
+
+            if(peticion.tipo == TipoPeticion::LISTAR) {
+                conexion->responder(listar(peticion.id));
+                continue;
+            }
+
+            if(peticion.tipo != TipoPeticion::FIRMAR && peticion.tipo != TipoPeticion::VERIFICAR) {
+                throw std::invalid_argument("Tipo de petición desconocido");
+            }
+            if(indice >= m_claves.size()) {
+                throw std::invalid_argument("Clave inexistente: " + std::to_string(indice));
+            }
+
+            auto mensaje = leer_campo(trama, pos);
+            peticion.mensaje.assign(mensaje.begin(), mensaje.end());
+            if(peticion.tipo == TipoPeticion::VERIFICAR) {
+                auto firma = leer_campo(trama, pos);
+                peticion.firma.assign(firma.begin(), firma.end());
+            }
+        } catch(const std::exception& e) {
+            conexion->responder(respuesta_error(peticion.id, e.what()));
+            continue;
+        }
+
+        encolar(*m_claves[indice], std::move(peticion));
+    }
+}
+
+void Servidor::encolar(ClaveServicio& clave, Peticion peticion) {
+    {
+        std::lock_guard<std::mutex> lock(clave.mutex);
+        clave.pendientes.push_back(std::move(peticion));
+        if(clave.programada) {
+            return;
+        }
+        clave.programada = true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_listas.push_back(&clave);
+    }
+    m_hay_trabajo.notify_one();
+}
+
+std::vector<uint8_t> Servidor::procesar(ClaveServicio& clave, const Peticion& peticion) {
+    try {
+        if(peticion.tipo == TipoPeticion::FIRMAR) {
+            clave.signer->update(peticion.mensaje.data(), peticion.mensaje.size());
+            std::vector<uint8_t> firma = clave.signer->signature(clave.rng);
+
+            std::vector<uint8_t> datos = respuesta(peticion.id, EstadoRespuesta::CORRECTA);
+            poner_campo(datos, firma);
+            return datos;
+        }
+
+        clave.verifier->update(peticion.mensaje.data(), peticion.mensaje.size());
+        bool valida = clave.verifier->check_signature(peticion.firma.data(), peticion.firma.size());
+        return respuesta(peticion.id, valida ? EstadoRespuesta::CORRECTA : EstadoRespuesta::FIRMA_INVALIDA);
+    } catch(const std::exception& e) {
+        // P. ej. una clave XMSS sin hojas libres
+        return respuesta_error(peticion.id, e.what());
+    }
+}
+
+void Servidor::trabajar() {
+    for(;;) {
+        ClaveServicio* clave = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_hay_trabajo.wait(lock, [&] { return m_parar || !m_listas.empty(); });
+            if(m_listas.empty()) {
+                return;
+            }
+            clave = m_listas.front();
+            m_listas.pop_front();
+        }
+
+        // Este hilo es el único que usa el firmador de la clave hasta que la devuelve
+        std::vector<Peticion> lote;
+        {
+            std::lock_guard<std::mutex> lock(clave->mutex);
+            while(!clave->pendientes.empty() && lote.size() < m_tam_lote) {
+                lote.push_back(std::move(clave->pendientes.front()));
+                clave->pendientes.pop_front();
+            }
+        }
+
+        for(const auto& peticion : lote) {
+            peticion.conexion->responder(procesar(*clave, peticion));
+        }
+
+        m_peticiones += lote.size();
+        m_lotes++;
+        uint64_t maximo = m_lote_maximo.load();
+        while(lote.size() > maximo && !m_lote_maximo.compare_exchange_weak(maximo, lote.size())) {}
+
+        // Si han llegado más peticiones mientras tanto, la clave vuelve al final de la cola
+        bool quedan = false;
+        {
+            std::lock_guard<std::mutex> lock(clave->mutex);
+            quedan = !clave->pendientes.empty();
+            clave->programada = quedan;
+        }
+        if(quedan) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_listas.push_back(clave);
+            }
+            m_hay_trabajo.notify_one();
+        }
+    }
+}
+
+// Hilo lector de una conexión; sólo se guarda una referencia débil para poder cortarla al terminar
+struct Lector {
+    std::weak_ptr<Conexion> conexion;
+    std::thread hilo;
+    std::atomic<bool> terminado{false};
+};
+
+void Servidor::atender(int escucha, size_t hilos) {
+    std::vector<std::thread> trabajadores;
+    for(size_t h = 0; h < hilos; ++h) {
+        trabajadores.emplace_back([this] { trabajar(); });
+    }
+
+    std::list<Lector> lectores;
+    bool aviso_descriptores = false;
+
+    // Se comprueba cada poco si se ha pedido terminar
+    while(!g_terminar) {
+        /*
+        Los lectores de conexiones cerradas se recogen para no acumular hilos. El descriptor
+        se cierra al soltar la última referencia a la conexión: la del lector al salir o la
+        de la última petición pendiente al responderla.
+        */
+        for(auto it = lectores.begin(); it != lectores.end();) {
+            if(it->terminado.load()) {
+                it->hilo.join();
+                it = lectores.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        pollfd espera{escucha, POLLIN, 0};
+        if(::poll(&espera, 1, 200) <= 0) {
+            continue;
+        }
+
+        int fd = ::accept(escucha, nullptr, nullptr);
+        if(fd < 0) {
+            // Sin descriptores libres poll sigue indicando la conexión pendiente: se espera en vez de girar
+            if(errno == EMFILE || errno == ENFILE) {
+                if(!aviso_descriptores) {
+                    std::cerr << "[!] Sin descriptores libres para aceptar conexiones (RLIMIT_NOFILE)\n";
+                    aviso_descriptores = true;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            continue;
+        }
+
+        auto conexion = std::make_shared<Conexion>(fd);
+        Lector& lector = lectores.emplace_back();
+        lector.conexion = conexion;
+        lector.hilo = std::thread([this, &lector, conexion = std::move(conexion)]() mutable {
+            leer_conexion(std::move(conexion));
+            lector.terminado = true;
+        });
+    }
+
+    // Se cortan las conexiones para que los lectores salgan de read()
+    for(auto& lector : lectores) {
+        if(auto conexion = lector.conexion.lock()) {
+            ::shutdown(conexion->fd, SHUT_RDWR);
+        }
+    }
+    for(auto& lector : lectores) {
+        lector.hilo.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_parar = true;
+    }
+    m_hay_trabajo.notify_all();
+    for(auto& trabajador : trabajadores) {
+        trabajador.join();
+    }
+}
+
+} // namespace
+
+int ejecutar_servidor(const Argumentos& args) {
+    if(args.posicionales().size() < 2) {
+        std::cerr << "Uso: ./pqbench servidor <socket> <set|familia|todos>... [--hilos=nproc] [--lote=32] [--prehash]"
+                     " [--cache-claves[=d]] [--semilla=N]\n";
+        return 1;
+    }
+
+    Opciones opciones = leer_opciones(args);
+    long hilos = args.entero("hilos", static_cast<long>(std::max(1u, std::thread::hardware_concurrency())));
+    long tam_lote = args.entero("lote", 32);
+    const std::string& ruta = args.posicionales()[0];
+
+    if(hilos < 1 || tam_lote < 1) {
+        std::cerr << "Opciones inválidas para el modo servidor.\n";
+        return 1;
+    }
+
+    // Una clave por set, con su firmador y su verificador construidos una sola vez
+    std::vector<std::unique_ptr<ClaveServicio>> claves;
+    for(size_t i = 1; i < args.posicionales().size(); ++i) {
+        std::vector<Conjunto> encontrados = seleccionar(args.posicionales()[i], args.activa("prehash"));
+        if(encontrados.empty()) {
+            std::cerr << "Set de parámetros inválido: " << args.posicionales()[i] << "\n";
+            return 1;
+        }
+
+        for(const auto& conjunto : encontrados) {
+            auto clave = std::make_unique<ClaveServicio>();
+            clave->conjunto = conjunto;
+            clave->esquema = crear_esquema(conjunto);
+            clave->obtenida = obtener_clave(*clave->esquema, opciones);
+            clave->pub_key = clave->obtenida.clave->public_key();
+            clave->clave_publica = clave->pub_key->public_key_bits();
+            clave->signer = std::make_unique<Botan::PK_Signer>(*clave->obtenida.clave, clave->rng, clave->esquema->padding_firma());
+            clave->verifier = std::make_unique<Botan::PK_Verifier>(*clave->pub_key, clave->esquema->padding_verificacion());
+
+            std::cout << "Clave " << claves.size() << ": " << conjunto.nombre << (conjunto.prehash ? " (pre-hash)" : "")
+                      << (clave->obtenida.de_cache ? " (de la caché)" : "") << "\n";
+            claves.push_back(std::move(clave));
+        }
+    }
+
+    int escucha = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un direccion = direccion_socket(ruta);
+    ::unlink(ruta.c_str());
+    if(escucha < 0 || ::bind(escucha, reinterpret_cast<sockaddr*>(&direccion), sizeof(direccion)) != 0 || ::listen(escucha, 128) != 0) {
+        std::cerr << "No se pudo escuchar en " << ruta << ": " << std::strerror(errno) << "\n";
+        if(escucha >= 0) {
+            ::close(escucha);
+        }
+        return 1;
+    }
+
+    // Un cliente que se va sin leer la respuesta no debe tumbar el servidor
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, pedir_terminar);
+    std::signal(SIGTERM, pedir_terminar);
+
+    std::cout << "Escuchando en " << ruta << " con " << hilos << " hilos trabajadores y lotes de hasta " << tam_lote
+              << " peticiones por clave\n" << std::flush;
+
+    Servidor servidor(std::move(claves), tam_lote);
+    servidor.atender(escucha, hilos);
+    ::close(escucha);
+    ::unlink(ruta.c_str());
+
+    double media = servidor.lotes() > 0 ? static_cast<double>(servidor.peticiones()) / servidor.lotes() : 0;
+    std::cout << "Peticiones atendidas: " << servidor.peticiones() << " en " << servidor.lotes() << " lotes (media "
+              << std::fixed << std::setprecision(2) << media << std::defaultfloat << std::setprecision(6)
+              << ", máximo " << servidor.lote_maximo() << ")\n";
+
+    // Las claves de la caché vuelven a ella; las de XMSS, con las hojas consumidas
+    for(const auto& clave : servidor.claves()) {
+        const ClaveObtenida& obtenida = clave->obtenida;
+        if(!obtenida.ruta.empty()) {
+            guardar_clave_cacheada(obtenida.ruta, clave->conjunto, opciones.semilla_claves, *obtenida.clave,
+                                   obtenida.keygen.segundos, obtenida.keygen.ciclos);
+        }
+    }
+
+    return 0;
+}
+
+// ----- CLIENTE -----
+
+namespace {
+
+// Clave que ofrece el servidor
+struct ClaveRemota {
+    uint16_t indice = 0;
+    Conjunto conjunto;
+    std::vector<uint8_t> clave_publica;
+};
+
+class ClienteServicio {
+public:
+    explicit ClienteServicio(const std::string& ruta) {
+        m_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un direccion = direccion_socket(ruta);
+        if(m_fd < 0 || ::connect(m_fd, reinterpret_cast<sockaddr*>(&direccion), sizeof(direccion)) != 0) {
+            std::string error = std::strerror(errno);
+            if(m_fd >= 0) {
+                ::close(m_fd);
+            }
+            throw std::runtime_error("No se pudo conectar con " + ruta + ": " + error);
+        }
+    }
+
+    ~ClienteServicio() { ::close(m_fd); }
+
+    ClienteServicio(const ClienteServicio&) = delete;
+    ClienteServicio& operator=(const ClienteServicio&) = delete;
+
+    // Envía una petición y espera su respuesta; devuelve el estado y deja en pos el inicio del contenido
+    EstadoRespuesta pedir(TipoPeticion tipo, uint16_t clave, std::span<const uint8_t> mensaje,
+                          std::span<const uint8_t> firma, std::vector<uint8_t>& contenido, size_t& pos) {
+        uint32_t id = m_siguiente_id++;
+
+        std::vector<uint8_t> trama;
+        poner_entero(trama, static_cast<uint8_t>(tipo), 1);
+        poner_entero(trama, id, 4);
+        poner_entero(trama, clave, 2);
+        if(tipo != TipoPeticion::LISTAR) {
+            poner_campo(trama, mensaje);
+        }
+        if(tipo == TipoPeticion::VERIFICAR) {
+            poner_campo(trama, firma);
+        }
+
+        if(!enviar_trama(m_fd, trama) || !recibir_trama(m_fd, contenido)) {
+            throw std::runtime_error("El servidor ha cerrado la conexión");
+        }
+
+        pos = 0;
+        if(leer_entero(contenido, pos, 4) != id) {
+            throw std::runtime_error("Respuesta con un id inesperado");
+        }
+        return static_cast<EstadoRespuesta>(leer_entero(contenido, pos, 1));
+    }
+
+    std::vector<ClaveRemota> listar() {
+        std::vector<uint8_t> contenido;
+        size_t pos = 0;
+        if(pedir(TipoPeticion::LISTAR, 0, {}, {}, contenido, pos) != EstadoRespuesta::CORRECTA) {
+            throw std::runtime_error("El servidor no ha podido listar sus claves");
+        }
+
+        std::vector<ClaveRemota> claves(leer_entero(contenido, pos, 2));
+        for(size_t i = 0; i < claves.size(); ++i) {
+            auto nombre = leer_campo(contenido, pos, 2);
+            bool prehash = leer_entero(contenido, pos, 1) != 0;
+            auto publica = leer_campo(contenido, pos);
+
+            claves[i].indice = static_cast<uint16_t>(i);
+            claves[i].conjunto = buscar_conjunto(std::string(nombre.begin(), nombre.end()), prehash);
+            claves[i].clave_publica.assign(publica.begin(), publica.end());
+        }
+        return claves;
+    }
+
+private:
+    int m_fd = -1;
+    uint32_t m_siguiente_id = 1;
+};
+
+// Resultado de la carga con un nivel de concurrencia
+struct ResultadoCliente {
+    size_t concurrencia = 0;
+    uint64_t peticiones = 0;
+    uint64_t errores = 0;
+    double segundos = 0;
+    std::vector<double> latencias;
+};
+
+/*
+`concurrencia` clientes, cada uno con su conexión, mandan peticiones de una en una
+durante `duracion` segundos. Se mide desde que se envía la petición hasta que llega la
+respuesta, así que incluye el socket, la cola del servidor y el lote.
+*/
+ResultadoCliente generar_carga(const std::string& ruta, const ClaveRemota& clave, TipoPeticion tipo,
+                               const std::vector<uint8_t>& mensaje, const std::vector<uint8_t>& firma,
+                               size_t concurrencia, double duracion) {
+    std::vector<std::vector<double>> latencias(concurrencia);
+    std::vector<uint64_t> errores(concurrencia, 0);
+    std::vector<std::thread> clientes;
+    std::atomic<size_t> listos{0};
+    std::atomic<bool> empezar{false};
+    std::atomic<bool> parar{false};
+    std::string error;
+    std::mutex mutex_error;
+
+    for(size_t c = 0; c < concurrencia; ++c) {
+        clientes.emplace_back([&, c] {
+            try {
+                ClienteServicio cliente(ruta);
+                std::vector<uint8_t> contenido;
+                size_t pos = 0;
+
+                listos++;
+                while(!empezar.load()) {
+                    std::this_thread::yield();
+                }
+
+                while(!parar.load(std::memory_order_relaxed)) {
+                    auto inicio = std::chrono::steady_clock::now();
+                    EstadoRespuesta estado = cliente.pedir(tipo, clave.indice, mensaje, firma, contenido, pos);
+                    auto fin = std::chrono::steady_clock::now();
+
+                    latencias[c].push_back(std::chrono::duration<double>(fin - inicio).count());
+                    errores[c] += estado != EstadoRespuesta::CORRECTA;
+                }
+            } catch(const std::exception& e) {
+                std::lock_guard<std::mutex> lock(mutex_error);
+                error = e.what();
+                listos++;
+            }
+        });
+    }
+
+    while(listos.load() < concurrencia) {
+        std::this_thread::yield();
+    }
+
+    auto inicio = std::chrono::steady_clock::now();
+    empezar = true;
+    std::this_thread::sleep_for(std::chrono::duration<double>(duracion));
+    parar = true;
+    for(auto& cliente : clientes) {
+        cliente.join();
+    }
+    auto fin = std::chrono::steady_clock::now();
+
+    if(!error.empty()) {
+        throw std::runtime_error("Error en un cliente: " + error);
+    }
+
+    ResultadoCliente resultado;
+    resultado.concurrencia = concurrencia;
+    resultado.segundos = std::chrono::duration<double>(fin - inicio).count();
+    for(size_t c = 0; c < concurrencia; ++c) {
+        resultado.peticiones += latencias[c].size();
+        resultado.errores += errores[c];
+        resultado.latencias.insert(resultado.latencias.end(), latencias[c].begin(), latencias[c].end());
+    }
+    return resultado;
+}
+
+void imprimir_carga(const std::vector<ResultadoCliente>& resultados, std::ostream& salida) {
+    salida << std::setw(13) << "Concurrencia" << std::setw(12) << "pet/s" << std::setw(14) << "p50 (s)"
+           << std::setw(14) << "p90 (s)" << std::setw(14) << "p99 (s)" << std::setw(14) << "p99.9 (s)"
+           << std::setw(14) << "Máx (s)" << std::setw(10) << "Errores" << "\n";
+
+    for(const auto& r : resultados) {
+        std::vector<double> ordenadas = r.latencias;
+        std::sort(ordenadas.begin(), ordenadas.end());
+        Estadisticas e = calcular_estadisticas(ordenadas);
+
+        salida << std::setw(13) << r.concurrencia
+               << std::setw(12) << std::fixed << std::setprecision(1) << (r.segundos > 0 ? r.peticiones / r.segundos : 0)
+               << std::defaultfloat << std::setprecision(6)
+               << std::setw(14) << e.mediana << std::setw(14) << e.p90 << std::setw(14) << e.p99
+               << std::setw(14) << (ordenadas.empty() ? 0 : percentil(ordenadas, 99.9)) << std::setw(14) << e.max
+               << std::setw(10) << r.errores << "\n";
+    }
+}
+
+} // namespace
+
+int ejecutar_cliente(const Argumentos& args) {
+    if(args.posicionales().size() != 1) {
+        std::cerr << "Uso: ./pqbench cliente <socket> [--concurrencia=1,4,16] [--duracion=2]"
+                     " [--operacion=firma|verificacion|todas] [--tam=32]\n";
+        return 1;
+    }
+
+    const std::string& ruta = args.posicionales()[0];
+    std::vector<long> concurrencias = args.enteros("concurrencia", {1, 4, 16});
+    double duracion = args.real("duracion", 2.0);
+    std::string operacion = args.texto("operacion", "todas");
+    long tam = args.entero("tam", 32);
+
+    std::vector<TipoPeticion> tipos;
+    if(operacion == "firma" || operacion == "todas") tipos.push_back(TipoPeticion::FIRMAR);
+    if(operacion == "verificacion" || operacion == "todas") tipos.push_back(TipoPeticion::VERIFICAR);
+
+    if(tipos.empty() || duracion <= 0 || tam < 0 ||
+       std::any_of(concurrencias.begin(), concurrencias.end(), [](long c) { return c < 1; })) {
+        std::cerr << "Opciones inválidas para el modo cliente.\n";
+        return 1;
+    }
+
+    std::vector<uint8_t> mensaje(tam);
+    std::mt19937_64 aleatorio(0);
+    for(auto& b : mensaje) {
+        b = static_cast<uint8_t>(aleatorio());
+    }
+
+    ClienteServicio control(ruta);
+    std::vector<ClaveRemota> claves = control.listar();
+
+    int fallos = 0;
+    for(const auto& clave : claves) {
+        try {
+            /*
+            La firma que se usa en las verificaciones la hace el propio servidor y se
+            comprueba aquí con la clave pública que anuncia, para validar el servicio.
+            */
+            std::vector<uint8_t> contenido;
+            size_t pos = 0;
+            std::vector<uint8_t> firma;
+            if(control.pedir(TipoPeticion::FIRMAR, clave.indice, mensaje, {}, contenido, pos) == EstadoRespuesta::CORRECTA) {
+                auto campo = leer_campo(contenido, pos);
+                firma.assign(campo.begin(), campo.end());
+            }
+
+            auto esquema = crear_esquema(clave.conjunto);
+            auto pub_key = esquema->cargar_clave_publica(clave.clave_publica);
+            Botan::PK_Verifier verifier(*pub_key, esquema->padding_verificacion());
+            bool valida = verifier.verify_message(mensaje, firma);
+
+            std::string nombre = clave.conjunto.nombre + (clave.conjunto.prehash ? " (pre-hash)" : "");
+            if(!valida) {
+                std::cout << "[!] La firma de " << nombre << " hecha por el servidor no verifica\n";
+                ++fallos;
+            }
+
+            for(TipoPeticion tipo : tipos) {
+                // Cada firma XMSS gasta una hoja de la clave del servidor
+                if(tipo == TipoPeticion::FIRMAR && clave.conjunto.familia == Familia::XMSS) {
+                    std::cout << "[!] Las firmas de " << nombre << " consumen hojas de la clave del servidor\n";
+                }
+
+                std::cout << "SERVICIO DE " << nombre << " | operación: "
+                          << (tipo == TipoPeticion::FIRMAR ? "firma" : "verificacion") << " | " << duracion
+                          << " s por medición | mensaje de " << formatear_bytes(mensaje.size()) << "\n";
+
+                std::vector<ResultadoCliente> resultados;
+                for(long c : concurrencias) {
+                    resultados.push_back(generar_carga(ruta, clave, tipo, mensaje, firma, c, duracion));
+                    fallos += resultados.back().errores > 0;
+                }
+
+                imprimir_carga(resultados, std::cout);
+                std::cout << "\n";
+            }
+        } catch(const std::exception& e) {
+            std::cerr << "Excepción en cliente(" << clave.conjunto.nombre << "): " << e.what() << "\n";
+            ++fallos;
+        }
+    }
+
+    return fallos == 0 ? 0 : 1;
+}
+
+} // namespace pqbench
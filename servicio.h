@@ -0,0 +1,54 @@
+#ifndef PQBENCH_SERVICIO_H
+#define PQBENCH_SERVICIO_H
+
+#include "pqbench.h"
+
+/*
+Servicio local de firma sobre un socket Unix.
+
+El servidor guarda las claves de larga duración y sus PK_Signer y PK_Verifier ya
+construidos en un único proceso, y los clientes le piden firmas y verificaciones. Así se
+miden números de servicio (latencia de extremo a extremo y peticiones por segundo) en
+lugar de tiempos dentro del proceso.
+
+Cada trama va precedida de su longitud (u32). Los enteros van en little-endian, como en
+el resto de ficheros binarios de pqbench (binario.h):
+  Petición:  u8 tipo, u32 id, u16 clave, [u32 longitud + mensaje], [u32 longitud + firma]
+  Respuesta: u32 id, u8 estado, contenido
+El contenido de la respuesta depende del tipo: la firma (u32 longitud + firma) al firmar,
+nada al verificar y, al listar, u16 número de claves y por cada una u16 longitud + nombre
+del set, u8 pre-hash y u32 longitud + clave pública. Si el estado es ERROR el contenido
+es el mensaje de error (u32 longitud + texto).
+
+Las peticiones se agrupan por clave: cada clave tiene su cola y un solo hilo trabajador
+a la vez atiende hasta `lote` peticiones seguidas de esa clave con su firmador, así que
+los firmadores no se comparten entre hilos y una clave XMSS nunca firma dos veces a la
+vez con la misma hoja.
+*/
+
+namespace pqbench {
+
+enum class TipoPeticion : uint8_t { LISTAR = 0, FIRMAR = 1, VERIFICAR = 2 };
+enum class EstadoRespuesta : uint8_t { CORRECTA = 0, FIRMA_INVALIDA = 1, ERROR = 2 };
+
+// Longitud máxima de una trama, para no reservar lo que diga un cliente mal formado
+constexpr size_t TAM_MAXIMO_TRAMA = 64 * 1024 * 1024;
+
+// Envía o recibe una trama completa; devuelven false si la conexión se cierra o falla
+bool enviar_trama(int fd, std::span<const uint8_t> trama);
+bool recibir_trama(int fd, std::vector<uint8_t>& trama);
+
+/*
+Puntos de entrada de los modos desde la línea de comandos:
+  ./pqbench servidor <socket> <set|familia|todos>... [--hilos=nproc] [--lote=32] [--prehash]
+                     [--cache-claves[=d]] [--semilla=N]
+  ./pqbench cliente <socket> [--concurrencia=1,4,16] [--duracion=2]
+                    [--operacion=firma|verificacion|todas] [--tam=32]
+El servidor termina con SIGINT o SIGTERM.
+*/
+int ejecutar_servidor(const Argumentos& args);
+int ejecutar_cliente(const Argumentos& args);
+
+} // namespace pqbench
+
+#endif
@@ -0,0 +1,272 @@
+#include "throughput.h"
+
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace pqbench {
+
+std::string nombre_carga(Carga carga) {
+    switch(carga) {
+        case Carga::FIRMA: return "firma";
+        case Carga::VERIFICACION: return "verificacion";
+        case Carga::MIXTA: return "mixta";
+    }
+    return "";
+}
+
+ResultadoThroughput medir_throughput(const Esquema& esquema, const Botan::Private_Key& clave,
+                                     const std::vector<uint8_t>& firma, Carga carga,
+                                     size_t hilos, double duracion) {
+
+    const Botan::secure_vector<uint8_t>& msg = mensaje_fijo();
+    auto pub_key = clave.public_key();
+
+    std::atomic<size_t> listos{0};
+    std::atomic<bool> empezar{false};
+    std::atomic<bool> parar{false};
+    std::atomic<uint64_t> fallidas{0};
+
+    // Latencias de cada hilo, separadas por operación
+    std::vector<std::vector<double>> latencias_firma(hilos);
+    std::vector<std::vector<double>> latencias_verificacion(hilos);
+    std::vector<std::thread> trabajadores;
+    std::string error;
+    std::mutex mutex_error;
+
+    for(size_t h = 0; h < hilos; ++h) {
+        trabajadores.emplace_back([&, h] {
+            std::vector<double>& latencia_firma = latencias_firma[h];
+            std::vector<double>& latencia_verificacion = latencias_verificacion[h];
+
+            try {
+                // Cada hilo con su propio RNG, firmador y verificador
+                Botan::AutoSeeded_RNG rng;
+                Botan::PK_Signer signer(clave, rng, esquema.padding_firma());
+                Botan::PK_Verifier verifier(*pub_key, esquema.padding_verificacion());
+                if(carga != Carga::VERIFICACION) {
+                    latencia_firma.reserve(1 << 16);
+                }
+                if(carga != Carga::FIRMA) {
+                    latencia_verificacion.reserve(1 << 16);
+                }
+
+                // Todos los hilos empiezan a la vez, cuando ya están preparados
+                listos++;
+                while(!empezar.load()) {
+                    std::this_thread::yield();
+                }
+
+                bool toca_firmar = carga != Carga::VERIFICACION;
+                while(!parar.load(std::memory_order_relaxed)) {
+                    auto inicio = std::chrono::steady_clock::now();
+
+                    if(toca_firmar) {
+                        signer.update(msg.data(), msg.size());
+                        std::vector<uint8_t> signature = signer.signature(rng);
+                    } else {
+                        verifier.update(msg.data(), msg.size());
+                        if(!verifier.check_signature(firma.data(), firma.size())) {
+                            fallidas++;
+                        }
+                    }
+
+                    auto fin = std::chrono::steady_clock::now();
+                    (toca_firmar ? latencia_firma : latencia_verificacion).push_back(std::chrono::duration<double>(fin - inicio).count());
+
+                    // En la carga mixta se alterna firma y verificación
+                    if(carga == Carga::MIXTA) {
+                        toca_firmar = !toca_firmar;
+                    }
+                }
+            } catch(const std::exception& e) {
+                std::lock_guard<std::mutex> lock(mutex_error);
+                error = e.what();
+                listos++;
+            }
+        });
+    }
+
+    while(listos.load() < hilos) {
+        std::this_thread::yield();
+    }
+
+    auto inicio = std::chrono::steady_clock::now();
+    empezar = true;
+    std::this_thread::sleep_for(std::chrono::duration<double>(duracion));
+    parar = true;
+
+    for(auto& trabajador : trabajadores) {
+        trabajador.join();
+    }
+    auto fin = std::chrono::steady_clock::now();
+
+    if(!error.empty()) {
+        throw std::runtime_error("Error en un hilo de throughput: " + error);
+    }
+
+    // La duración incluye la última operación de cada hilo, que también se cuenta
+    ResultadoThroughput resultado;
+    resultado.hilos = hilos;
+    resultado.segundos = std::chrono::duration<double>(fin - inicio).count();
+    resultado.verificaciones_fallidas = fallidas.load();
+
+    auto agregar = [&](const std::vector<std::vector<double>>& latencias, LatenciaOperacion& destino) {
+        std::vector<double> todas;
+        for(const auto& latencia : latencias) {
+            resultado.operaciones += latencia.size();
+            destino.por_hilo.push_back(calcular_estadisticas(latencia));
+            todas.insert(todas.end(), latencia.begin(), latencia.end());
+        }
+        destino.total = calcular_estadisticas(std::move(todas));
+    };
+    agregar(latencias_firma, resultado.firma);
+    agregar(latencias_verificacion, resultado.verificacion);
+
+    resultado.ops_por_segundo = resultado.operaciones / resultado.segundos;
+    return resultado;
+}
+
+/*
+Imprime la curva de escalado: throughput, aceleración y eficiencia respecto a 1 hilo, y
+los percentiles de latencia de cada operación de la carga (en la mixta, firma y verificación).
+*/
+static void imprimir_escalado(const std::vector<ResultadoThroughput>& resultados, Carga carga, bool detalle, std::ostream& salida) {
+    std::vector<bool> operaciones;
+    if(carga != Carga::VERIFICACION) operaciones.push_back(true);
+    if(carga != Carga::FIRMA) operaciones.push_back(false);
+
+    salida << std::setw(6) << "Hilos" << std::setw(14) << "ops/s" << std::setw(13) << "Aceleración"
+           << std::setw(12) << "Eficiencia";
+    for(bool firma : operaciones) {
+        std::string op = firma ? "Firma" : "Verif.";
+        salida << std::setw(16) << op + " p50 (s)" << std::setw(16) << op + " p99 (s)"
+               << std::setw(21) << op + " p99 peor hilo";
+    }
+    salida << "  Curva de eficiencia\n";
+
+    double base = 0;
+    size_t hilos_base = 0;
+    for(const auto& r : resultados) {
+        // La referencia es la medición con menos hilos (normalmente 1)
+        if(hilos_base == 0) {
+            base = r.ops_por_segundo / r.hilos;
+            hilos_base = r.hilos;
+        }
+
+        double aceleracion = base > 0 ? r.ops_por_segundo / base : 0;
+        double eficiencia = aceleracion / r.hilos;
+
+        salida << std::setw(6) << r.hilos << std::setw(14) << std::fixed << std::setprecision(1) << r.ops_por_segundo
+               << std::setw(13) << std::setprecision(2) << aceleracion
+               << std::setw(11) << std::setprecision(1) << eficiencia * 100 << "%"
+               << std::defaultfloat << std::setprecision(6);
+
+        for(bool firma : operaciones) {
+            const LatenciaOperacion& latencia = firma ? r.firma : r.verificacion;
+            double peor_p99 = 0;
+            for(const auto& e : latencia.por_hilo) {
+                peor_p99 = std::max(peor_p99, e.p99);
+            }
+            salida << std::setw(16) << latencia.total.mediana << std::setw(16) << latencia.total.p99
+                   << std::setw(21) << peor_p99;
+        }
+        salida << "  " << std::string(static_cast<size_t>(std::clamp(eficiencia, 0.0, 1.0) * 40), '#') << "\n";
+
+        if(r.verificaciones_fallidas > 0) {
+            salida << "       [!] " << r.verificaciones_fallidas << " verificaciones fallidas\n";
+        }
+
+        if(detalle) {
+            for(size_t h = 0; h < r.hilos; ++h) {
+                for(bool firma : operaciones) {
+                    const auto& e = (firma ? r.firma : r.verificacion).por_hilo[h];
+                    salida << "         hilo " << h << (firma ? " firma: " : " verificación: ") << e.muestras
+                           << " ops | p50 " << e.mediana << " | p90 " << e.p90 << " | p99 " << e.p99
+                           << " | máx " << e.max << "\n";
+                }
+            }
+        }
+    }
+}
+
+int ejecutar_throughput(const Argumentos& args) {
+    if(args.posicionales().size() != 1) {
+        std::cerr << "Uso: ./pqbench throughput <set|familia|todos> [--hilos=1,2,4] [--duracion=s]"
+                     " [--carga=firma|verificacion|mixta|todas] [--detalle]\n";
+        return 1;
+    }
+
+    // Por defecto se barre de 1 hilo hasta el número de núcleos
+    std::vector<long> barrido;
+    for(long h = 1; h <= static_cast<long>(std::max(1u, std::thread::hardware_concurrency())); ++h) {
+        barrido.push_back(h);
+    }
+    std::vector<long> hilos = args.enteros("hilos", barrido);
+    double duracion = args.real("duracion", 2.0);
+    std::string nombre = args.texto("carga", "todas");
+    bool detalle = args.activa("detalle");
+
+    std::vector<Carga> cargas;
+    if(nombre == "firma" || nombre == "todas") cargas.push_back(Carga::FIRMA);
+    if(nombre == "verificacion" || nombre == "todas") cargas.push_back(Carga::VERIFICACION);
+    if(nombre == "mixta" || nombre == "todas") cargas.push_back(Carga::MIXTA);
+
+    if(cargas.empty() || duracion <= 0 || std::any_of(hilos.begin(), hilos.end(), [](long h) { return h < 1; })) {
+        std::cerr << "Opciones inválidas para el modo throughput.\n";
+        return 1;
+    }
+
+    std::vector<Conjunto> elegidos = seleccionar(args.posicionales()[0], args.activa("prehash"));
+    if(elegidos.empty()) {
+        std::cerr << "Set de parámetros inválido.\n";
+        return 1;
+    }
+
+    int fallos = 0;
+    for(const auto& conjunto : elegidos) {
+        /*
+        XMSS es un esquema con estado: varios hilos firmando con la misma clave tendrían
+        que repartirse las hojas, que no es lo que se quiere medir aquí.
+        */
+        if(conjunto.familia == Familia::XMSS && nombre != "verificacion") {
+            std::cout << "Se omite " << conjunto.nombre << ": XMSS sólo admite --carga=verificacion en este modo.\n\n";
+            continue;
+        }
+
+        try {
+            auto esquema = crear_esquema(conjunto);
+
+            // Clave y firma comunes a todos los hilos
+            Botan::AutoSeeded_RNG rng;
+            auto clave = esquema->generar_clave(rng);
+            Botan::PK_Signer signer(*clave, rng, esquema->padding_firma());
+            std::vector<uint8_t> firma = signer.sign_message(mensaje_fijo(), rng);
+
+            for(Carga carga : cargas) {
+                std::cout << "THROUGHPUT DE " << conjunto.nombre << (conjunto.prehash ? " (pre-hash)" : "")
+                          << " | carga: " << nombre_carga(carga) << " | " << duracion << " s por medición\n";
+
+                std::vector<ResultadoThroughput> resultados;
+                for(long h : hilos) {
+                    resultados.push_back(medir_throughput(*esquema, *clave, firma, carga, h, duracion));
+                    if(resultados.back().verificaciones_fallidas > 0) {
+                        ++fallos;
+                    }
+                }
+
+                imprimir_escalado(resultados, carga, detalle, std::cout);
+                std::cout << "\n";
+            }
+        } catch(const std::exception& e) {
+            std::cerr << "Excepción en throughput(" << conjunto.nombre << "): " << e.what() << "\n";
+            ++fallos;
+        }
+    }
+
+    return fallos == 0 ? 0 : 1;
+}
+
+} // namespace pqbench
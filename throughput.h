@@ -0,0 +1,58 @@
+#ifndef PQBENCH_THROUGHPUT_H
+#define PQBENCH_THROUGHPUT_H
+
+#include "pqbench.h"
+
+/*
+Modo throughput: firmas y verificaciones por segundo con varios hilos a la vez.
+
+Cada hilo tiene su propio RNG y su propio PK_Signer y PK_Verifier sobre la misma clave,
+como un servidor que firma y verifica en todos sus núcleos. Durante un tiempo fijo cada
+hilo repite la operación tantas veces como puede y se anota la latencia de cada una.
+*/
+
+namespace pqbench {
+
+// Operaciones que hace cada hilo
+enum class Carga { FIRMA, VERIFICACION, MIXTA };
+
+std::string nombre_carga(Carga carga);
+
+// Latencia de un tipo de operación (firma o verificación)
+struct LatenciaOperacion {
+    Estadisticas total;                 // De todas las operaciones de todos los hilos
+    std::vector<Estadisticas> por_hilo; // De las operaciones de cada hilo
+};
+
+/*
+Resultado de una medición con un número de hilos. En la carga mixta firma y verificación
+cuestan muy distinto, así que sus latencias se guardan por separado y no mezcladas.
+*/
+struct ResultadoThroughput {
+    size_t hilos = 0;
+    uint64_t operaciones = 0;
+    uint64_t verificaciones_fallidas = 0;
+    double segundos = 0;
+    double ops_por_segundo = 0;
+    LatenciaOperacion firma;
+    LatenciaOperacion verificacion;
+};
+
+/*
+Lanza `hilos` hilos que repiten la carga durante `duracion` segundos. Para las
+verificaciones se usa la firma del mensaje fijo que se pasa por parámetro.
+*/
+ResultadoThroughput medir_throughput(const Esquema& esquema, const Botan::Private_Key& clave,
+                                     const std::vector<uint8_t>& firma, Carga carga,
+                                     size_t hilos, double duracion);
+
+/*
+Punto de entrada del modo desde la línea de comandos:
+  ./pqbench throughput <set|familia|todos> [--hilos=1,2,4] [--duracion=s]
+                       [--carga=firma|verificacion|mixta|todas] [--detalle]
+*/
+int ejecutar_throughput(const Argumentos& args);
+
+} // namespace pqbench
+
+#endif